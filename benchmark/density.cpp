@@ -0,0 +1,99 @@
+#include <benchmark/benchmark.h>
+
+#include <muse_smc/samples/sample_density_grid.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+struct State
+{
+    double x   = 0.0;
+    double y   = 0.0;
+    double yaw = 0.0;
+};
+
+struct Sample
+{
+    using state_t     = State;
+    using allocator_t = std::allocator<Sample>;
+
+    state_t state;
+    double  weight = 1.0;
+};
+
+/**
+ * @brief Poses are binned by position and the point of the yaw on the unit circle.
+ */
+struct Vectorize
+{
+    inline Eigen::Vector4d operator()(const State &state) const
+    {
+        return Eigen::Vector4d(state.x, state.y, std::cos(state.yaw), std::sin(state.yaw));
+    }
+};
+
+using density_t = muse_smc::SampleDensityGrid<Sample, 4, Vectorize>;
+
+/**
+ * @brief Samples drawn around a few hypotheses, as after global localization.
+ */
+inline std::vector<Sample> draw(const std::size_t size,
+                                const std::size_t hypotheses)
+{
+    std::mt19937_64                        engine(0);
+    std::normal_distribution<double>       noise(0.0, 0.5);
+    std::uniform_real_distribution<double> weight(0.0, 1.0);
+
+    std::vector<Sample> samples(size);
+    for(std::size_t i = 0 ; i < size ; ++i) {
+        const double h = static_cast<double>(i % hypotheses);
+        samples[i].state.x   = 10.0 * h + noise(engine);
+        samples[i].state.y   =  5.0 * h + noise(engine);
+        samples[i].state.yaw = 0.5  * h + 0.2 * noise(engine);
+        samples[i].weight    = weight(engine);
+    }
+    return samples;
+}
+
+void clustering(benchmark::State &state)
+{
+    const std::size_t size    = static_cast<std::size_t>(state.range(0));
+    const std::size_t threads = static_cast<std::size_t>(state.range(1));
+
+    const std::vector<Sample> samples = draw(size, 8);
+    muse_smc::ThreadPool::Ptr thread_pool(threads > 1 ? new muse_smc::ThreadPool(threads) : nullptr);
+    density_t density(Eigen::Vector4d(0.25, 0.25, 0.2, 0.2), thread_pool);
+
+    for(auto _ : state) {
+        density.clear();
+        density.insertRange(samples.data(), samples.data() + samples.size());
+        density.estimate();
+        benchmark::DoNotOptimize(density.getClusters().data());
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * size));
+    state.counters["clusters"] = static_cast<double>(density.getClusters().size());
+    state.counters["cells"]    = static_cast<double>(density.histogramSize());
+}
+
+/**
+ * @brief N from 1e3 to 5e5 with 1 to 8 threads.
+ */
+void arguments(benchmark::internal::Benchmark *b)
+{
+    for(int64_t threads = 1 ; threads <= 8 ; threads *= 2) {
+        for(int64_t size = 1000 ; size < 1000000 ; size *= 10)
+            b->Args({size, threads});
+        b->Args({500000, threads});
+    }
+    b->ArgNames({"N", "threads"});
+    b->Unit(benchmark::kMillisecond);
+    b->UseRealTime();
+}
+}
+
+BENCHMARK(clustering)->Apply(arguments);
+
+BENCHMARK_MAIN();
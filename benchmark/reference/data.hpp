@@ -0,0 +1,99 @@
+#ifndef MUSE_SMC_REFERENCE_DATA_HPP
+#define MUSE_SMC_REFERENCE_DATA_HPP
+
+#include <cslibs_time/time_frame.hpp>
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+#include <memory>
+#include <vector>
+
+namespace muse_smc {
+namespace reference {
+/**
+ * @brief The Data class is the common base of all reference inputs.
+ */
+class Data
+{
+public:
+    using Ptr      = std::shared_ptr<Data>;
+    using ConstPtr = std::shared_ptr<Data const>;
+
+    inline Data(const cslibs_time::TimeFrame &time_frame,
+                const cslibs_time::Time      &stamp_received) :
+        time_frame_(time_frame),
+        stamp_received_(stamp_received)
+    {
+    }
+
+    virtual ~Data() = default;
+
+    inline const cslibs_time::TimeFrame & timeFrame() const
+    {
+        return time_frame_;
+    }
+
+    inline const cslibs_time::Time & stampReceived() const
+    {
+        return stamp_received_;
+    }
+
+    template<typename T>
+    T const & as() const
+    {
+        return dynamic_cast<const T&>(*this);
+    }
+
+private:
+    cslibs_time::TimeFrame time_frame_;
+    cslibs_time::Time      stamp_received_;
+};
+
+/**
+ * @brief The Tick class marks a time frame the constant velocity model is applied to.
+ */
+class Tick : public Data
+{
+public:
+    using Data::Data;
+};
+
+/**
+ * @brief The Beacons class holds range measurements to beacons at known positions.
+ */
+template<std::size_t Dim>
+class Beacons : public Data
+{
+public:
+    using point_t  = Eigen::Matrix<double, Dim, 1>;
+    using points_t = std::vector<point_t, Eigen::aligned_allocator<point_t>>;
+
+    inline Beacons(const cslibs_time::Time &stamp,
+                   const cslibs_time::Time &stamp_received,
+                   const points_t          &beacons,
+                   const std::vector<double> &ranges) :
+        Data(cslibs_time::TimeFrame(stamp, stamp), stamp_received),
+        beacons_(beacons),
+        ranges_(ranges)
+    {
+    }
+
+    inline const points_t & getBeacons() const
+    {
+        return beacons_;
+    }
+
+    inline const std::vector<double> & getRanges() const
+    {
+        return ranges_;
+    }
+
+private:
+    points_t            beacons_;
+    std::vector<double> ranges_;
+};
+}
+}
+
+#endif // MUSE_SMC_REFERENCE_DATA_HPP
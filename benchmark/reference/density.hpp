@@ -0,0 +1,78 @@
+#ifndef MUSE_SMC_REFERENCE_DENSITY_HPP
+#define MUSE_SMC_REFERENCE_DENSITY_HPP
+
+#include "state_space_description.hpp"
+
+#include <muse_smc/samples/sample_density.hpp>
+
+#include <unordered_set>
+#include <cmath>
+
+namespace muse_smc {
+namespace reference {
+/**
+ * @brief The Grid class counts occupied position cells for KLD sampling and estimates
+ *        the weighted mean of all samples.
+ */
+template<std::size_t Dim>
+class Grid : public SampleDensity<Sample<Dim>>
+{
+public:
+    using Ptr      = std::shared_ptr<Grid>;
+    using sample_t = Sample<Dim>;
+    using vector_t = typename State<Dim>::vector_t;
+
+    inline explicit Grid(const double resolution) :
+        inverse_resolution_(1.0 / resolution),
+        weight_sum_(0.0),
+        position_sum_(vector_t::Zero()),
+        mean_(vector_t::Zero())
+    {
+    }
+
+    virtual void clear() override
+    {
+        cells_.clear();
+        weight_sum_   = 0.0;
+        position_sum_ = vector_t::Zero();
+    }
+
+    virtual void insert(const sample_t &sample) override
+    {
+        std::size_t hash = 0;
+        for (std::size_t d = 0 ; d < Dim ; ++d) {
+            const long index = static_cast<long>(std::floor(sample.state.position(d) * inverse_resolution_));
+            hash = hash * 73856093u ^ static_cast<std::size_t>(index);
+        }
+        cells_.insert(hash);
+        weight_sum_   += sample.weight;
+        position_sum_ += sample.weight * sample.state.position;
+    }
+
+    virtual void estimate() override
+    {
+        if (weight_sum_ > 0.0)
+            mean_ = position_sum_ / weight_sum_;
+    }
+
+    virtual std::size_t histogramSize() const override
+    {
+        return cells_.size();
+    }
+
+    inline const vector_t & getMean() const
+    {
+        return mean_;
+    }
+
+private:
+    double                          inverse_resolution_;
+    std::unordered_set<std::size_t> cells_;
+    double                          weight_sum_;
+    vector_t                        position_sum_;
+    vector_t                        mean_;
+};
+}
+}
+
+#endif // MUSE_SMC_REFERENCE_DENSITY_HPP
@@ -0,0 +1,101 @@
+#ifndef MUSE_SMC_REFERENCE_PREDICTION_MODEL_HPP
+#define MUSE_SMC_REFERENCE_PREDICTION_MODEL_HPP
+
+#include "data.hpp"
+#include "state_space_description.hpp"
+
+#include <muse_smc/prediction/prediction_model.hpp>
+
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+namespace muse_smc {
+namespace reference {
+/**
+ * @brief The ConstantVelocity class propagates samples with their velocity, position
+ *        and velocity are disturbed by white noise scaled with the square root of the
+ *        time step. Noise is drawn from the streams of the state iteration, so the
+ *        model can be applied to partitions concurrently.
+ */
+template<std::size_t Dim>
+class ConstantVelocity : public PredictionModel<StateSpaceDescription<Dim>, Data>
+{
+public:
+    using Ptr    = std::shared_ptr<ConstantVelocity>;
+    using base_t = PredictionModel<StateSpaceDescription<Dim>, Data>;
+    using Result = typename base_t::Result;
+
+    inline ConstantVelocity(const double position_noise,
+                            const double velocity_noise) :
+        position_noise_(position_noise),
+        velocity_noise_(velocity_noise)
+    {
+    }
+
+    virtual typename Result::Ptr apply(const typename Data::ConstPtr                         &data,
+                                       const cslibs_time::Time                               &until,
+                                       typename base_t::sample_set_t::state_iterator_t        states) override
+    {
+        const cslibs_time::TimeFrame &frame = data->timeFrame();
+
+        /// split the tick, if it reaches beyond the requested time
+        typename Data::ConstPtr applied = data;
+        typename Data::ConstPtr left_to_apply;
+        if (until < frame.end) {
+            applied.reset(new Tick(cslibs_time::TimeFrame(frame.start, until), data->stampReceived()));
+            left_to_apply.reset(new Tick(cslibs_time::TimeFrame(until, frame.end), data->stampReceived()));
+        }
+
+        /// samples may have been extrapolated into the tick already
+        const cslibs_time::Time start = std::max(applied->timeFrame().start, states.getStamp());
+        propagate((applied->timeFrame().end - start).seconds(), states);
+
+        return typename Result::Ptr(new Result(applied, left_to_apply));
+    }
+
+    /**
+     * @brief Late ticks are bridged by moving on with the current velocities.
+     */
+    virtual typename Result::Ptr extrapolate(const typename Result::ConstPtr                 &last,
+                                             const cslibs_time::Time                         &until,
+                                             typename base_t::sample_set_t::state_iterator_t  states) override
+    {
+        const cslibs_time::Time &start = states.getStamp();
+        propagate((until - start).seconds(), states);
+
+        typename Data::ConstPtr applied(new Tick(cslibs_time::TimeFrame(start, until), last->applied->stampReceived()));
+        return typename Result::Ptr(new Result(applied));
+    }
+
+    virtual bool isPartitionable() const override
+    {
+        return true;
+    }
+
+private:
+    double position_noise_;
+    double velocity_noise_;
+
+    inline void propagate(const double                                     dt,
+                          typename base_t::sample_set_t::state_iterator_t &states) const
+    {
+        if (dt <= 0.0)
+            return;
+
+        const double sqrt_dt = std::sqrt(dt);
+        auto rng = states.getRandomEngine();
+        std::normal_distribution<double> position_noise(0.0, position_noise_ * sqrt_dt);
+        std::normal_distribution<double> velocity_noise(0.0, velocity_noise_ * sqrt_dt);
+        for (auto &s : states) {
+            for (std::size_t d = 0 ; d < Dim ; ++d) {
+                s.position(d) += s.velocity(d) * dt + position_noise(rng);
+                s.velocity(d) += velocity_noise(rng);
+            }
+        }
+    }
+};
+}
+}
+
+#endif // MUSE_SMC_REFERENCE_PREDICTION_MODEL_HPP
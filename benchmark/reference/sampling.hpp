@@ -0,0 +1,123 @@
+#ifndef MUSE_SMC_REFERENCE_SAMPLING_HPP
+#define MUSE_SMC_REFERENCE_SAMPLING_HPP
+
+#include "state_space_description.hpp"
+
+#include <muse_smc/sampling/uniform.hpp>
+#include <muse_smc/sampling/normal.hpp>
+
+#include <Eigen/Cholesky>
+
+#include <random>
+
+namespace muse_smc {
+namespace reference {
+/**
+ * @brief The Uniform class draws positions uniformly from a cube, velocities are
+ *        drawn uniformly up to a maximum speed per axis.
+ */
+template<std::size_t Dim>
+class Uniform : public UniformSampling<StateSpaceDescription<Dim>>
+{
+public:
+    using Ptr          = std::shared_ptr<Uniform>;
+    using base_t       = UniformSampling<StateSpaceDescription<Dim>>;
+    using sample_t     = Sample<Dim>;
+    using sample_set_t = typename base_t::sample_set_t;
+
+    inline Uniform(const double extent,
+                   const double speed,
+                   const std::uint64_t seed = 0) :
+        position_(-extent, extent),
+        velocity_(-speed, speed),
+        rng_(seed)
+    {
+    }
+
+    virtual bool apply(sample_set_t &sample_set) override
+    {
+        auto insertion = sample_set.getInsertion();
+        sample_t sample;
+        for (std::size_t i = 0 ; i < sample_set.getMaximumSampleSize() ; ++i) {
+            apply(sample);
+            insertion.insert(sample);
+        }
+        return true;
+    }
+
+    virtual void apply(sample_t &sample) override
+    {
+        for (std::size_t d = 0 ; d < Dim ; ++d) {
+            sample.state.position(d) = position_(rng_);
+            sample.state.velocity(d) = velocity_(rng_);
+        }
+    }
+
+    virtual bool update(const std::string &frame) override
+    {
+        return true;
+    }
+
+private:
+    std::uniform_real_distribution<double> position_;
+    std::uniform_real_distribution<double> velocity_;
+    std::mt19937_64                        rng_;
+};
+
+/**
+ * @brief The Normal class draws samples around a state, the covariance spans
+ *        position and velocity.
+ */
+template<std::size_t Dim>
+class Normal : public NormalSampling<StateSpaceDescription<Dim>>
+{
+public:
+    using Ptr          = std::shared_ptr<Normal>;
+    using base_t       = NormalSampling<StateSpaceDescription<Dim>>;
+    using sample_t     = Sample<Dim>;
+    using state_t      = State<Dim>;
+    using covariance_t = typename StateSpaceDescription<Dim>::covariance_t;
+    using sample_set_t = typename base_t::sample_set_t;
+    using vector_t     = Eigen::Matrix<double, 2 * Dim, 1>;
+
+    inline explicit Normal(const std::uint64_t seed = 0) :
+        rng_(seed)
+    {
+    }
+
+    virtual bool apply(const state_t      &state,
+                       const covariance_t &covariance,
+                       sample_set_t       &sample_set) override
+    {
+        Eigen::LLT<covariance_t> llt(covariance);
+        if (llt.info() != Eigen::Success)
+            return false;
+
+        const covariance_t l = llt.matrixL();
+        std::normal_distribution<double> normal(0.0, 1.0);
+        auto insertion = sample_set.getInsertion();
+        sample_t sample;
+        vector_t z;
+        for (std::size_t i = 0 ; i < sample_set.getMaximumSampleSize() ; ++i) {
+            for (std::size_t d = 0 ; d < 2 * Dim ; ++d)
+                z(d) = normal(rng_);
+            const vector_t x = l * z;
+            sample.state.position = state.position + x.template head<Dim>();
+            sample.state.velocity = state.velocity + x.template tail<Dim>();
+            insertion.insert(sample);
+        }
+        return true;
+    }
+
+    virtual bool update(const std::string &frame) override
+    {
+        return true;
+    }
+
+private:
+    std::mt19937_64 rng_;
+};
+}
+}
+
+#endif // MUSE_SMC_REFERENCE_SAMPLING_HPP
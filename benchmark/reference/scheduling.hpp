@@ -0,0 +1,132 @@
+#ifndef MUSE_SMC_REFERENCE_SCHEDULING_HPP
+#define MUSE_SMC_REFERENCE_SCHEDULING_HPP
+
+#include "data.hpp"
+#include "state_space_description.hpp"
+
+#include <muse_smc/scheduling/scheduler.hpp>
+#include <muse_smc/resampling/resampling.hpp>
+#include <muse_smc/resampling/impl/systematic.hpp>
+#include <muse_smc/prediction/prediction_integral.hpp>
+
+#include <iostream>
+
+namespace muse_smc {
+namespace reference {
+/**
+ * @brief The Immediate class applies every update, resampling is carried out once per
+ *        period of data time.
+ */
+template<std::size_t Dim>
+class Immediate : public Scheduler<StateSpaceDescription<Dim>, Data>
+{
+public:
+    using Ptr          = std::shared_ptr<Immediate>;
+    using base_t       = Scheduler<StateSpaceDescription<Dim>, Data>;
+    using update_t     = typename base_t::update_t;
+    using resampling_t = typename base_t::resampling_t;
+    using sample_set_t = typename base_t::sample_set_t;
+
+    inline explicit Immediate(const cslibs_time::Duration &resampling_period) :
+        resampling_period_(resampling_period)
+    {
+    }
+
+    virtual bool apply(typename update_t::Ptr     &u,
+                       typename sample_set_t::Ptr &s) override
+    {
+        u->apply(s->getWeightIterator());
+        return true;
+    }
+
+    virtual bool apply(typename resampling_t::Ptr &r,
+                       typename sample_set_t::Ptr &s) override
+    {
+        const cslibs_time::Time &stamp = s->getStamp();
+        if(resampling_time_.isZero())
+            resampling_time_ = stamp;
+        if(stamp < resampling_time_)
+            return false;
+
+        r->apply(*s);
+        resampling_time_ = stamp + resampling_period_;
+        return true;
+    }
+
+private:
+    cslibs_time::Duration resampling_period_;
+    cslibs_time::Time     resampling_time_;
+};
+
+/**
+ * @brief The Systematic class plugs systematic resampling into the filter.
+ */
+template<std::size_t Dim>
+class Systematic : public Resampling<StateSpaceDescription<Dim>>
+{
+public:
+    using Ptr          = std::shared_ptr<Systematic>;
+    using base_t       = Resampling<StateSpaceDescription<Dim>>;
+    using sample_set_t = typename base_t::sample_set_t;
+    using impl_t       = impl::Systematic<StateSpaceDescription<Dim>>;
+
+protected:
+    virtual void doApply(sample_set_t &sample_set) override
+    {
+        impl_t::apply(sample_set);
+    }
+
+    virtual void doApplyRecovery(sample_set_t &sample_set) override
+    {
+        impl_t::applyRecovery(this->uniform_pose_sampler_, this->recovery_random_pose_probability_, sample_set);
+    }
+};
+
+/**
+ * @brief The Elapsed class accumulates the data time samples were propagated, the
+ *        threshold is exceeded as soon as any prediction was applied.
+ */
+template<std::size_t Dim>
+class Elapsed : public PredictionIntegral<StateSpaceDescription<Dim>, Data>
+{
+public:
+    using Ptr    = std::shared_ptr<Elapsed>;
+    using base_t = PredictionIntegral<StateSpaceDescription<Dim>, Data>;
+
+    inline Elapsed() :
+        elapsed_(0.0)
+    {
+    }
+
+    virtual void add(const typename base_t::prediction_model_t::Result::ConstPtr &step) override
+    {
+        elapsed_ += step->applied->timeFrame().duration().seconds();
+    }
+
+    virtual void reset() override
+    {
+        elapsed_ = 0.0;
+    }
+
+    virtual bool thresholdExceeded() const override
+    {
+        return elapsed_ > 0.0;
+    }
+
+    virtual bool isZero() const override
+    {
+        return elapsed_ == 0.0;
+    }
+
+    virtual void info() const override
+    {
+        std::cout << "[Elapsed]: " << elapsed_ << "s" << "\n";
+    }
+
+private:
+    double elapsed_;
+};
+}
+}
+
+#endif // MUSE_SMC_REFERENCE_SCHEDULING_HPP
@@ -0,0 +1,80 @@
+#ifndef MUSE_SMC_REFERENCE_STATE_SPACE_DESCRIPTION_HPP
+#define MUSE_SMC_REFERENCE_STATE_SPACE_DESCRIPTION_HPP
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+#include <memory>
+
+namespace muse_smc {
+namespace reference {
+/**
+ * @brief Position and velocity in Dim dimensions.
+ */
+template<std::size_t Dim>
+struct State
+{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    using vector_t = Eigen::Matrix<double, Dim, 1>;
+
+    vector_t position;
+    vector_t velocity;
+
+    inline State() :
+        position(vector_t::Zero()),
+        velocity(vector_t::Zero())
+    {
+    }
+
+    inline State(const vector_t &position,
+                 const vector_t &velocity) :
+        position(position),
+        velocity(velocity)
+    {
+    }
+};
+
+template<std::size_t Dim>
+struct Sample
+{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    using state_t     = State<Dim>;
+    using allocator_t = Eigen::aligned_allocator<Sample>;
+
+    state_t state;
+    double  weight;
+
+    inline Sample() :
+        weight(1.0)
+    {
+    }
+
+    inline Sample(const state_t &state,
+                  const double   weight) :
+        state(state),
+        weight(weight)
+    {
+    }
+};
+
+/**
+ * @brief The StateSpaceDescription struct describes the reference problem, tracking
+ *        a constant velocity target in 2D or 3D by ranges to beacons.
+ */
+template<std::size_t Dim>
+struct StateSpaceDescription
+{
+    static constexpr std::size_t dimension = Dim;
+
+    using state_t                = State<Dim>;
+    using sample_t               = Sample<Dim>;
+    using covariance_t           = Eigen::Matrix<double, 2 * Dim, 2 * Dim>;
+    using transform_t            = Eigen::Matrix<double, Dim, 1>;
+    using state_space_boundary_t = Eigen::Matrix<double, Dim, 1>;
+};
+}
+}
+
+#endif // MUSE_SMC_REFERENCE_STATE_SPACE_DESCRIPTION_HPP
@@ -0,0 +1,100 @@
+#ifndef MUSE_SMC_REFERENCE_UPDATE_MODEL_HPP
+#define MUSE_SMC_REFERENCE_UPDATE_MODEL_HPP
+
+#include "data.hpp"
+#include "state_space_description.hpp"
+
+#include <muse_smc/update/update_model.hpp>
+
+#include <cmath>
+
+namespace muse_smc {
+namespace reference {
+/**
+ * @brief The GaussianBeacons class weights samples by the likelihood of the measured
+ *        ranges to all beacons, assuming Gaussian range noise.
+ */
+template<std::size_t Dim>
+class GaussianBeacons : public UpdateModel<StateSpaceDescription<Dim>, Data>
+{
+public:
+    using Ptr    = std::shared_ptr<GaussianBeacons>;
+    using base_t = UpdateModel<StateSpaceDescription<Dim>, Data>;
+
+    inline GaussianBeacons(const std::size_t id,
+                           const double      range_noise) :
+        id_(id),
+        inverse_variance_(1.0 / (range_noise * range_noise))
+    {
+    }
+
+    virtual std::size_t getId() const override
+    {
+        return id_;
+    }
+
+    virtual const std::string getName() const override
+    {
+        return "gaussian_beacons";
+    }
+
+    virtual void apply(const typename Data::ConstPtr                          &data,
+                       const typename base_t::state_space_t::ConstPtr         &state_space,
+                       typename base_t::sample_set_t::weight_iterator_t        weights) override
+    {
+        const Beacons<Dim> &beacons = data->as<Beacons<Dim>>();
+        const bool log_domain = weights.isLogDomain();
+        for (auto it = weights.begin() ; it != weights.end() ; ++it) {
+            const double log_likelihood = logLikelihood(beacons, it.state());
+            if (log_domain)
+                *it += log_likelihood;
+            else
+                *it *= std::exp(log_likelihood);
+        }
+    }
+
+    virtual bool isPartitionable() const override
+    {
+        return true;
+    }
+
+    virtual bool isFusable() const override
+    {
+        return true;
+    }
+
+    virtual double likelihood(const typename Data::ConstPtr                  &data,
+                              const typename base_t::state_space_t::ConstPtr &state_space,
+                              const typename base_t::state_t                 &state) const override
+    {
+        return std::exp(logLikelihood(data->as<Beacons<Dim>>(), state));
+    }
+
+    virtual double logLikelihood(const typename Data::ConstPtr                  &data,
+                                 const typename base_t::state_space_t::ConstPtr &state_space,
+                                 const typename base_t::state_t                 &state) const override
+    {
+        return logLikelihood(data->as<Beacons<Dim>>(), state);
+    }
+
+private:
+    std::size_t id_;
+    double      inverse_variance_;
+
+    inline double logLikelihood(const Beacons<Dim>             &beacons,
+                                const typename base_t::state_t &state) const
+    {
+        const auto &points = beacons.getBeacons();
+        const auto &ranges = beacons.getRanges();
+        double exponent = 0.0;
+        for (std::size_t i = 0 ; i < points.size() ; ++i) {
+            const double d = (points[i] - state.position).norm() - ranges[i];
+            exponent += d * d;
+        }
+        return -0.5 * exponent * inverse_variance_;
+    }
+};
+}
+}
+
+#endif // MUSE_SMC_REFERENCE_UPDATE_MODEL_HPP
@@ -0,0 +1,229 @@
+#include <benchmark/benchmark.h>
+
+#include <muse_smc/samples/sample_set.hpp>
+#include <muse_smc/sampling/uniform.hpp>
+#include <muse_smc/resampling/impl/multinomial.hpp>
+#include <muse_smc/resampling/impl/residual.hpp>
+#include <muse_smc/resampling/impl/stratified.hpp>
+#include <muse_smc/resampling/impl/systematic.hpp>
+#include <muse_smc/resampling/impl/wheel.hpp>
+#include <muse_smc/resampling/impl/alias.hpp>
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace {
+/**
+ * @brief Benchmark state, the id identifies the ancestor of a sample after resampling.
+ */
+struct State
+{
+    double      x   = 0.0;
+    double      y   = 0.0;
+    double      yaw = 0.0;
+    std::size_t id  = 0;
+};
+
+struct Sample
+{
+    using state_t     = State;
+    using allocator_t = std::allocator<Sample>;
+
+    state_t state;
+    double  weight = 1.0;
+
+    Sample() = default;
+    Sample(const state_t &state,
+           const double   weight) :
+        state(state),
+        weight(weight)
+    {
+    }
+};
+
+struct StateSpaceDescription
+{
+    using state_t                = State;
+    using sample_t               = Sample;
+    using covariance_t           = std::array<double, 9>;
+    using transform_t            = State;
+    using state_space_boundary_t = State;
+};
+
+using sample_set_t = muse_smc::SampleSet<StateSpaceDescription>;
+
+class Density : public muse_smc::SampleDensity<Sample>
+{
+public:
+    void clear() override {}
+    void insert(const Sample &) override {}
+    void estimate() override {}
+};
+
+class UniformSampling : public muse_smc::UniformSampling<StateSpaceDescription>
+{
+public:
+    bool apply(sample_set_t &) override
+    {
+        return false;
+    }
+
+    void apply(Sample &sample) override
+    {
+        sample.state.x   = rng_x_(engine_);
+        sample.state.y   = rng_x_(engine_);
+        sample.state.yaw = rng_yaw_(engine_);
+        sample.state.id  = std::numeric_limits<std::size_t>::max();
+    }
+
+    bool update(const std::string &) override
+    {
+        return true;
+    }
+
+private:
+    std::mt19937_64                        engine_{0};
+    std::uniform_real_distribution<double> rng_x_{-10.0, 10.0};
+    std::uniform_real_distribution<double> rng_yaw_{-M_PI, M_PI};
+};
+
+enum Weights {UNIFORM = 0, PEAKED = 1, DEGENERATE = 2};
+
+/**
+ * @brief Assign weights of the given distribution to the sample set, weights are normalized
+ *        when the iteration finishes.
+ */
+inline void assignWeights(sample_set_t &sample_set,
+                          const Weights weights)
+{
+    auto iteration = sample_set.getWeightIterator();
+    auto span      = iteration.span();
+    const double size  = static_cast<double>(span.size());
+    const double sigma = size / 100.0;
+    for(std::size_t i = 0 ; i < span.size() ; ++i) {
+        span.state(i).id = i;
+        switch(weights) {
+        case UNIFORM:
+            span.weight(i) = 1.0;
+            break;
+        case PEAKED: {
+            const double d = (static_cast<double>(i) - 0.5 * size) / sigma;
+            span.weight(i) = std::exp(-0.5 * d * d);
+        }   break;
+        case DEGENERATE:
+            span.weight(i) = i == span.size() / 2 ? 1.0 : 0.0;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Mean squared deviation of the offspring counts from their expectation N w_i.
+ */
+inline double offspringVariance(const std::vector<double> &weights,
+                                const sample_set_t        &sample_set)
+{
+    const std::size_t size = weights.size();
+    std::vector<double> offspring(size, 0.0);
+    const auto &samples = sample_set.getSamples();
+    for(std::size_t i = 0 ; i < samples.size() ; ++i) {
+        const std::size_t id = samples.state(i).id;
+        if(id < size)
+            offspring[id] += 1.0;
+    }
+
+    double variance = 0.0;
+    for(std::size_t i = 0 ; i < size ; ++i) {
+        const double d = offspring[i] - weights[i] * static_cast<double>(size);
+        variance += d * d;
+    }
+    return variance / static_cast<double>(size);
+}
+
+template<typename resampling_t, bool recovery>
+void resampling(benchmark::State &state)
+{
+    const std::size_t size    = static_cast<std::size_t>(state.range(0));
+    const Weights     weights = static_cast<Weights>(state.range(1));
+
+    sample_set_t sample_set("world", cslibs_time::Time(), size, std::make_shared<Density>());
+    {
+        auto insertion = sample_set.getInsertion();
+        for(std::size_t i = 0 ; i < size ; ++i)
+            insertion.insert(Sample());
+    }
+    UniformSampling::Ptr uniform(new UniformSampling);
+
+    std::vector<double> normalized(size);
+    double variance = 0.0;
+    for(auto _ : state) {
+        state.PauseTiming();
+        assignWeights(sample_set, weights);
+        for(std::size_t i = 0 ; i < size ; ++i)
+            normalized[i] = sample_set.getSamples().weight(i);
+        state.ResumeTiming();
+
+        if(recovery)
+            resampling_t::applyRecovery(uniform, 0.05, sample_set);
+        else
+            resampling_t::apply(sample_set);
+
+        state.PauseTiming();
+        variance += offspringVariance(normalized, sample_set);
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * size));
+    state.counters["time_per_particle"] = benchmark::Counter(static_cast<double>(size),
+                                                             benchmark::Counter::kIsIterationInvariantRate |
+                                                             benchmark::Counter::kInvert);
+    state.counters["offspring_variance"] = variance / static_cast<double>(state.iterations());
+}
+
+/**
+ * @brief N from 1e3 to 1e7 for uniform, peaked and degenerate weights.
+ */
+void argumentsLimited(benchmark::internal::Benchmark *b,
+                      const int64_t                   degenerate_limit)
+{
+    for(int weights = UNIFORM ; weights <= DEGENERATE ; ++weights) {
+        const int64_t limit = weights == DEGENERATE ? degenerate_limit : 10000000;
+        for(int64_t size = 1000 ; size <= limit ; size *= 10)
+            b->Args({size, weights});
+    }
+    b->ArgNames({"N", "weights"});
+    b->Unit(benchmark::kMillisecond);
+}
+
+void arguments(benchmark::internal::Benchmark *b)
+{
+    argumentsLimited(b, 10000000);
+}
+
+/**
+ * @brief The wheel is quadratic for degenerate weights, larger N would not terminate in time.
+ */
+void argumentsWheel(benchmark::internal::Benchmark *b)
+{
+    argumentsLimited(b, 10000);
+}
+}
+
+using namespace muse_smc::impl;
+
+BENCHMARK_TEMPLATE(resampling, Multinomial<StateSpaceDescription>, false)->Apply(arguments);
+BENCHMARK_TEMPLATE(resampling, Multinomial<StateSpaceDescription>, true)->Apply(arguments);
+BENCHMARK_TEMPLATE(resampling, Residual<StateSpaceDescription>, false)->Apply(arguments);
+BENCHMARK_TEMPLATE(resampling, Residual<StateSpaceDescription>, true)->Apply(arguments);
+BENCHMARK_TEMPLATE(resampling, Stratified<StateSpaceDescription>, false)->Apply(arguments);
+BENCHMARK_TEMPLATE(resampling, Stratified<StateSpaceDescription>, true)->Apply(arguments);
+BENCHMARK_TEMPLATE(resampling, Systematic<StateSpaceDescription>, false)->Apply(arguments);
+BENCHMARK_TEMPLATE(resampling, Systematic<StateSpaceDescription>, true)->Apply(arguments);
+BENCHMARK_TEMPLATE(resampling, WheelOfFortune<StateSpaceDescription>, false)->Apply(argumentsWheel);
+BENCHMARK_TEMPLATE(resampling, WheelOfFortune<StateSpaceDescription>, true)->Apply(argumentsWheel);
+BENCHMARK_TEMPLATE(resampling, Alias<StateSpaceDescription>, false)->Apply(arguments);
+BENCHMARK_TEMPLATE(resampling, Alias<StateSpaceDescription>, true)->Apply(arguments);
+
+BENCHMARK_MAIN();
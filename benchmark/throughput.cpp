@@ -0,0 +1,406 @@
+/// PROJECT
+#include <muse_smc/smc/smc.hpp>
+#include <muse_smc/utility/trace_export.hpp>
+
+#include "reference/data.hpp"
+#include "reference/state_space_description.hpp"
+#include "reference/prediction_model.hpp"
+#include "reference/update_model.hpp"
+#include "reference/sampling.hpp"
+#include "reference/density.hpp"
+#include "reference/scheduling.hpp"
+
+/// SYSTEM
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * End to end throughput of the filter on the reference problem. A producer thread
+ * feeds constant velocity ticks and beacon ranges of a simulated target at fixed
+ * rates, inputs are stamped with the wall clock at the time they are produced. The
+ * latency is measured from the moment an input is received up to the publication of
+ * the sample set stamped with it.
+ *
+ * Every update period, each sensor delivers beacon ranges with the same stamp, these
+ * are weighted in a single pass if fusion is enabled. Ticks can be delivered late, to
+ * measure the effect of a bounded prediction wait. The publisher can keep the snapshot
+ * published last, like a consumer reading it on another thread, the filter then copies
+ * the samples while predicting and weighting. The filter events recorded last can be
+ * written as Chrome trace.
+ *
+ *  throughput [--particles N] [--dimension 2|3] [--prediction-rate Hz]
+ *             [--update-rate Hz] [--duration s] [--threads T] [--beacons B]
+ *             [--sensors S] [--fuse 0|1] [--prediction-lag ms]
+ *             [--prediction-timeout ms] [--async-density 0|1]
+ *             [--hold-snapshot 0|1] [--trace path]
+ */
+
+namespace {
+struct Options
+{
+    std::size_t particles       = 10000;
+    std::size_t dimension       = 2;
+    double      prediction_rate = 100.0;
+    double      update_rate     = 20.0;
+    double      duration        = 10.0;
+    std::size_t threads         = 1;
+    std::size_t beacons         = 4;
+    std::size_t sensors         = 1;
+    bool        fuse            = false;
+    double      prediction_lag     = 0.0;
+    double      prediction_timeout = 0.0;
+    bool        async_density   = false;
+    bool        hold_snapshot   = false;
+    std::string trace;
+};
+
+inline bool parse(int argc, char *argv[], Options &options)
+{
+    for(int i = 1 ; i < argc ; i += 2) {
+        if(i + 1 >= argc)
+            return false;
+
+        const std::string key   = argv[i];
+        const char       *value = argv[i + 1];
+        if(key == "--particles")
+            options.particles = std::strtoul(value, nullptr, 10);
+        else if(key == "--dimension")
+            options.dimension = std::strtoul(value, nullptr, 10);
+        else if(key == "--prediction-rate")
+            options.prediction_rate = std::atof(value);
+        else if(key == "--update-rate")
+            options.update_rate = std::atof(value);
+        else if(key == "--duration")
+            options.duration = std::atof(value);
+        else if(key == "--threads")
+            options.threads = std::strtoul(value, nullptr, 10);
+        else if(key == "--beacons")
+            options.beacons = std::strtoul(value, nullptr, 10);
+        else if(key == "--sensors")
+            options.sensors = std::strtoul(value, nullptr, 10);
+        else if(key == "--fuse")
+            options.fuse = std::atoi(value) != 0;
+        else if(key == "--prediction-lag")
+            options.prediction_lag = std::atof(value);
+        else if(key == "--prediction-timeout")
+            options.prediction_timeout = std::atof(value);
+        else if(key == "--async-density")
+            options.async_density = std::atoi(value) != 0;
+        else if(key == "--hold-snapshot")
+            options.hold_snapshot = std::atoi(value) != 0;
+        else if(key == "--trace")
+            options.trace = value;
+        else
+            return false;
+    }
+    return options.particles > 0 &&
+           (options.dimension == 2 || options.dimension == 3) &&
+           options.prediction_rate > 0.0 &&
+           options.update_rate > 0.0 &&
+           options.duration > 0.0 &&
+           options.threads > 0 &&
+           options.beacons > 0 &&
+           options.sensors > 0 &&
+           options.prediction_lag >= 0.0 &&
+           options.prediction_timeout >= 0.0;
+}
+
+/**
+ * @brief The Latency class records the time from reception to publication of every
+ *        published sample set, optionally it keeps the snapshot published last.
+ */
+template<std::size_t Dim>
+class Latency : public muse_smc::SMCState<muse_smc::reference::StateSpaceDescription<Dim>>
+{
+public:
+    using Ptr          = std::shared_ptr<Latency>;
+    using base_t       = muse_smc::SMCState<muse_smc::reference::StateSpaceDescription<Dim>>;
+    using sample_set_t = typename base_t::sample_set_t;
+    using snapshot_t   = typename base_t::snapshot_t;
+
+    inline explicit Latency(const bool hold_snapshot) :
+        hold_snapshot_(hold_snapshot)
+    {
+    }
+
+    virtual void publishSnapshot(const typename sample_set_t::ConstPtr &sample_set,
+                                 const snapshot_t                      &snapshot) override
+    {
+        hold(snapshot);
+        record(sample_set);
+    }
+
+    virtual void publishIntermediateSnapshot(const typename sample_set_t::ConstPtr &sample_set,
+                                             const snapshot_t                      &snapshot) override
+    {
+        hold(snapshot);
+        record(sample_set);
+    }
+
+    virtual void publishConstantSnapshot(const typename sample_set_t::ConstPtr &sample_set,
+                                         const snapshot_t                      &snapshot) override
+    {
+        hold(snapshot);
+        record(sample_set);
+    }
+
+    virtual void publish(const typename sample_set_t::ConstPtr &sample_set) override
+    {
+        record(sample_set);
+    }
+
+    virtual void publishIntermediate(const typename sample_set_t::ConstPtr &sample_set) override
+    {
+        record(sample_set);
+    }
+
+    virtual void publishConstant(const typename sample_set_t::ConstPtr &sample_set) override
+    {
+        record(sample_set);
+    }
+
+    inline std::vector<double> getLatencies() const
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+        return latencies_;
+    }
+
+private:
+    bool                hold_snapshot_;
+    snapshot_t          snapshot_;
+    mutable std::mutex  mutex_;
+    std::vector<double> latencies_;
+
+    inline void hold(const snapshot_t &snapshot)
+    {
+        if(hold_snapshot_)
+            snapshot_ = snapshot;
+    }
+
+    inline void record(const typename sample_set_t::ConstPtr &sample_set)
+    {
+        /// inputs are stamped on reception, the sample set carries the stamp of the last input
+        const double latency = (cslibs_time::Time::now() - sample_set->getStamp()).seconds();
+        std::unique_lock<std::mutex> l(mutex_);
+        latencies_.emplace_back(latency);
+    }
+};
+
+inline double percentile(std::vector<double> &values,
+                         const double         p)
+{
+    if(values.empty())
+        return 0.0;
+    const std::size_t n = std::min(values.size() - 1,
+                                   static_cast<std::size_t>(p * static_cast<double>(values.size())));
+    std::nth_element(values.begin(), values.begin() + n, values.end());
+    return values[n];
+}
+
+template<std::size_t Dim>
+int run(const Options &options)
+{
+    using namespace muse_smc::reference;
+    using description_t = StateSpaceDescription<Dim>;
+    using smc_t         = muse_smc::SMC<description_t, Data>;
+    using sample_set_t  = muse_smc::SampleSet<description_t>;
+    using prediction_t  = typename smc_t::prediction_t;
+    using update_t      = typename smc_t::update_t;
+    using vector_t      = typename State<Dim>::vector_t;
+    using beacons_t     = Beacons<Dim>;
+
+    const double extent      = 10.0;
+    const double speed       = 1.0;
+    const double range_noise = 0.1;
+
+    const cslibs_time::Time start = cslibs_time::Time::now();
+
+    typename sample_set_t::Ptr sample_set(new sample_set_t("world", start, options.particles,
+                                                           std::make_shared<Grid<Dim>>(0.5)));
+    if(options.threads > 1)
+        sample_set->setThreadPool(std::make_shared<muse_smc::ThreadPool>(options.threads));
+    sample_set->setAsynchronousDensity(options.async_density);
+
+    typename Uniform<Dim>::Ptr    uniform(new Uniform<Dim>(extent, speed, 1));
+    typename Normal<Dim>::Ptr     normal(new Normal<Dim>(2));
+    typename Systematic<Dim>::Ptr resampling(new Systematic<Dim>);
+    resampling->setup(uniform, normal);
+    typename Latency<Dim>::Ptr    latency(new Latency<Dim>(options.hold_snapshot));
+    typename smc_t::prediction_integrals_t::Ptr integrals(new typename smc_t::prediction_integrals_t(std::make_shared<Elapsed<Dim>>()));
+    std::vector<typename GaussianBeacons<Dim>::Ptr> update_models;
+    for(std::size_t i = 0 ; i < options.sensors ; ++i) {
+        integrals->set(std::make_shared<Elapsed<Dim>>(), i);
+        update_models.emplace_back(new GaussianBeacons<Dim>(i, range_noise));
+    }
+    typename Immediate<Dim>::Ptr  scheduler(new Immediate<Dim>(cslibs_time::Duration(1.0 / options.update_rate)));
+
+    typename ConstantVelocity<Dim>::Ptr prediction_model(new ConstantVelocity<Dim>(0.05, 0.1));
+
+    smc_t smc;
+    smc.setup(sample_set, uniform, normal, resampling, latency, integrals, scheduler, false, false, false, options.fuse);
+    smc.setPredictionTimeout(cslibs_time::Duration(options.prediction_timeout * 1e-3));
+    muse_smc::Trace::Ptr trace;
+    if(!options.trace.empty()) {
+        trace.reset(new muse_smc::Trace);
+        for(std::size_t s = 0 ; s < options.sensors ; ++s)
+            trace->setName(s, "beacons_" + std::to_string(s));
+        smc.setTrace(trace);
+    }
+    smc.requestUniformInitialization(start);
+
+    /// simulated target and beacons
+    std::mt19937_64 rng(3);
+    std::uniform_real_distribution<double> position(-extent, extent);
+    std::normal_distribution<double>       noise(0.0, range_noise);
+    typename beacons_t::points_t beacons(options.beacons);
+    for(auto &b : beacons)
+        for(std::size_t d = 0 ; d < Dim ; ++d)
+            b(d) = position(rng);
+    vector_t target_position = vector_t::Zero();
+    vector_t target_velocity = vector_t::Constant(speed / std::sqrt(static_cast<double>(Dim)));
+
+    const std::clock_t cpu_start = std::clock();
+    smc.start();
+
+    const cslibs_time::Duration prediction_period(1.0 / options.prediction_rate);
+    const cslibs_time::Duration update_period(1.0 / options.update_rate);
+    const cslibs_time::Time     end = start + cslibs_time::Duration(options.duration);
+    cslibs_time::Time next_prediction = start + prediction_period;
+    cslibs_time::Time next_update     = start + update_period;
+    cslibs_time::Time last_tick       = start;
+    std::size_t       updates         = 0;
+
+    /// ticks are held back by the prediction lag
+    const cslibs_time::Duration prediction_lag(options.prediction_lag * 1e-3);
+    std::deque<std::pair<cslibs_time::Time, typename prediction_t::Ptr>> late;
+    auto release = [&](const cslibs_time::Time &now) {
+        while(!late.empty() && late.front().first <= now) {
+            smc.addPrediction(late.front().second);
+            late.pop_front();
+        }
+    };
+
+    auto tick = [&](const cslibs_time::Time &now) {
+        const double dt = (now - last_tick).seconds();
+        target_position += target_velocity * dt;
+        for(std::size_t d = 0 ; d < Dim ; ++d) {
+            if(std::abs(target_position(d)) > extent)
+                target_velocity(d) = -target_velocity(d);
+        }
+        Data::ConstPtr data(new Tick(cslibs_time::TimeFrame(last_tick, now), now));
+        late.emplace_back(now + prediction_lag, typename prediction_t::Ptr(new prediction_t(data, prediction_model)));
+        release(now);
+        last_tick = now;
+    };
+
+    cslibs_time::Time now = start;
+    while(now < end) {
+        cslibs_time::Time next = std::min(next_prediction, next_update);
+        if(!late.empty())
+            next = std::min(next, late.front().first);
+        std::this_thread::sleep_for(std::chrono::nanoseconds(std::max<int64_t>(0, (next - cslibs_time::Time::now()).nanoseconds())));
+        now = cslibs_time::Time::now();
+        release(now);
+
+        if(now >= next_prediction) {
+            tick(now);
+            next_prediction = now + prediction_period;
+        }
+        if(now >= next_update) {
+            /// predictions have to cover the update stamp
+            if(last_tick < now)
+                tick(now);
+
+            for(const auto &update_model : update_models) {
+                std::vector<double> ranges(beacons.size());
+                for(std::size_t i = 0 ; i < beacons.size() ; ++i)
+                    ranges[i] = (beacons[i] - target_position).norm() + noise(rng);
+                Data::ConstPtr data(new beacons_t(now, now, beacons, ranges));
+                smc.addUpdate(typename update_t::Ptr(new update_t(data, nullptr, update_model)));
+            }
+            next_update = now + update_period;
+            ++updates;
+        }
+    }
+
+    /// a final tick lets pending updates pass the prediction step
+    tick(cslibs_time::Time::now() + cslibs_time::Duration(1.0));
+    for(const auto &l : late)
+        smc.addPrediction(l.second);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    smc.end();
+
+    const double wall = (cslibs_time::Time::now() - start).seconds();
+    const double cpu  = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+
+    std::vector<double> latencies = latency->getLatencies();
+    const std::size_t published = latencies.size();
+    const double p50 = percentile(latencies, 0.50);
+    const double p99 = percentile(latencies, 0.99);
+
+    std::cout << "particles     " << options.particles                     << "\n"
+              << "dimension     " << Dim                                   << "\n"
+              << "threads       " << options.threads                       << "\n"
+              << "sensors       " << options.sensors                       << "\n"
+              << "fuse          " << options.fuse                          << "\n"
+              << "updates       " << updates                               << "\n"
+              << "published     " << published                             << "\n"
+              << "updates/s     " << static_cast<double>(published) / wall << "\n"
+              << "latency p50   " << p50 * 1e3 << " ms"                    << "\n"
+              << "latency p99   " << p99 * 1e3 << " ms"                    << "\n"
+              << "cpu           " << 100.0 * cpu / wall << " %"            << "\n";
+
+    const typename smc_t::PredictionStatistics statistics = smc.getPredictionStatistics();
+    std::cout << "waits         " << statistics.waits                      << "\n"
+              << "timeouts      " << statistics.timeouts                   << "\n"
+              << "extrapolated  " << statistics.extrapolations             << "\n"
+              << "deferred      " << statistics.deferrals                  << "\n"
+              << "dropped late  " << statistics.drops                      << "\n";
+
+    const typename smc_t::metrics_t metrics = smc.getMetrics();
+    auto stage = [](const char *name, const muse_smc::Histogram::Snapshot &h) {
+        std::cout << name << h.count << " x, p50 " << h.percentile(0.50) * 1e-3
+                  << " us, p99 " << h.percentile(0.99) * 1e-3 << " us" << "\n";
+    };
+    stage("predict       ", metrics.predict);
+    stage("update        ", metrics.update);
+    stage("resampling    ", metrics.resampling);
+    stage("density       ", metrics.density);
+    stage("publication   ", metrics.publication);
+    std::cout << "dropped       " << metrics.dropped_predictions << " predictions, "
+              << metrics.dropped_updates << " updates" << "\n"
+              << "re-emplaced   " << metrics.reemplaced_updates << "\n";
+
+    if(trace) {
+        std::ofstream out(options.trace);
+        muse_smc::trace_export::writeChromeTrace(out, trace->dump(), trace->getNames());
+    }
+    return 0;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if(!parse(argc, argv, options)) {
+        std::cerr << "usage: " << argv[0]
+                  << " [--particles N] [--dimension 2|3] [--prediction-rate Hz] [--update-rate Hz]"
+                  << " [--duration s] [--threads T] [--beacons B] [--sensors S] [--fuse 0|1]"
+                  << " [--prediction-lag ms] [--prediction-timeout ms] [--async-density 0|1]"
+                  << " [--hold-snapshot 0|1] [--trace path]" << "\n";
+        return 1;
+    }
+
+    return options.dimension == 2 ? run<2>(options) : run<3>(options);
+}
@@ -77,9 +77,24 @@ public:
     inline typename predition_model_t::Result::Ptr apply(const cslibs_time::Time  &until,
                                                          typename sample_set_t::state_iterator_t states)
     {
-        return state_space_ ?
-                    model_->apply(data_, state_space_, until, states) :
-                    model_->apply(data_, until, states);
+        if(model_->isPartitionable()) {
+            /// partitions are processed the same way with or without threads
+            auto partitions = states.partition(model_->getPartitionSize());
+            std::vector<typename predition_model_t::Result::Ptr> results(partitions.size());
+            auto apply_partition = [this, &until, &partitions, &results](const std::size_t i) {
+                results[i] = doApply(until, partitions[i]);
+            };
+
+            const ThreadPool::Ptr &thread_pool = states.getThreadPool();
+            if(thread_pool && thread_pool->size() > 1) {
+                thread_pool->parallelFor(partitions.size(), apply_partition);
+            } else {
+                for(std::size_t i = 0 ; i < partitions.size() ; ++i)
+                    apply_partition(i);
+            }
+            return results.front();
+        }
+        return doApply(until, states);
     }
 
     inline const cslibs_time::Time& getStamp() const
@@ -111,6 +126,14 @@ private:
     typename data_t::ConstPtr        data_;
     typename state_space_t::ConstPtr state_space_;
     typename predition_model_t::Ptr  model_;
+
+    inline typename predition_model_t::Result::Ptr doApply(const cslibs_time::Time                  &until,
+                                                           typename sample_set_t::state_iterator_t   states)
+    {
+        return state_space_ ?
+                    model_->apply(data_, state_space_, until, states) :
+                    model_->apply(data_, until, states);
+    }
 };
 }
 
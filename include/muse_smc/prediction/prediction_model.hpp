@@ -70,6 +70,47 @@ public:
     {
         return apply(data, until, states);
     }
+
+    /**
+     * @brief Called if the next prediction did not arrive in time, see SMC::setPredictionTimeout.
+     *        The model may propagate the samples up to a time based on the result it
+     *        produced last. An unsuccessful result defers the pending update instead, which
+     *        is the default.
+     *        The samples are stamped with until afterwards and extrapolated motion is not
+     *        corrected. Late predictions ending before until are dropped, the others are
+     *        applied with the stamp of the states inside their time frame, apply should then
+     *        only propagate from that stamp on.
+     * @param last      - the result of the prediction applied last
+     * @param until     - the time to extrapolate to
+     * @param states    - the samples to propagate
+     * @return the result of the extrapolation
+     */
+    virtual typename Result::Ptr extrapolate(const typename Result::ConstPtr          &last,
+                                             const cslibs_time::Time                  &until,
+                                             typename sample_set_t::state_iterator_t   states)
+    {
+        return typename Result::Ptr(new Result);
+    }
+
+    /**
+     * @brief If true, apply may be called concurrently on partitions of the sample
+     *        set. Noise has to be drawn from the random stream of the state iteration
+     *        passed (StateIteration::getRandomEngine), so that results are reproducible.
+     *        The result of the first partition is taken as result of the prediction.
+     */
+    virtual bool isPartitionable() const
+    {
+        return false;
+    }
+
+    /**
+     * @brief The amount of samples per partition. Partitions are independent of the
+     *        amount of threads, which keeps random streams reproducible.
+     */
+    virtual std::size_t getPartitionSize() const
+    {
+        return 4096;
+    }
 };
 }
 
@@ -0,0 +1,182 @@
+#ifndef ALIAS_HPP
+#define ALIAS_HPP
+
+#include <muse_smc/samples/sample_set.hpp>
+#include <muse_smc/sampling/uniform.hpp>
+#include <cslibs_math/random/random.hpp>
+
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+namespace muse_smc {
+namespace impl {
+/**
+ * @brief The AliasTable class implements Vose's alias method. The table is built
+ *        in O(N), afterwards each draw takes O(1) independent of the weight
+ *        distribution.
+ */
+class AliasTable
+{
+public:
+    AliasTable() = default;
+
+    /**
+     * @brief Build the table from the weights of a sample storage.
+     * @param data  - the samples
+     */
+    template<typename sample_storage_t>
+    inline void build(const sample_storage_t &data)
+    {
+        const std::size_t size = data.size();
+        probability_.resize(size);
+        alias_.resize(size);
+        small_.clear();
+        large_.clear();
+        if(size == 0)
+            return;
+
+        double sum = 0.0;
+        for(std::size_t i = 0 ; i < size ; ++i)
+            sum += data.weight(i);
+
+        const double scale = static_cast<double>(size) / sum;
+        for(std::size_t i = 0 ; i < size ; ++i) {
+            const double p = data.weight(i) * scale;
+            probability_[i] = p;
+            alias_[i] = i;
+            (p < 1.0 ? small_ : large_).push_back(i);
+        }
+
+        while(!small_.empty() && !large_.empty()) {
+            const std::size_t s = small_.back();
+            const std::size_t l = large_.back();
+            small_.pop_back();
+            large_.pop_back();
+
+            alias_[s] = l;
+            probability_[l] = (probability_[l] + probability_[s]) - 1.0;
+            (probability_[l] < 1.0 ? small_ : large_).push_back(l);
+        }
+
+        /// remaining entries only differ from 1 by rounding errors
+        for(const std::size_t l : large_)
+            probability_[l] = 1.0;
+        for(const std::size_t s : small_)
+            probability_[s] = 1.0;
+    }
+
+    /**
+     * @brief Draw an index, a single uniform number selects the column and decides
+     *        between the column and its alias.
+     * @param u     - uniform random number in [0, 1)
+     * @return the drawn index
+     */
+    inline std::size_t draw(const double u) const
+    {
+        const std::size_t size = probability_.size();
+        const double      x    = u * static_cast<double>(size);
+        const std::size_t i    = std::min(static_cast<std::size_t>(x), size - 1);
+        return (x - static_cast<double>(i)) < probability_[i] ? i : alias_[i];
+    }
+
+    inline std::size_t size() const
+    {
+        return probability_.size();
+    }
+
+private:
+    std::vector<double>      probability_;
+    std::vector<std::size_t> alias_;
+    std::vector<std::size_t> small_;
+    std::vector<std::size_t> large_;
+};
+
+template<typename state_space_description_t>
+class Alias
+{
+public:
+    using sample_t            = typename state_space_description_t::sample_t;
+    using sample_set_t        = SampleSet<state_space_description_t>;
+    using uniform_sampling_t  = UniformSampling<state_space_description_t>;
+
+    inline static void apply(sample_set_t &sample_set)
+    {
+        apply(sample_set, sample_set.getSampleSize());
+    }
+
+    /**
+     * @brief Resample a different amount of samples, the amount is limited to the
+     *        minimum and maximum sample size of the set.
+     * @param sample_set    - the sample set to resample
+     * @param sample_size   - the amount of samples to draw
+     */
+    inline static void apply(sample_set_t &sample_set,
+                             const std::size_t sample_size)
+    {
+        const typename sample_set_t::sample_vector_t &p_t_1 = sample_set.getSamples();
+        const std::size_t size = clamp(sample_set, sample_size);
+        assert(p_t_1.size() != 0);
+
+        AliasTable table;
+        table.build(p_t_1);
+
+        typename sample_set_t::sample_insertion_t i_p_t = sample_set.getInsertion();
+        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
+        for(std::size_t i = 0 ; i < size ; ++i) {
+            i_p_t.insert(p_t_1, table.draw(rng.get()));
+        }
+    }
+
+    inline static void applyRecovery(typename uniform_sampling_t::Ptr uniform_pose_sampler,
+                                     const double recovery_random_pose_probability,
+                                     sample_set_t &sample_set)
+    {
+        applyRecovery(uniform_pose_sampler, recovery_random_pose_probability, sample_set, sample_set.getSampleSize());
+    }
+
+    inline static void applyRecovery(typename uniform_sampling_t::Ptr uniform_pose_sampler,
+                                     const double recovery_random_pose_probability,
+                                     sample_set_t &sample_set,
+                                     const std::size_t sample_size)
+    {
+        if(!uniform_pose_sampler->update(sample_set.getFrame())) {
+            std::cerr << "[Alias]: Updating uniform sampler didn't work, switching to normal resampling!" << "\n";
+            apply(sample_set, sample_size);
+            return;
+        }
+
+        const typename sample_set_t::sample_vector_t &p_t_1 = sample_set.getSamples();
+        const std::size_t size = clamp(sample_set, sample_size);
+
+        AliasTable table;
+        table.build(p_t_1);
+
+        typename sample_set_t::sample_insertion_t i_p_t = sample_set.getInsertion();
+        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
+        cslibs_math::random::Uniform<double,1> rng_recovery(0.0, 1.0, sample_set.getResamplingSeed());
+        sample_t sample;
+        for(std::size_t i = 0 ; i < size ; ++i) {
+            const double recovery_probability = rng_recovery.get();
+            if(recovery_probability < recovery_random_pose_probability) {
+                uniform_pose_sampler->apply(sample);
+                sample.weight = recovery_probability;
+                i_p_t.insert(sample);
+            } else {
+                i_p_t.insert(p_t_1, table.draw(rng.get()));
+            }
+        }
+    }
+
+private:
+    inline static std::size_t clamp(const sample_set_t &sample_set,
+                                    const std::size_t   sample_size)
+    {
+        return std::max(sample_set.getMinimumSampleSize(),
+                        std::min(sample_set.getMaximumSampleSize(), sample_size));
+    }
+};
+}
+}
+
+#endif // ALIAS_HPP
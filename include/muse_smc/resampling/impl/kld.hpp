@@ -0,0 +1,76 @@
+#ifndef KLD_HPP
+#define KLD_HPP
+
+#include <muse_smc/samples/sample_set.hpp>
+#include <muse_smc/sampling/uniform.hpp>
+#include <muse_smc/resampling/impl/alias.hpp>
+#include <cslibs_math/random/random.hpp>
+
+#include <iostream>
+
+namespace muse_smc {
+namespace impl {
+/**
+ * @brief The KLD class implements KLD sampling. Samples are drawn from an alias table
+ *        until the sample size bound of the sample set is met. The bound is derived from
+ *        the histogram bins the density occupies while samples are inserted and clamped
+ *        to the minimum and maximum sample size, see SampleSet::setKLD.
+ */
+template<typename state_space_description_t>
+class KLD
+{
+public:
+    using sample_t            = typename state_space_description_t::sample_t;
+    using sample_set_t        = SampleSet<state_space_description_t>;
+    using uniform_sampling_t  = UniformSampling<state_space_description_t>;
+
+    inline static void apply(sample_set_t &sample_set)
+    {
+        const typename sample_set_t::sample_vector_t &p_t_1 = sample_set.getSamples();
+        assert(p_t_1.size() != 0);
+
+        AliasTable table;
+        table.build(p_t_1);
+
+        typename sample_set_t::sample_insertion_t i_p_t = sample_set.getInsertion();
+        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
+        for(std::size_t i = 0 ; i < sample_set.getKLDSampleSize() ; ++i) {
+            i_p_t.insert(p_t_1, table.draw(rng.get()));
+        }
+    }
+
+    inline static void applyRecovery(typename uniform_sampling_t::Ptr uniform_pose_sampler,
+                                     const double recovery_random_pose_probability,
+                                     sample_set_t &sample_set)
+    {
+        if(!uniform_pose_sampler->update(sample_set.getFrame())) {
+            std::cerr << "[KLD]: Updating uniform sampler didn't work, switching to normal resampling!" << "\n";
+            apply(sample_set);
+            return;
+        }
+
+        const typename sample_set_t::sample_vector_t &p_t_1 = sample_set.getSamples();
+
+        AliasTable table;
+        table.build(p_t_1);
+
+        typename sample_set_t::sample_insertion_t i_p_t = sample_set.getInsertion();
+        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
+        cslibs_math::random::Uniform<double,1> rng_recovery(0.0, 1.0, sample_set.getResamplingSeed());
+        sample_t sample;
+        for(std::size_t i = 0 ; i < sample_set.getKLDSampleSize() ; ++i) {
+            const double recovery_probability = rng_recovery.get();
+            if(recovery_probability < recovery_random_pose_probability) {
+                uniform_pose_sampler->apply(sample);
+                sample.weight = recovery_probability;
+                i_p_t.insert(sample);
+            } else {
+                i_p_t.insert(p_t_1, table.draw(rng.get()));
+            }
+        }
+    }
+};
+}
+}
+
+#endif // KLD_HPP
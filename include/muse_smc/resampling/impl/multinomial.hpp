@@ -5,6 +5,8 @@
 #include <cslibs_math/random/random.hpp>
 #include <cslibs_math/sampling/uniform.hpp>
 
+#include <iostream>
+
 namespace muse_smc {
 namespace impl {
 template<typename state_space_description_t>
@@ -17,14 +19,14 @@ public:
 
     inline static void apply(sample_set_t &sample_set)
     {
-        const sample_set_t::sample_vector_t &p_t_1 = sample_set.getSamples();
+        const typename sample_set_t::sample_vector_t &p_t_1 = sample_set.getSamples();
         const std::size_t size = p_t_1.size();
         assert(size != 0);
 
-        sample_set_t::sample_insertion_t i_p_t = sample_set.getInsertion();
+        typename sample_set_t::sample_insertion_t i_p_t = sample_set.getInsertion();
 
         /// prepare ordered sequence of random numbers
-        cslibs_math::random::Uniform<1> rng(0.0, 1.0);
+        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
         std::vector<double> u(size, std::pow(rng.get(), 1.0 / static_cast<double>(size)));
         {
 
@@ -35,9 +37,9 @@ public:
         }
         /// draw samples
         {
-            auto p_t_1_it  = p_t_1.begin();
+            std::size_t index = 0;
             double cumsum_last = 0.0;
-            double cumsum = p_t_1_it->weight_;
+            double cumsum = p_t_1.weight(index);
 
             auto in_range = [&cumsum, &cumsum_last] (double u)
             {
@@ -47,11 +49,11 @@ public:
 
             for(auto &u_r : u) {
                 while(!in_range(u_r)) {
-                    ++p_t_1_it;
+                    ++index;
                     cumsum_last = cumsum;
-                    cumsum += p_t_1_it->weight_;
+                    cumsum += p_t_1.weight(index);
                 }
-                i_p_t.insert(*p_t_1_it);
+                i_p_t.insert(p_t_1, index);
             }
         }
     }
@@ -66,12 +68,12 @@ public:
             return;
         }
 
-        const sample_set_t::sample_vector_t &p_t_1 = sample_set.getSamples();
-        sample_set_t::sample_insertion_t i_p_t = sample_set.getInsertion();
+        const typename sample_set_t::sample_vector_t &p_t_1 = sample_set.getSamples();
+        typename sample_set_t::sample_insertion_t i_p_t = sample_set.getInsertion();
 
         /// prepare ordered sequence of random numbers
         const std::size_t size = p_t_1.size();
-        cslibs_math::random::Uniform<1> rng(0.0, 1.0);
+        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
         std::vector<double> u(size, std::pow(rng.get(), 1.0 / static_cast<double>(size)));
         {
             for(std::size_t k = size - 1 ; k > 0 ; --k) {
@@ -81,10 +83,10 @@ public:
         }
         /// draw samples
         {
-            cslibs_math::random::Uniform<1> rng_recovery(0.0, 1.0);
-            auto p_t_1_it  = p_t_1.begin();
+            cslibs_math::random::Uniform<double,1> rng_recovery(0.0, 1.0, sample_set.getResamplingSeed());
+            std::size_t index = 0;
             double cumsum_last = 0.0;
-            double cumsum = p_t_1_it->weight_;
+            double cumsum = p_t_1.weight(index);
 
             auto in_range = [&cumsum, &cumsum_last] (double u)
             {
@@ -94,18 +96,18 @@ public:
             sample_t sample;
             for(auto &u_r : u) {
                 while(!in_range(u_r)) {
-                    ++p_t_1_it;
+                    ++index;
                     cumsum_last = cumsum;
-                    cumsum += p_t_1_it->weight_;
+                    cumsum += p_t_1.weight(index);
                 }
                 const double recovery_probability = rng_recovery.get();
                 if(recovery_probability < recovery_random_pose_probability) {
                     uniform_pose_sampler->apply(sample);
-                    sample.weight_ = recovery_probability;
+                    sample.weight = recovery_probability;
+                    i_p_t.insert(sample);
                 } else {
-                    sample.pose_ = p_t_1_it->pose_;
+                    i_p_t.insert(p_t_1, index);
                 }
-                i_p_t.insert(sample);
             }
         }
     }
@@ -0,0 +1,52 @@
+#ifndef OFFSPRING_HPP
+#define OFFSPRING_HPP
+
+#include <muse_smc/samples/sample_set.hpp>
+
+#include <vector>
+
+namespace muse_smc {
+namespace impl {
+/**
+ * @brief The Offspring class carries out resampling schemes drawing an ordered
+ *        sequence of uniform numbers in ancestor mode. Only offspring counts are
+ *        determined, the sample set is then rebuilt by an in-place permutation
+ *        instead of copying every sample into the insertion buffer.
+ */
+template<typename state_space_description_t>
+class Offspring
+{
+public:
+    using sample_set_t = SampleSet<state_space_description_t>;
+
+    /**
+     * @brief Resample the sample set in place.
+     * @param sample_set    - the sample set
+     * @param draw          - draw(j) returns the j-th uniform number in [0, 1),
+     *                        the sequence has to be non-decreasing in j
+     */
+    template<typename draw_t>
+    inline static void apply(sample_set_t &sample_set,
+                             const draw_t &draw)
+    {
+        const typename sample_set_t::sample_vector_t &p_t_1 = sample_set.getSamples();
+        const std::size_t size = p_t_1.size();
+
+        std::vector<std::size_t> offspring(size, 0);
+        std::size_t index = 0;
+        double cumsum = p_t_1.weight(index);
+        for(std::size_t j = 0 ; j < size ; ++j) {
+            const double u = draw(j);
+            while(u >= cumsum && index + 1 < size) {
+                ++index;
+                cumsum += p_t_1.weight(index);
+            }
+            ++offspring[index];
+        }
+        sample_set.permute(offspring);
+    }
+};
+}
+}
+
+#endif // OFFSPRING_HPP
@@ -0,0 +1,123 @@
+#ifndef PREFIX_SUM_HPP
+#define PREFIX_SUM_HPP
+
+#include <muse_smc/samples/sample_set.hpp>
+#include <muse_smc/utility/thread_pool.hpp>
+#include <muse_smc/utility/random_seed.hpp>
+
+#include <vector>
+#include <random>
+#include <algorithm>
+
+namespace muse_smc {
+namespace impl {
+/**
+ * @brief The PrefixSum class carries out resampling schemes drawing an ordered
+ *        sequence of uniform numbers in parallel. The cumulative sum of weights is
+ *        computed blockwise, the output range is split into blocks of a fixed size and
+ *        each block finds its first ancestor by binary search. Every block writes into
+ *        its own region of the insertion buffer and commits it, so that weight statistics
+ *        and estimation run inside the parallel region. The sample set merges them in order.
+ *        Blocks and their random streams do not depend on the amount of threads, therefore
+ *        results are identical for any thread pool.
+ */
+template<typename state_space_description_t>
+class PrefixSum
+{
+public:
+    using sample_set_t    = SampleSet<state_space_description_t>;
+    using random_engine_t = std::mt19937_64;
+
+    /**
+     * @brief Sample sets below this size are resampled serially.
+     */
+    inline static std::size_t minimumSampleSize()
+    {
+        return 16384;
+    }
+
+    /**
+     * @brief The amount of samples per block, the unit of work and of random streams.
+     */
+    inline static std::size_t blockSize()
+    {
+        return 4096;
+    }
+
+    /**
+     * @brief True if the sample set has a thread pool and is large enough.
+     */
+    inline static bool enabled(const sample_set_t &sample_set)
+    {
+        const ThreadPool::Ptr &thread_pool = sample_set.getThreadPool();
+        return thread_pool &&
+               thread_pool->size() > 1 &&
+               sample_set.getSampleSize() >= minimumSampleSize();
+    }
+
+    /**
+     * @brief Resample the sample set in parallel.
+     * @param sample_set    - the sample set
+     * @param draw          - draw(j, rng) returns the j-th uniform number in [0, 1),
+     *                        the sequence has to be non-decreasing in j
+     */
+    template<typename draw_t>
+    inline static void apply(sample_set_t &sample_set,
+                             const draw_t &draw)
+    {
+        ThreadPool &thread_pool = *sample_set.getThreadPool();
+        const typename sample_set_t::sample_vector_t &p_t_1 = sample_set.getSamples();
+        const std::size_t size  = p_t_1.size();
+        const std::size_t parts = (size + blockSize() - 1) / blockSize();
+        auto block = [size](const std::size_t i) {
+            return std::min(size, i * blockSize());
+        };
+
+        /// blockwise cumulative sum, block offsets are scanned serially
+        std::vector<double> cumsum(size);
+        std::vector<double> offsets(parts + 1, 0.0);
+        thread_pool.parallelFor(parts, [&p_t_1, &cumsum, &offsets, &block](const std::size_t t) {
+            double sum = 0.0;
+            for(std::size_t i = block(t) ; i < block(t + 1) ; ++i) {
+                sum += p_t_1.weight(i);
+                cumsum[i] = sum;
+            }
+            offsets[t + 1] = sum;
+        });
+        for(std::size_t t = 1 ; t <= parts ; ++t)
+            offsets[t] += offsets[t - 1];
+        thread_pool.parallelFor(parts, [&cumsum, &offsets, &block](const std::size_t t) {
+            const double offset = offsets[t];
+            for(std::size_t i = block(t) ; i < block(t + 1) ; ++i)
+                cumsum[i] += offset;
+        });
+
+        /// draw samples, each block covers a contiguous range of the output
+        typename sample_set_t::sample_insertion_t i_p_t = sample_set.getInsertion();
+        const std::size_t   insertion_offset = i_p_t.extend(size, parts);
+        const std::uint64_t seed             = sample_set.getResamplingSeed();
+        thread_pool.parallelFor(parts, [&](const std::size_t t) {
+            const std::size_t begin = block(t);
+            const std::size_t end   = block(t + 1);
+            if(begin == end)
+                return;
+
+            random_engine_t rng(random_seed::derive(seed, t));
+            double u = draw(begin, rng);
+            std::size_t index = static_cast<std::size_t>(std::upper_bound(cumsum.begin(), cumsum.end(), u) - cumsum.begin());
+            for(std::size_t j = begin ; j < end ; ++j) {
+                if(j != begin) {
+                    u = draw(j, rng);
+                    while(index < size && cumsum[index] <= u)
+                        ++index;
+                }
+                i_p_t.assign(insertion_offset + j, p_t_1, std::min(index, size - 1));
+            }
+            i_p_t.commit(t, insertion_offset + begin, insertion_offset + end);
+        });
+    }
+};
+}
+}
+
+#endif // PREFIX_SUM_HPP
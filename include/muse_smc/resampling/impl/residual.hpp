@@ -30,25 +30,25 @@ public:
         double              n_w_residual = 0.0;
         std::size_t         i_p_t_size = 0;
         {
-            cslibs_math::random::Uniform<double,1> rng(0.0, 1.0);
+            cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
             double u_static = rng.get();
             for(std::size_t i = 0 ; i < size ; ++i) {
-                const auto &sample = p_t_1[i];
+                const double weight = p_t_1.weight(i);
                 u[i] = (i + u_static) / size;
-                std::size_t copies = std::floor(sample.weight * size);
+                std::size_t copies = std::floor(weight * size);
 
-                w_residual[i] = size * sample.weight - copies;
+                w_residual[i] = size * weight - copies;
                 n_w_residual += w_residual[i];
 
-                for(std::size_t i = 0 ; i < copies && i_p_t_size < size ;
-                    ++i ,++i_p_t_size) {
-                    i_p_t.insert(sample);
+                for(std::size_t j = 0 ; j < copies && i_p_t_size < size ;
+                    ++j ,++i_p_t_size) {
+                    i_p_t.insert(p_t_1, i);
                 }
             }
         }
         {
             auto u_it = u.begin();
-            auto p_t_1_it = p_t_1.begin();
+            std::size_t index = 0;
             auto w_it = w_residual.begin();
 
             double cumsum_last = 0.0;
@@ -60,12 +60,12 @@ public:
 
             for(std::size_t i = i_p_t_size ; i < size ; ++i) {
                 while(!in_range(*u_it)) {
-                    ++p_t_1_it;
+                    ++index;
                     ++w_it;
                     cumsum_last = cumsum;
                     cumsum += *w_it / n_w_residual;
                 }
-                i_p_t.insert(*p_t_1_it);
+                i_p_t.insert(p_t_1, index);
                 ++u_it;
             }
         }
@@ -85,7 +85,7 @@ public:
         const typename sample_set_t::sample_vector_t &p_t_1 = sample_set.getSamples();
         typename sample_set_t::sample_insertion_t i_p_t = sample_set.getInsertion();
 
-        cslibs_math::random::Uniform<double,1> rng_recovery(0.0, 1.0);
+        cslibs_math::random::Uniform<double,1> rng_recovery(0.0, 1.0, sample_set.getResamplingSeed());
 
         const std::size_t size = p_t_1.size();
         std::vector<double> u(size);
@@ -93,33 +93,33 @@ public:
         double              n_w_residual = 0.0;
         std::size_t         i_p_t_size = 0;
         {
-            cslibs_math::random::Uniform<double,1> rng(0.0, 1.0);
+            cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
             double u_static = rng.get();
             for(std::size_t i = 0 ; i < size ; ++i) {
-                const auto &sample_p_t_1 = p_t_1[i];
+                const double weight = p_t_1.weight(i);
                 u[i] = (i + u_static) / size;
-                std::size_t copies = std::floor(sample_p_t_1.weight * size);
+                std::size_t copies = std::floor(weight * size);
 
-                w_residual[i] = size * sample_p_t_1.weight - copies;
+                w_residual[i] = size * weight - copies;
                 n_w_residual += w_residual[i];
 
                 sample_t sample;
-                for(std::size_t i = 0 ; i < copies && i_p_t_size < size ;
-                    ++i ,++i_p_t_size) {
+                for(std::size_t j = 0 ; j < copies && i_p_t_size < size ;
+                    ++j ,++i_p_t_size) {
                     const double recovery_probability = rng_recovery.get();
                     if(recovery_probability < recovery_random_pose_probability) {
                         uniform_pose_sampler->apply(sample);
                         sample.weight = recovery_probability;
                         i_p_t.insert(sample);
                     } else {
-                        i_p_t.insert(sample);
+                        i_p_t.insert(p_t_1, i);
                     }
                 }
             }
         }
         {
             auto u_it = u.begin();
-            auto p_t_1_it = p_t_1.begin();
+            std::size_t index = 0;
             auto w_it = w_residual.begin();
 
             double cumsum_last = 0.0;
@@ -132,7 +132,7 @@ public:
             sample_t sample;
             for(std::size_t i = i_p_t_size ; i < size ; ++i) {
                 while(!in_range(*u_it)) {
-                    ++p_t_1_it;
+                    ++index;
                     ++w_it;
                     cumsum_last = cumsum;
                     cumsum += *w_it / n_w_residual;
@@ -144,7 +144,7 @@ public:
                     sample.weight = recovery_probability;
                     i_p_t.insert(sample);
                 } else {
-                    i_p_t.insert(*p_t_1_it);
+                    i_p_t.insert(p_t_1, index);
                 }
                 ++u_it;
             }
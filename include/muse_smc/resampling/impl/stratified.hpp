@@ -2,6 +2,8 @@
 #define STRATIFIED_HPP
 
 #include <muse_smc/samples/sample_set.hpp>
+#include <muse_smc/resampling/impl/prefix_sum.hpp>
+#include <muse_smc/resampling/impl/offspring.hpp>
 #include <cslibs_math/random/random.hpp>
 #include <muse_smc/sampling/uniform.hpp>
 
@@ -24,9 +26,16 @@ public:
         const std::size_t size = p_t_1.size();
         assert(size != 0);
 
+        if(PrefixSum<state_space_description_t>::enabled(sample_set)) {
+            PrefixSum<state_space_description_t>::apply(sample_set, [size](const std::size_t i, std::mt19937_64 &rng) {
+                return (i + std::uniform_real_distribution<double>(0.0, 1.0)(rng)) / size;
+            });
+            return;
+        }
+
         typename sample_set_t::sample_insertion_t  i_p_t = sample_set.getInsertion();
         /// prepare ordered sequence of random numbers
-        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0);
+        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
         std::vector<double> u(size);
         {
 
@@ -36,9 +45,9 @@ public:
         }
         /// draw samples
         {
-            auto p_t_1_it = p_t_1.begin();
+            std::size_t index = 0;
             double cumsum_last = 0.0;
-            double cumsum = p_t_1_it->weight;
+            double cumsum = p_t_1.weight(index);
 
             auto in_range = [&cumsum, &cumsum_last] (double u)
             {
@@ -48,15 +57,30 @@ public:
 
             for(auto &u_r : u) {
                 while(!in_range(u_r)) {
-                    ++p_t_1_it;
+                    ++index;
                     cumsum_last = cumsum;
-                    cumsum += p_t_1_it->weight;
+                    cumsum += p_t_1.weight(index);
                 }
-                i_p_t.insert(*p_t_1_it);
+                i_p_t.insert(p_t_1, index);
             }
         }
     }
 
+    /**
+     * @brief Ancestor mode, only offspring counts are drawn and the sample set
+     *        is rebuilt in place.
+     */
+    inline static void applyInPlace(sample_set_t &sample_set)
+    {
+        const std::size_t size = sample_set.getSampleSize();
+        assert(size != 0);
+
+        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
+        Offspring<state_space_description_t>::apply(sample_set, [&rng, size](const std::size_t i) {
+            return (i + rng.get()) / size;
+        });
+    }
+
     inline static  void applyRecovery(typename uniform_sampling_t::Ptr uniform_pose_sampler,
                                       const double recovery_random_pose_probability,
                                       sample_set_t &sample_set)
@@ -73,7 +97,7 @@ public:
         const std::size_t size = p_t_1.size();
 
         /// prepare ordered sequence of random numbers
-        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0);
+        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
         std::vector<double> u(size);
         {
 
@@ -83,10 +107,10 @@ public:
         }
         /// draw samples
         {
-            cslibs_math::random::Uniform<double,1> rng_recovery(0.0, 1.0);
-            auto p_t_1_it = p_t_1.begin();
+            cslibs_math::random::Uniform<double,1> rng_recovery(0.0, 1.0, sample_set.getResamplingSeed());
+            std::size_t index = 0;
             double cumsum_last = 0.0;
-            double cumsum = p_t_1_it->weight;
+            double cumsum = p_t_1.weight(index);
 
             auto in_range = [&cumsum, &cumsum_last] (double u)
             {
@@ -97,9 +121,9 @@ public:
 
             for(auto &u_r : u) {
                 while(!in_range(u_r)) {
-                    ++p_t_1_it;
+                    ++index;
                     cumsum_last = cumsum;
-                    cumsum += p_t_1_it->weight;
+                    cumsum += p_t_1.weight(index);
                 }
                 const double recovery_probability = rng_recovery.get();
                 if(recovery_probability < recovery_random_pose_probability) {
@@ -107,7 +131,7 @@ public:
                     sample.weight = recovery_probability;
                     i_p_t.insert(sample);
                 } else {
-                    i_p_t.insert(*p_t_1_it);
+                    i_p_t.insert(p_t_1, index);
                 }
             }
         }
@@ -4,6 +4,8 @@
 #include <iostream>
 
 #include <muse_smc/samples/sample_set.hpp>
+#include <muse_smc/resampling/impl/prefix_sum.hpp>
+#include <muse_smc/resampling/impl/offspring.hpp>
 #include <muse_smc/sampling/uniform.hpp>
 #include <cslibs_math/random/random.hpp>
 
@@ -23,12 +25,21 @@ public:
         const std::size_t size = p_t_1.size();
         assert(size != 0);
 
+        if(PrefixSum<state_space_description_t>::enabled(sample_set)) {
+            cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
+            const double u_static = rng.get();
+            PrefixSum<state_space_description_t>::apply(sample_set, [u_static, size](const std::size_t i, std::mt19937_64 &) {
+                return (i + u_static) / size;
+            });
+            return;
+        }
+
         typename sample_set_t::sample_insertion_t i_p_t = sample_set.getInsertion();
 
         /// prepare ordered sequence of random numbers
         std::vector<double> u(size);
         {
-            cslibs_math::random::Uniform<double,1> rng(0.0, 1.0);
+            cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
             double u_static = rng.get();
 
             for(std::size_t i = 0 ; i < size ; ++i) {
@@ -37,9 +48,9 @@ public:
         }
         /// draw samples
         {
-            auto p_t_1_it = p_t_1.begin();
+            std::size_t index = 0;
             double cumsum_last = 0.0;
-            double cumsum = p_t_1_it->weight;
+            double cumsum = p_t_1.weight(index);
 
             auto in_range = [&cumsum, &cumsum_last] (double u)
             {
@@ -49,15 +60,31 @@ public:
 
             for(auto &u_r : u) {
                 while(!in_range(u_r)) {
-                    ++p_t_1_it;
+                    ++index;
                     cumsum_last = cumsum;
-                    cumsum += p_t_1_it->weight;
+                    cumsum += p_t_1.weight(index);
                 }
-                i_p_t.insert(*p_t_1_it);
+                i_p_t.insert(p_t_1, index);
             }
         }
     }
 
+    /**
+     * @brief Ancestor mode, only offspring counts are drawn and the sample set
+     *        is rebuilt in place.
+     */
+    inline static void applyInPlace(sample_set_t &sample_set)
+    {
+        const std::size_t size = sample_set.getSampleSize();
+        assert(size != 0);
+
+        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
+        const double u_static = rng.get();
+        Offspring<state_space_description_t>::apply(sample_set, [u_static, size](const std::size_t i) {
+            return (i + u_static) / size;
+        });
+    }
+
     inline static  void applyRecovery(typename uniform_sampling_t::Ptr uniform_pose_sampler,
                                       const double recovery_random_pose_probability,
                                       sample_set_t &sample_set)
@@ -75,7 +102,7 @@ public:
         const std::size_t size = p_t_1.size();
         std::vector<double> u(size);
         {
-            cslibs_math::random::Uniform<double,1> rng(0.0, 1.0);
+            cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
             double u_static = rng.get();
 
             for(std::size_t i = 0 ; i < size ; ++i) {
@@ -84,10 +111,10 @@ public:
         }
         /// draw samples
         {
-            cslibs_math::random::Uniform<double,1> rng_recovery(0.0, 1.0);
-            auto p_t_1_it = p_t_1.begin();
+            cslibs_math::random::Uniform<double,1> rng_recovery(0.0, 1.0, sample_set.getResamplingSeed());
+            std::size_t index = 0;
             double cumsum_last = 0.0;
-            double cumsum = p_t_1_it->weight;
+            double cumsum = p_t_1.weight(index);
 
             auto in_range = [&cumsum, &cumsum_last] (double u)
             {
@@ -98,9 +125,9 @@ public:
 
             for(auto &u_r : u) {
                 while(!in_range(u_r)) {
-                    ++p_t_1_it;
+                    ++index;
                     cumsum_last = cumsum;
-                    cumsum += p_t_1_it->weight;
+                    cumsum += p_t_1.weight(index);
                 }
                 const double recovery_probability = rng_recovery.get();
                 if(recovery_probability < recovery_random_pose_probability) {
@@ -108,7 +135,7 @@ public:
                     sample.weight = recovery_probability;
                     i_p_t.insert(sample);
                 } else {
-                    i_p_t.insert(*p_t_1_it);
+                    i_p_t.insert(p_t_1, index);
                 }
             }
         }
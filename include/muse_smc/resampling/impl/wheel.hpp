@@ -26,17 +26,17 @@ public:
         const double w_max = sample_set.getMaximumWeight();
         typename sample_set_t::sample_insertion_t  i_p_t = sample_set.getInsertion();
 
-        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0);
+        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
         double beta = 0.0;
         std::size_t index = (std::size_t(rng.get() * size)) % size;
 
         for(std::size_t i = 0 ; i < size ; ++i) {
             beta += 2 * w_max * rng.get();
-            while (beta > p_t_1[index].weight) {
-                beta -= p_t_1[index].weight;
+            while (beta > p_t_1.weight(index)) {
+                beta -= p_t_1.weight(index);
                 index = (index + 1) % size;
             }
-            i_p_t.insert(p_t_1[index]);
+            i_p_t.insert(p_t_1, index);
         }
     }
 
@@ -56,16 +56,16 @@ public:
         typename sample_set_t::sample_insertion_t  i_p_t = sample_set.getInsertion();
         const std::size_t size = p_t_1.size();
 
-        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0);
-        cslibs_math::random::Uniform<double,1> rng_recovery(0.0, 1.0);
+        cslibs_math::random::Uniform<double,1> rng(0.0, 1.0, sample_set.getResamplingSeed());
+        cslibs_math::random::Uniform<double,1> rng_recovery(0.0, 1.0, sample_set.getResamplingSeed());
         double beta = 0.0;
         std::size_t index = (std::size_t(rng.get() * size)) % size;
         sample_t sample;
 
         for(std::size_t i = 0 ; i < size ; ++i) {
             beta += 2 * w_max * rng.get();
-            while (beta > p_t_1[index].weight) {
-                beta -= p_t_1[index].weight;
+            while (beta > p_t_1.weight(index)) {
+                beta -= p_t_1.weight(index);
                 index = (index + 1) % size;
             }
 
@@ -73,8 +73,9 @@ public:
             if(recovery_propability < recovery_random_pose_probability) {
                 uniform_pose_sampler->apply(sample);
                 sample.weight = recovery_propability;
+                i_p_t.insert(sample);
             } else {
-                i_p_t.insert(p_t_1[index]);
+                i_p_t.insert(p_t_1, index);
             }
         }
     }
@@ -28,7 +28,9 @@ public:
         recovery_alpha_slow_(0.0),
         recovery_fast_(0.0),
         recovery_slow_(0.0),
-        variance_treshold_(0.0)
+        recovery_random_pose_probability_(0.0),
+        variance_treshold_(0.0),
+        effective_sample_size_ratio_treshold_(0.0)
     {
     }
 
@@ -38,13 +40,15 @@ public:
                               const typename sample_normal_t::Ptr  &normal_pose_sampler,
                               const double                          recovery_alpha_fast = 0.0,
                               const double                          recovery_alpha_slow = 0.0,
-                              const double                          variance_threshold = 0.0)
+                              const double                          variance_threshold = 0.0,
+                              const double                          effective_sample_size_ratio_threshold = 0.0)
     {
         uniform_pose_sampler_ = uniform_pose_sampler;
         normal_pose_sampler_  = normal_pose_sampler;
         recovery_alpha_fast_  = recovery_alpha_fast;
         recovery_alpha_slow_  = recovery_alpha_slow;
         variance_treshold_    = variance_threshold;
+        effective_sample_size_ratio_treshold_ = effective_sample_size_ratio_threshold;
     }
 
     inline void apply(sample_set_t &sample_set)
@@ -59,6 +63,12 @@ public:
             return;
         }
 
+        /// resample only if the effective sample size dropped below a fraction of the sample size
+        if(effective_sample_size_ratio_treshold_ > 0.0 &&
+                sample_set.getEffectiveSampleSize() >= effective_sample_size_ratio_treshold_ * sample_set.getSampleSize()) {
+            return;
+        }
+
 
         auto do_apply = [&sample_set, this] () {
             doApply(sample_set);
@@ -101,6 +111,7 @@ protected:
     double                          recovery_slow_;
     double                          recovery_random_pose_probability_;
     double                          variance_treshold_;
+    double                          effective_sample_size_ratio_treshold_;
     typename sample_uniform_t::Ptr  uniform_pose_sampler_;
     typename sample_normal_t::Ptr   normal_pose_sampler_;
 
@@ -1,7 +1,13 @@
 #ifndef SAMPLE_DENSITY_HPP
 #define SAMPLE_DENSITY_HPP
 
+#include <muse_smc/samples/sample_storage_aos.hpp>
+
 #include <memory>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
 
 namespace muse_smc {
 template<typename sample_t>
@@ -16,6 +22,79 @@ public:
     virtual void clear() = 0;
     virtual void insert(const sample_t &sample) = 0;
     virtual void estimate() = 0;
+
+    /**
+     * @brief Announce the amount of samples inserted until the next estimation, densities
+     *        may preallocate or choose how to split the insertion. Ignored by default.
+     * @param size      - the amount of samples
+     */
+    virtual void reserve(const std::size_t size)
+    {
+    }
+
+    /**
+     * @brief Insert a contiguous range of samples, densities may override this to bin
+     *        whole blocks at once. Inserts one sample after another by default.
+     * @param begin     - the first sample
+     * @param end       - behind the last sample
+     */
+    virtual void insertRange(const sample_t *begin,
+                             const sample_t *end)
+    {
+        for (const sample_t *s = begin ; s != end ; ++s)
+            insert(*s);
+    }
+
+    /**
+     * @brief Amount of occupied histogram bins since the last clear, used for KLD sampling.
+     *        Densities without a histogram return 0, KLD sampling then keeps the sample size.
+     */
+    virtual std::size_t histogramSize() const
+    {
+        return 0;
+    }
+};
+
+/**
+ * @brief The SampleDensityInsertion struct hands the samples of a storage to a density
+ *        in blocks, the total amount is announced by SampleDensity::reserve first.
+ *        Samples of storages, which do not keep them contiguously, are assembled into
+ *        blocks first.
+ */
+template<typename sample_storage_t>
+struct SampleDensityInsertion
+{
+    template<typename density_t>
+    inline static void apply(const sample_storage_t &samples,
+                             density_t              &density)
+    {
+        using block_t = std::vector<typename std::decay<decltype(samples[0])>::type>;
+        const std::size_t block_size = 4096;
+
+        density.reserve(samples.size());
+        block_t block;
+        block.reserve(std::min(block_size, samples.size()));
+        for (std::size_t i = 0 ; i < samples.size() ; i += block_size) {
+            const std::size_t end = std::min(i + block_size, samples.size());
+            block.clear();
+            for (std::size_t j = i ; j < end ; ++j)
+                block.emplace_back(samples[j]);
+            density.insertRange(block.data(), block.data() + block.size());
+        }
+    }
+};
+
+template<typename sample_t>
+struct SampleDensityInsertion<SampleStorageAoS<sample_t>>
+{
+    template<typename density_t>
+    inline static void apply(const SampleStorageAoS<sample_t> &samples,
+                             density_t                        &density)
+    {
+        density.reserve(samples.size());
+        if (!samples.empty())
+            density.insertRange(&samples[0], &samples[0] + samples.size());
+    }
 };
 }
 
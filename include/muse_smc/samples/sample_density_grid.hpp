@@ -0,0 +1,512 @@
+#ifndef SAMPLE_DENSITY_GRID_HPP
+#define SAMPLE_DENSITY_GRID_HPP
+
+#include <muse_smc/samples/sample_density.hpp>
+#include <muse_smc/utility/thread_pool.hpp>
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace muse_smc {
+/**
+ * @brief The SampleDensityGrid class bins samples into a hashed grid and clusters the
+ *        occupied cells, which touch each other, including diagonally, into connected
+ *        components. Each cluster keeps the weight sum, the mean and the covariance of
+ *        its samples, weights are taken as inserted.
+ *        Given a thread pool, ranges are inserted, the grid is built, components are
+ *        labeled and cluster statistics are computed in parallel. The grid is sharded by
+ *        the hash of the cell index, so shards are built concurrently without locks, and
+ *        components are labeled by a lock-free union-find. Buffers are kept across
+ *        estimations, only the hash maps of the occupied cells allocate their entries.
+ * @param sample_t      - the sample type
+ * @param Dim           - dimension of the vectorized state
+ * @param vectorize_t   - thread-safe functor mapping a state to Eigen::Matrix<double, Dim, 1>,
+ *                        the vector is binned and its statistics are computed, e.g. for
+ *                        poses angles should be mapped to their cosine and sine, which bins
+ *                        them on the unit circle and keeps cluster means meaningful
+ */
+template<typename sample_t, int Dim, typename vectorize_t>
+class EIGEN_ALIGN16 SampleDensityGrid : public SampleDensity<sample_t>
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    using Ptr          = std::shared_ptr<SampleDensityGrid>;
+    using state_t      = typename sample_t::state_t;
+    using vector_t     = Eigen::Matrix<double, Dim, 1>;
+    using covariance_t = Eigen::Matrix<double, Dim, Dim>;
+    using index_t      = std::array<int, Dim>;
+
+    struct EIGEN_ALIGN16 Cluster {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        double       weight     = 0.0;
+        std::size_t  samples    = 0;
+        std::size_t  cells      = 0;
+        vector_t     mean       = vector_t::Zero();
+        covariance_t covariance = covariance_t::Zero();
+    };
+    using clusters_t = std::vector<Cluster, Eigen::aligned_allocator<Cluster>>;
+
+    /**
+     * @brief SampleDensityGrid constructor.
+     * @param resolution    - the cell size in every dimension of the vectorized state
+     * @param thread_pool   - optional thread pool, it may be shared with the sample set,
+     *                        but batches of both are then serialized
+     * @param vectorize     - the vectorization functor
+     */
+    inline explicit SampleDensityGrid(const vector_t        &resolution,
+                                      const ThreadPool::Ptr &thread_pool = nullptr,
+                                      const vectorize_t     &vectorize   = vectorize_t()) :
+        inverse_resolution_(resolution.cwiseInverse()),
+        thread_pool_(thread_pool),
+        vectorize_(vectorize),
+        histogram_size_(0),
+        reserved_(0),
+        parent_capacity_(0)
+    {
+        /// neighbor offsets in {-1, 0, 1}^Dim, lexicographically positive ones suffice
+        index_t offset;
+        offset.fill(-1);
+        while (true) {
+            const auto first = std::find_if(offset.begin(), offset.end(), [](const int o) {return o != 0;});
+            if (first != offset.end() && *first > 0)
+                neighbors_.emplace_back(offset);
+
+            std::size_t d = 0;
+            while (d < offset.size() && offset[d] == 1)
+                offset[d++] = -1;
+            if (d == offset.size())
+                break;
+            ++offset[d];
+        }
+    }
+
+    virtual void clear() override
+    {
+        records_.clear();
+        occupied_.clear();
+        histogram_size_ = 0;
+        reserved_       = 0;
+
+        /// no estimate until the next estimation, capacities are kept
+        for (Shard &shard : shards_) {
+            shard.lookup.clear();
+            shard.indices.clear();
+            shard.cells.clear();
+        }
+        cell_begin_.clear();
+        cells_.clear();
+        label_.clear();
+        cluster_begin_.clear();
+        cluster_cells_.clear();
+        clusters_.clear();
+    }
+
+    /**
+     * @brief Large insertions are split among the threads, even if they arrive in blocks.
+     */
+    virtual void reserve(const std::size_t size) override
+    {
+        reserved_ = size;
+        records_.reserve(records_.size() + size);
+    }
+
+    virtual void insert(const sample_t &sample) override
+    {
+        records_.emplace_back(record(sample.state, sample.weight));
+        if (occupied_.insert(records_.back().index).second)
+            ++histogram_size_;
+    }
+
+    virtual void insertRange(const sample_t *begin,
+                             const sample_t *end) override
+    {
+        const std::size_t offset = records_.size();
+        const std::size_t size   = static_cast<std::size_t>(end - begin);
+        records_.resize(offset + size);
+        const std::size_t parts = std::max(size, reserved_) >= 4096 && size >= 256 ? threads() : 1;
+        parallel(parts, [this, begin, offset, size, parts](const std::size_t t) {
+            for (std::size_t i = (t * size) / parts ; i < ((t + 1) * size) / parts ; ++i)
+                records_[offset + i] = record(begin[i].state, begin[i].weight);
+        });
+    }
+
+    virtual void estimate() override
+    {
+        build();
+        label();
+        cluster();
+    }
+
+    /**
+     * @brief Amount of occupied cells. Until estimation, only samples inserted one by one
+     *        are counted, which is the case for KLD sampling.
+     */
+    virtual std::size_t histogramSize() const override
+    {
+        return histogram_size_;
+    }
+
+    inline const clusters_t & getClusters() const
+    {
+        return clusters_;
+    }
+
+    /**
+     * @brief The cluster a state falls into.
+     * @param state     - the state
+     * @param cluster   - the index of the cluster
+     * @return false if the cell of the state is not occupied or nothing was estimated
+     */
+    inline bool getCluster(const state_t &state,
+                           std::size_t   &cluster) const
+    {
+        if (cell_begin_.empty())
+            return false;
+
+        const index_t     index = cell(vectorize_(state));
+        const std::size_t s     = shard(hash(index));
+        const auto it = shards_[s].lookup.find(index);
+        if (it == shards_[s].lookup.end())
+            return false;
+
+        cluster = label_[cell_begin_[s] + it->second];
+        return true;
+    }
+
+    inline vector_t getResolution() const
+    {
+        return inverse_resolution_.cwiseInverse();
+    }
+
+private:
+    struct Hash {
+        inline std::size_t operator()(const index_t &index) const
+        {
+            return static_cast<std::size_t>(SampleDensityGrid::hash(index));
+        }
+    };
+
+    struct EIGEN_ALIGN16 Record {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        index_t       index;
+        std::uint64_t hash;
+        double        weight;
+        vector_t      x;
+    };
+
+    /**
+     * @brief Weighted statistics, updated by West's algorithm and merged by Chan's.
+     */
+    struct EIGEN_ALIGN16 Statistic {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        double       weight  = 0.0;
+        std::size_t  samples = 0;
+        vector_t     mean    = vector_t::Zero();
+        covariance_t scatter = covariance_t::Zero();
+
+        inline void add(const vector_t &x,
+                        const double    w)
+        {
+            ++samples;
+            if (w <= 0.0)
+                return;
+
+            weight += w;
+            const vector_t d = x - mean;
+            mean += (w / weight) * d;
+            scatter.noalias() += w * d * (x - mean).transpose();
+        }
+
+        inline void merge(const Statistic &other)
+        {
+            samples += other.samples;
+            if (other.weight <= 0.0)
+                return;
+            if (weight <= 0.0) {
+                weight  = other.weight;
+                mean    = other.mean;
+                scatter = other.scatter;
+                return;
+            }
+
+            const double   w = weight + other.weight;
+            const vector_t d = other.mean - mean;
+            mean    += (other.weight / w) * d;
+            scatter += other.scatter + (weight * other.weight / w) * d * d.transpose();
+            weight   = w;
+        }
+    };
+
+    using records_t    = std::vector<Record, Eigen::aligned_allocator<Record>>;
+    using statistics_t = std::vector<Statistic, Eigen::aligned_allocator<Statistic>>;
+
+    struct Shard {
+        std::unordered_map<index_t, std::size_t, Hash> lookup;
+        std::vector<index_t>                          indices;
+        statistics_t                                  cells;
+    };
+
+    vector_t                                    inverse_resolution_;
+    ThreadPool::Ptr                             thread_pool_;
+    vectorize_t                                 vectorize_;
+    std::vector<index_t>                        neighbors_;
+
+    records_t                                   records_;
+    std::unordered_set<index_t, Hash>           occupied_;
+    std::size_t                                 histogram_size_;
+    std::size_t                                 reserved_;
+
+    std::vector<std::size_t>                    part_offsets_;
+    std::vector<std::size_t>                    order_;
+    std::vector<std::size_t>                    shard_begin_;
+    std::vector<Shard>                          shards_;
+    std::vector<std::size_t>                    cell_begin_;
+    std::vector<const Statistic*>               cells_;
+    std::unique_ptr<std::atomic<std::size_t>[]> parent_;
+    std::size_t                                 parent_capacity_;
+    std::vector<std::size_t>                    label_;
+    std::vector<std::size_t>                    cluster_begin_;
+    std::vector<std::size_t>                    cluster_cells_;
+    clusters_t                                  clusters_;
+
+    inline static std::uint64_t hash(const index_t &index)
+    {
+        std::uint64_t h = 0;
+        for (const int i : index)
+            h = (h ^ static_cast<std::uint32_t>(i)) * 0x9e3779b97f4a7c15ULL;
+        return h ^ (h >> 32);
+    }
+
+    inline index_t cell(const vector_t &x) const
+    {
+        index_t index;
+        for (int d = 0 ; d < Dim ; ++d)
+            index[d] = static_cast<int>(std::floor(x(d) * inverse_resolution_(d)));
+        return index;
+    }
+
+    inline Record record(const state_t &state,
+                         const double   weight) const
+    {
+        Record r;
+        r.x      = vectorize_(state);
+        r.index  = cell(r.x);
+        r.hash   = hash(r.index);
+        r.weight = weight;
+        return r;
+    }
+
+    inline std::size_t threads() const
+    {
+        return thread_pool_ ? thread_pool_->size() : 1;
+    }
+
+    inline std::size_t shard(const std::uint64_t hash) const
+    {
+        /// the high bits, the maps of the shards bucket by the low ones
+        return static_cast<std::size_t>(hash >> 40) % shards_.size();
+    }
+
+    template<typename task_t>
+    inline void parallel(const std::size_t count,
+                         const task_t     &task)
+    {
+        if (thread_pool_ && thread_pool_->size() > 1 && count > 1) {
+            thread_pool_->parallelFor(count, task);
+        } else {
+            for (std::size_t i = 0 ; i < count ; ++i)
+                task(i);
+        }
+    }
+
+    /**
+     * @brief Distribute the records to the shards, each shard then bins its records.
+     */
+    inline void build()
+    {
+        const std::size_t size   = records_.size();
+        const std::size_t parts  = threads();
+        const std::size_t shards = parts > 1 ? 4 * parts : 1;
+        shards_.resize(shards);
+
+        /// count the records per part and shard, parts then scatter into disjoint ranges
+        part_offsets_.assign(parts * shards, 0);
+        parallel(parts, [this, size, parts, shards](const std::size_t t) {
+            for (std::size_t i = (t * size) / parts ; i < ((t + 1) * size) / parts ; ++i)
+                ++part_offsets_[t * shards + shard(records_[i].hash)];
+        });
+        shard_begin_.assign(shards + 1, 0);
+        std::size_t offset = 0;
+        for (std::size_t s = 0 ; s < shards ; ++s) {
+            shard_begin_[s] = offset;
+            for (std::size_t t = 0 ; t < parts ; ++t) {
+                const std::size_t count = part_offsets_[t * shards + s];
+                part_offsets_[t * shards + s] = offset;
+                offset += count;
+            }
+        }
+        shard_begin_[shards] = offset;
+
+        order_.resize(size);
+        parallel(parts, [this, size, parts, shards](const std::size_t t) {
+            std::size_t *offsets = &part_offsets_[t * shards];
+            for (std::size_t i = (t * size) / parts ; i < ((t + 1) * size) / parts ; ++i)
+                order_[offsets[shard(records_[i].hash)]++] = i;
+        });
+
+        parallel(shards, [this](const std::size_t s) {
+            Shard &shard = shards_[s];
+            shard.lookup.clear();
+            shard.indices.clear();
+            shard.cells.clear();
+            for (std::size_t k = shard_begin_[s] ; k < shard_begin_[s + 1] ; ++k) {
+                const Record &r = records_[order_[k]];
+                const auto inserted = shard.lookup.emplace(r.index, shard.indices.size());
+                if (inserted.second) {
+                    shard.indices.emplace_back(r.index);
+                    shard.cells.emplace_back(Statistic());
+                }
+                shard.cells[inserted.first->second].add(r.x, r.weight);
+            }
+        });
+
+        cell_begin_.assign(shards + 1, 0);
+        for (std::size_t s = 0 ; s < shards ; ++s)
+            cell_begin_[s + 1] = cell_begin_[s] + shards_[s].indices.size();
+        histogram_size_ = cell_begin_[shards];
+    }
+
+    inline std::size_t find(std::size_t x) const
+    {
+        /// parents never have larger indices than their children, roots are minimal
+        while (true) {
+            std::size_t p = parent_[x].load(std::memory_order_relaxed);
+            if (p == x)
+                return x;
+
+            const std::size_t g = parent_[p].load(std::memory_order_relaxed);
+            if (g != p)
+                parent_[x].compare_exchange_weak(p, g, std::memory_order_relaxed);
+            x = g;
+        }
+    }
+
+    inline void unite(std::size_t a,
+                      std::size_t b) const
+    {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b)
+                return;
+            if (a < b)
+                std::swap(a, b);
+
+            std::size_t root = a;
+            if (parent_[a].compare_exchange_strong(root, b, std::memory_order_relaxed))
+                return;
+        }
+    }
+
+    /**
+     * @brief Label connected components, clusters are numbered by their first cell.
+     */
+    inline void label()
+    {
+        const std::size_t cells  = cell_begin_.back();
+        const std::size_t shards = shards_.size();
+        if (parent_capacity_ < cells) {
+            parent_.reset(new std::atomic<std::size_t>[cells]);
+            parent_capacity_ = cells;
+        }
+        cells_.resize(cells);
+        parallel(shards, [this](const std::size_t s) {
+            for (std::size_t l = 0 ; l < shards_[s].indices.size() ; ++l) {
+                const std::size_t g = cell_begin_[s] + l;
+                parent_[g].store(g, std::memory_order_relaxed);
+                cells_[g] = &shards_[s].cells[l];
+            }
+        });
+
+        parallel(shards, [this](const std::size_t s) {
+            const Shard &shard = shards_[s];
+            for (std::size_t l = 0 ; l < shard.indices.size() ; ++l) {
+                const index_t &index = shard.indices[l];
+                for (const index_t &offset : neighbors_) {
+                    index_t neighbor;
+                    for (int d = 0 ; d < Dim ; ++d)
+                        neighbor[d] = index[d] + offset[d];
+
+                    const std::size_t n  = this->shard(hash(neighbor));
+                    const auto        it = shards_[n].lookup.find(neighbor);
+                    if (it != shards_[n].lookup.end())
+                        unite(cell_begin_[s] + l, cell_begin_[n] + it->second);
+                }
+            }
+        });
+
+        label_.resize(cells);
+        parallel(shards, [this](const std::size_t s) {
+            for (std::size_t g = cell_begin_[s] ; g < cell_begin_[s + 1] ; ++g)
+                label_[g] = find(g);
+        });
+
+        /// roots precede the other cells of their component
+        std::size_t clusters = 0;
+        for (std::size_t g = 0 ; g < cells ; ++g) {
+            const std::size_t root = label_[g];
+            label_[g] = root == g ? clusters++ : label_[root];
+        }
+
+        cluster_begin_.assign(clusters + 1, 0);
+        for (std::size_t g = 0 ; g < cells ; ++g)
+            ++cluster_begin_[label_[g] + 1];
+        for (std::size_t c = 0 ; c < clusters ; ++c)
+            cluster_begin_[c + 1] += cluster_begin_[c];
+
+        cluster_cells_.resize(cells);
+        std::vector<std::size_t> &positions = part_offsets_;
+        positions.assign(cluster_begin_.begin(), cluster_begin_.end() - 1);
+        for (std::size_t g = 0 ; g < cells ; ++g)
+            cluster_cells_[positions[label_[g]]++] = g;
+    }
+
+    inline void cluster()
+    {
+        const std::size_t clusters = cluster_begin_.size() - 1;
+        const std::size_t parts    = clusters >= 64 ? 4 * threads() : 1;
+        clusters_.resize(clusters);
+        parallel(parts, [this, clusters, parts](const std::size_t t) {
+            for (std::size_t c = (t * clusters) / parts ; c < ((t + 1) * clusters) / parts ; ++c) {
+                Statistic statistic;
+                for (std::size_t k = cluster_begin_[c] ; k < cluster_begin_[c + 1] ; ++k)
+                    statistic.merge(*cells_[cluster_cells_[k]]);
+
+                Cluster &cluster   = clusters_[c];
+                cluster.weight     = statistic.weight;
+                cluster.samples    = statistic.samples;
+                cluster.cells      = cluster_begin_[c + 1] - cluster_begin_[c];
+                cluster.mean       = statistic.mean;
+                cluster.covariance = statistic.weight > 0.0 ? covariance_t(statistic.scatter / statistic.weight)
+                                                            : covariance_t::Zero();
+            }
+        });
+    }
+};
+}
+
+#endif // SAMPLE_DENSITY_GRID_HPP
@@ -0,0 +1,141 @@
+#ifndef SAMPLE_ESTIMATION_HPP
+#define SAMPLE_ESTIMATION_HPP
+
+#include <cslibs_utility/common/delegate.hpp>
+
+#include <muse_smc/samples/sample_estimator.hpp>
+
+#include <vector>
+
+namespace muse_smc {
+/**
+ * @brief The SampleEstimation class feeds the states an iteration visits to partial
+ *        estimators, one per partition of the iteration. Once the last copy of the
+ *        iteration is released, the partial estimates are merged in order. The estimate
+ *        is only replaced, if every sample was visited exactly once.
+ */
+template<typename sample_t>
+class SampleEstimation
+{
+public:
+    using Ptr             = std::shared_ptr<SampleEstimation>;
+    using estimator_t     = SampleEstimator<sample_t>;
+    using state_t         = typename sample_t::state_t;
+    using notify_finished = cslibs_utility::common::delegate<void()>;
+
+    /**
+     * @brief The Part class is fed the samples of one partition.
+     */
+    class Part
+    {
+    public:
+        inline Part() :
+            size_(0),
+            inserted_(0)
+        {
+        }
+
+        inline Part(const typename estimator_t::Ptr &estimator,
+                    const std::size_t                size) :
+            estimator_(estimator),
+            size_(size),
+            inserted_(0)
+        {
+        }
+
+        inline void insert(const state_t &state,
+                           const double   weight)
+        {
+            estimator_->insert(state, weight);
+            ++inserted_;
+        }
+
+        inline bool complete() const
+        {
+            return estimator_ && inserted_ == size_;
+        }
+
+        inline const estimator_t & getEstimator() const
+        {
+            return *estimator_;
+        }
+
+    private:
+        typename estimator_t::Ptr estimator_;
+        std::size_t               size_;
+        std::size_t               inserted_;
+    };
+
+    /**
+     * @brief SampleEstimation constructor.
+     * @param estimator     - the estimator the parts are merged into
+     * @param partial       - a partial estimator for the whole iteration, see SampleEstimator::partial
+     * @param size          - the amount of samples
+     * @param finished      - called once the estimate was replaced
+     */
+    inline SampleEstimation(const typename estimator_t::Ptr &estimator,
+                            const typename estimator_t::Ptr &partial,
+                            const std::size_t                size,
+                            notify_finished                  finished) :
+        estimator_(estimator),
+        parts_(1, Part(partial, size)),
+        finished_(finished),
+        split_(false)
+    {
+    }
+
+    SampleEstimation(const SampleEstimation &other) = delete;
+    SampleEstimation& operator = (const SampleEstimation &other) = delete;
+
+    virtual ~SampleEstimation()
+    {
+        for(const Part &p : parts_) {
+            if(!p.complete())
+                return;
+        }
+
+        estimator_->clear();
+        for(const Part &p : parts_)
+            estimator_->merge(p.getEstimator());
+        estimator_->estimate();
+        finished_();
+    }
+
+    /**
+     * @brief Replace the part of the whole iteration by one per partition, pointers to
+     *        previous parts become invalid. Partitions can only be split once, a second
+     *        split leaves the parts incomplete and the estimate is not replaced.
+     * @param sizes     - the amount of samples of each partition
+     * @return false, if the iteration was split before
+     */
+    inline bool split(const std::vector<std::size_t> &sizes)
+    {
+        if(split_) {
+            parts_.assign(1, Part());
+            return false;
+        }
+        split_ = true;
+        parts_.clear();
+        parts_.reserve(sizes.size());
+        for(const std::size_t size : sizes)
+            parts_.emplace_back(estimator_->partial(), size);
+        return true;
+    }
+
+    /**
+     * @brief The part of partition i, before split the one of the whole iteration is 0.
+     */
+    inline Part * part(const std::size_t i)
+    {
+        return &parts_[i];
+    }
+
+private:
+    typename estimator_t::Ptr estimator_;
+    std::vector<Part>         parts_;
+    notify_finished           finished_;
+    bool                      split_;
+};
+}
+
+#endif // SAMPLE_ESTIMATION_HPP
@@ -0,0 +1,57 @@
+#ifndef SAMPLE_ESTIMATOR_HPP
+#define SAMPLE_ESTIMATOR_HPP
+
+#include <memory>
+
+namespace muse_smc {
+/**
+ * @brief The SampleEstimator class is an optional hook of the sample set, which is fed
+ *        every state with its weight in passes the set makes anyway, i.e. insertion,
+ *        normalization after an update and, if the estimator can be partial, prediction.
+ *        Statistics like the mean are therefore available without another pass over the
+ *        samples, see SampleSet::setEstimator. Weights are not necessarily normalized,
+ *        estimates should not depend on their scale.
+ */
+template<typename sample_t>
+class SampleEstimator
+{
+public:
+    using sample_estimator_t = SampleEstimator<sample_t>;
+    using Ptr                = std::shared_ptr<sample_estimator_t>;
+    using ConstPtr           = std::shared_ptr<sample_estimator_t const>;
+    using state_t            = typename sample_t::state_t;
+
+    virtual ~SampleEstimator() = default;
+    virtual void clear() = 0;
+    virtual void insert(const state_t &state,
+                        const double   weight) = 0;
+
+    /**
+     * @brief Called after all states were inserted.
+     */
+    virtual void estimate()
+    {
+    }
+
+    /**
+     * @brief An empty estimator of the same kind, which can be fed a disjoint part of the
+     *        samples, e.g. concurrently, and is combined afterwards by merge.
+     * @return the partial estimator, nullptr if partial estimation is not supported
+     */
+    virtual Ptr partial() const
+    {
+        return nullptr;
+    }
+
+    /**
+     * @brief Combine the states inserted into a partial estimator with the ones inserted
+     *        into this one, as if they had been inserted here.
+     * @param other     - an estimator created by partial
+     */
+    virtual void merge(const sample_estimator_t &other)
+    {
+    }
+};
+}
+
+#endif // SAMPLE_ESTIMATOR_HPP
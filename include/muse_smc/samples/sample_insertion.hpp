@@ -1,35 +1,47 @@
 #ifndef SAMPLE_INSERTION_HPP
 #define SAMPLE_INSERTION_HPP
 
-#include <cslibs_utility/buffered/buffered_vector.hpp>
 #include <cslibs_utility/common/delegate.hpp>
 
+#include <muse_smc/samples/sample_storage_aos.hpp>
+
 namespace muse_smc {
 /**
  * @brief The SampleInsertion class is used to fill up a particle set.
  *        The insertion object notifies usage and changes.
  */
-template<typename sample_t>
+template<typename sample_t, typename sample_storage_t = SampleStorageAoS<sample_t>>
 class SampleInsertion {
 public:
     using notify_closed   = cslibs_utility::common::delegate<void()>;
     using notify_update   = cslibs_utility::common::delegate<void(const sample_t &)>;
-    using sample_vector_t = cslibs_utility::buffered::buffered_vector<sample_t, typename sample_t::allocator_t>;
+    using notify_extend   = cslibs_utility::common::delegate<void(std::size_t, std::size_t, std::size_t)>;
+    using notify_commit   = cslibs_utility::common::delegate<void(std::size_t, std::size_t, std::size_t)>;
+    using sample_vector_t = sample_storage_t;
 
     /**
      * @brief Insertion constructor.
      * @param data      - data structure to insert to
      * @param update    - on change notification callback
      * @param finshed   - on finish callback
+     * @param keep_weights - keep the weights of inserted samples instead of setting them to 1.0
+     * @param extend    - on extension callback, receives the appended range and the amount of blocks
+     * @param commit    - on block commit callback, receives the block and its range, called concurrently
      */
     inline SampleInsertion(sample_vector_t &data,
                            notify_update    update,
                            notify_closed    close,
-                           bool keep_weights) :
+                           bool keep_weights,
+                           notify_extend    extend,
+                           notify_commit    commit) :
         data_(data),
         open_(true),
+        touched_(false),
         update_(update),
-        close_(close)
+        close_(close),
+        extend_(extend),
+        commit_(commit),
+        keep_weights_(keep_weights)
     {
     }
 
@@ -48,12 +60,10 @@ public:
 
         touched_ = true;
 
-        data_.emplace_back(std::move(sample));
-
-        sample_t &inserted = data_.back();
         /// after insertion each particle is equally likely
-        inserted.weight = keep_weights_ ?  inserted.weight : 1.0;
-        update_(inserted);
+        sample.weight = keep_weights_ ? sample.weight : 1.0;
+        data_.emplace_back(std::move(sample));
+        update_(data_.back());
     }
 
     inline void insert(const sample_t &sample)
@@ -65,10 +75,82 @@ public:
 
         data_.push_back(sample);
 
-        sample_t &inserted = data_.back();
         /// after insertion each particle is equally likely
-        inserted.weight = keep_weights_ ?  inserted.weight : 1.0;
-        update_(inserted);
+        double &weight = data_.weight(data_.size() - 1);
+        weight = keep_weights_ ? weight : 1.0;
+        update_(data_.back());
+    }
+
+    /**
+     * @brief Insert sample j of another storage, e.g. the ancestor while resampling.
+     *        Unlike insert(source[j]), storages which assemble samples on access copy
+     *        state and weight directly.
+     */
+    inline void insert(const sample_vector_t &source,
+                       const std::size_t      j)
+    {
+        if(!open_)
+            return;
+
+        touched_ = true;
+
+        data_.push_back(source, j);
+
+        /// after insertion each particle is equally likely
+        double &weight = data_.weight(data_.size() - 1);
+        weight = keep_weights_ ? weight : 1.0;
+        update_(data_.back());
+    }
+
+    /**
+     * @brief Append samples, which are assigned afterwards. Samples a recycled buffer
+     *        kept constructed are not constructed again. Assignments to different indices
+     *        may happen concurrently, they are committed in disjoint blocks.
+     * @param size      - amount of samples to append
+     * @param blocks    - amount of blocks the samples are committed in
+     * @return the index of the first appended sample
+     */
+    inline std::size_t extend(const std::size_t size,
+                              const std::size_t blocks)
+    {
+        const std::size_t offset = data_.size();
+        if(!open_)
+            return offset;
+
+        touched_ = true;
+        data_.resize(offset + size);
+        extend_(offset, offset + size, blocks);
+        return offset;
+    }
+
+    /**
+     * @brief Assign sample j of source to an appended sample i.
+     */
+    inline void assign(const std::size_t      i,
+                       const sample_vector_t &source,
+                       const std::size_t      j)
+    {
+        data_.copy(i, source, j);
+
+        /// after insertion each particle is equally likely
+        if(!keep_weights_)
+            data_.weight(i) = 1.0;
+    }
+
+    /**
+     * @brief Notify the insertion of the samples in [begin, end) as one block of the last
+     *        extension. Different blocks may be committed concurrently, the statistics
+     *        of the blocks are merged in block order when the insertion is closed.
+     * @param block     - the index of the block
+     */
+    inline void commit(const std::size_t block,
+                       const std::size_t begin,
+                       const std::size_t end)
+    {
+        if(!open_)
+            return;
+
+        commit_(block, begin, end);
     }
 
     inline bool canInsert() const
@@ -98,6 +180,8 @@ private:
     bool             touched_;    /// indicator if something was inserted
     notify_update    update_;     /// on update callback
     notify_closed    close_;      /// on close / finish callback
+    notify_extend    extend_;     /// on extension callback
+    notify_commit    commit_;     /// on block commit callback
     bool             keep_weights_;
 };
 }
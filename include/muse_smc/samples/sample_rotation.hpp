@@ -0,0 +1,97 @@
+#ifndef SAMPLE_ROTATION_HPP
+#define SAMPLE_ROTATION_HPP
+
+#include <memory>
+#include <algorithm>
+
+namespace muse_smc {
+/**
+ * @brief The SampleRotation class moves the samples of an iteration from a buffer, which
+ *        is still held by a snapshot, into the buffer the iteration writes to. Samples are
+ *        copied one at a time, when the iteration first reaches them, so that the copy is
+ *        part of the pass models do anyway. Samples which were not reached are copied once
+ *        the rotation is completed or destroyed.
+ */
+template<typename sample_storage_t>
+class SampleRotation
+{
+public:
+    using Ptr      = std::shared_ptr<SampleRotation>;
+    using source_t = std::shared_ptr<const sample_storage_t>;
+
+    /**
+     * @brief SampleRotation constructor.
+     * @param data      - the buffer to write to, sized like the source
+     * @param source    - the buffer to copy from
+     * @param begin     - the first sample of the range
+     * @param end       - behind the last sample of the range
+     */
+    inline SampleRotation(sample_storage_t  &data,
+                          const source_t    &source,
+                          const std::size_t  begin,
+                          const std::size_t  end) :
+        data_(data),
+        source_(source),
+        copied_(begin),
+        end_(end)
+    {
+    }
+
+    SampleRotation(const SampleRotation &other) = delete;
+    SampleRotation& operator = (const SampleRotation &other) = delete;
+
+    virtual ~SampleRotation()
+    {
+        complete();
+    }
+
+    /**
+     * @brief Make sure sample index was copied, iterations reach samples in order.
+     */
+    inline void reach(const std::size_t index)
+    {
+        if(index >= copied_ && index < end_)
+            copyUntil(index + 1);
+    }
+
+    /**
+     * @brief Copy all samples which were not reached yet.
+     */
+    inline void complete()
+    {
+        copyUntil(end_);
+    }
+
+    /**
+     * @brief A rotation of the samples in [begin, end), e.g. for a partition. Once the
+     *        range is covered by such rotations, this one has to be released.
+     */
+    inline Ptr split(const std::size_t begin,
+                     const std::size_t end) const
+    {
+        return Ptr(new SampleRotation(data_, source_, std::max(begin, std::min(end, copied_)), end));
+    }
+
+    /**
+     * @brief Stop copying, the remaining samples are copied by the rotations split off.
+     */
+    inline void release()
+    {
+        copied_ = end_;
+    }
+
+private:
+    sample_storage_t &data_;
+    source_t          source_;
+    std::size_t       copied_;
+    std::size_t       end_;
+
+    inline void copyUntil(const std::size_t until)
+    {
+        for(; copied_ < until ; ++copied_)
+            data_.copy(copied_, *source_, copied_);
+    }
+};
+}
+
+#endif // SAMPLE_ROTATION_HPP
@@ -3,17 +3,30 @@
 
 #include <string>
 #include <limits>
+#include <cmath>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
 
-#include <cslibs_utility/buffered/buffered_vector.hpp>
+#include <Eigen/Core>
 
 #include <cslibs_time/time.hpp>
 
-#include <cslibs_math/statistics/distribution.hpp>
-
 #include <muse_smc/samples/sample_density.hpp>
+#include <muse_smc/samples/sample_estimator.hpp>
+#include <muse_smc/samples/sample_estimation.hpp>
+#include <muse_smc/samples/sample_storage.hpp>
+#include <muse_smc/samples/sample_weight_distribution.hpp>
+#include <muse_smc/samples/sample_weight_kernels.hpp>
 #include <muse_smc/samples/sample_insertion.hpp>
 #include <muse_smc/samples/sample_weight_iterator.hpp>
 #include <muse_smc/samples/sample_state_iterator.hpp>
+#include <muse_smc/samples/sample_set_snapshot.hpp>
+#include <muse_smc/utility/thread_pool.hpp>
+#include <muse_smc/utility/random_seed.hpp>
+#include <muse_smc/utility/histogram.hpp>
+#include <muse_smc/utility/async_worker.hpp>
 
 namespace muse_smc {
 template<typename state_space_description_t>
@@ -24,12 +37,19 @@ public:
 
     using sample_t              = typename state_space_description_t::sample_t;
     using sample_set_t          = SampleSet<state_space_description_t>;
-    using sample_vector_t       = cslibs_utility::buffered::buffered_vector<sample_t, typename sample_t::allocator_t>;
+    using sample_storage_t      = typename SampleStorageTraits<state_space_description_t>::storage_t;
+    using sample_vector_t       = sample_storage_t;
     using sample_density_t      = SampleDensity<sample_t>;
-    using sample_insertion_t    = SampleInsertion<sample_t>;
+    using sample_estimator_t    = SampleEstimator<sample_t>;
+    using density_insertion_t   = SampleDensityInsertion<typename SampleStorageTraits<state_space_description_t>::storage_t>;
+    using sample_insertion_t    = SampleInsertion<sample_t, sample_storage_t>;
     using state_iterator_t      = StateIteration<state_space_description_t>;
     using weight_iterator_t     = WeightIteration<state_space_description_t>;
-    using weight_distribution_t = cslibs_math::statistics::Distribution<double,1>;
+    using weight_distribution_t = WeightDistribution;
+    using weight_kernels_t      = WeightKernels<sample_storage_t>;
+    using snapshot_t            = SampleSetSnapshot<state_space_description_t>;
+    using rotation_t            = SampleRotation<sample_storage_t>;
+    using estimation_t          = SampleEstimation<sample_t>;
 
     using Ptr = std::shared_ptr<sample_set_t>;
     using ConstPtr = std::shared_ptr<sample_set_t const>;
@@ -67,8 +87,21 @@ public:
         weight_sum_(0.0),
         p_t_1_(new sample_vector_t(0, maximum_sample_size_)),
         p_t_1_density_(density),
-        p_t_(new sample_vector_t(0, maximum_sample_size_)),
-        keep_weights_after_insertion_(keep_weights_after_resampling)
+        keep_weights_after_insertion_(keep_weights_after_resampling),
+        log_weights_(false),
+        weights_in_log_domain_(false),
+        random_seed_(random_seed::random()),
+        state_iterations_(0),
+        resamplings_(0),
+        version_(0),
+        estimate_valid_(false),
+        estimation_version_(0),
+        kld_error_(0.0),
+        kld_z_(0.0),
+        kld_bins_(0),
+        kld_sample_size_(0),
+        extension_begin_(0),
+        extension_end_(0)
     {
     }
 
@@ -95,8 +128,21 @@ public:
         weight_sum_(0.0),
         p_t_1_(new sample_vector_t(0, maximum_sample_size_)),
         p_t_1_density_(density),
-        p_t_(new sample_vector_t(0, maximum_sample_size_)),
-        keep_weights_after_insertion_(keep_weights_after_insertion)
+        keep_weights_after_insertion_(keep_weights_after_insertion),
+        log_weights_(false),
+        weights_in_log_domain_(false),
+        random_seed_(random_seed::random()),
+        state_iterations_(0),
+        resamplings_(0),
+        version_(0),
+        estimate_valid_(false),
+        estimation_version_(0),
+        kld_error_(0.0),
+        kld_z_(0.0),
+        kld_bins_(0),
+        kld_sample_size_(0),
+        extension_begin_(0),
+        extension_end_(0)
     {
     }
 
@@ -111,61 +157,264 @@ public:
      */
     inline SampleSet& operator = (SampleSet &&other) = default;
 
+    /**
+     * @brief Access the weights, see WeightIteration. If a snapshot still holds the samples,
+     *        the iteration writes to another buffer and copies each sample when it reaches
+     *        it. Other accesses to the set have to wait until the iteration is released.
+     */
     inline weight_iterator_t getWeightIterator()
     {
+        /// log weights are transformed in place on first access, the samples are copied beforehand
+        typename rotation_t::Ptr rotation;
+        if (log_weights_)
+            writable();
+        else
+            rotation = rotate();
         return weight_iterator_t(*p_t_1_,
-                                weight_iterator_t::notify_touch::template    from<sample_set_t, &sample_set_t::weightStatisticReset>(this),
-                                weight_iterator_t::notify_update::template   from<sample_set_t, &sample_set_t::weightUpdate>(this),
-                                weight_iterator_t::notify_finished::template from<sample_set_t, &sample_set_t::normalizeWeights>(this));
+                                weight_iterator_t::notify_touch::template    from<sample_set_t, &sample_set_t::weightIterationTouched>(this),
+                                weight_iterator_t::notify_finished::template from<sample_set_t, &sample_set_t::weightIterationFinished>(this),
+                                log_weights_,
+                                thread_pool_,
+                                rotation);
+    }
+
+    /**
+     * @brief Set a thread pool, update models which support partitioning are then
+     *        applied concurrently on disjoint partitions of the sample set.
+     * @param thread_pool   - the thread pool, empty to disable
+     */
+    inline void setThreadPool(const ThreadPool::Ptr &thread_pool)
+    {
+        thread_pool_ = thread_pool;
+    }
+
+    inline const ThreadPool::Ptr & getThreadPool() const
+    {
+        return thread_pool_;
+    }
+
+    /**
+     * @brief Enable the log weight mode. Weight iterations then hand out log weights,
+     *        update models add log-likelihoods and normalization is carried out by
+     *        log-sum-exp. Outside of weight iterations weights stay normalized and linear.
+     * @param log_weights   - enable or disable log weights
+     */
+    inline void setLogWeights(const bool log_weights)
+    {
+        log_weights_ = log_weights;
     }
 
+    inline bool hasLogWeights() const
+    {
+        return log_weights_;
+    }
+
+    /**
+     * @brief Access the states, see StateIteration. Like getWeightIterator, samples held by
+     *        a snapshot are copied while the iteration reaches them. If the estimator can
+     *        be partial, it is fed the samples the iteration leaves behind, so the estimate
+     *        is up to date once every sample was visited exactly once.
+     */
     inline state_iterator_t getStateIterator()
     {
-        return state_iterator_t(stamp_, *p_t_1_);
+        estimate_valid_ = false;
+        const typename rotation_t::Ptr rotation = rotate();
+
+        typename estimation_t::Ptr estimation;
+        if (estimator_) {
+            const typename sample_estimator_t::Ptr partial = estimator_->partial();
+            if (partial) {
+                estimation_version_ = version_;
+                estimation.reset(new estimation_t(estimator_,
+                                                  partial,
+                                                  p_t_1_->size(),
+                                                  estimation_t::notify_finished::template from<sample_set_t, &sample_set_t::estimationFinished>(this)));
+            }
+        }
+        return state_iterator_t(stamp_,
+                                *p_t_1_,
+                                random_seed::derive(random_seed_, state_iterations_++),
+                                thread_pool_,
+                                rotation,
+                                estimation);
+    }
+
+    /**
+     * @brief Set the seed random streams of state iterations and resampling are derived
+     *        from. Given the same seed and the same sequence of inputs, prediction models
+     *        which use these streams and the resampling schemes produce identical results.
+     * @param seed  - the seed
+     */
+    inline void setRandomSeed(const std::uint64_t seed)
+    {
+        random_seed_      = seed;
+        state_iterations_ = 0;
+        resamplings_      = 0;
+    }
+
+    inline std::uint64_t getRandomSeed() const
+    {
+        return random_seed_;
+    }
+
+    /**
+     * @brief A seed for the random numbers of a resampling step, a new one is derived
+     *        from the random seed on every call.
+     */
+    inline std::uint64_t getResamplingSeed()
+    {
+        return random_seed::derive(random_seed::derive(random_seed_, std::numeric_limits<std::uint64_t>::max()),
+                                   resamplings_++);
     }
 
     inline sample_insertion_t getInsertion()
     {
+        waitDensity();
         weightStatisticReset();
+        kldReset();
         p_t_1_density_->clear();
-        p_t_->clear();
+        estimatorReset();
+        ++version_;
+        insertionBuffer().clear();
         return sample_insertion_t(*p_t_,
                                   sample_insertion_t::notify_update::template from<sample_set_t, &sample_set_t::insertionUpdate>(this),
                                   sample_insertion_t::notify_closed::template from<sample_set_t, &sample_set_t::insertionClosedReset>(this),
-                                  keep_weights_after_insertion_);
+                                  keep_weights_after_insertion_,
+                                  sample_insertion_t::notify_extend::template from<sample_set_t, &sample_set_t::insertionExtended>(this),
+                                  sample_insertion_t::notify_commit::template from<sample_set_t, &sample_set_t::insertionCommitted>(this));
+    }
+
+    /**
+     * @brief Rebuild the set in place from offspring counts, as produced by ancestor
+     *        resampling. Samples with offspring stay where they are, duplicates are
+     *        copied into slots of samples without offspring, therefore each state is
+     *        moved at most once. The insertion buffer is not used and released, it is
+     *        allocated again by the next insertion.
+     * @param offspring - the amount of offspring of each sample
+     * @throws std::invalid_argument if the amount of counts does not match the sample size
+     */
+    inline void permute(const std::vector<std::size_t> &offspring)
+    {
+        if (offspring.size() != p_t_1_->size())
+            throw std::invalid_argument("[SampleSet]: Offspring count size does not match the sample size!");
+
+        sample_vector_t &p_t_1 = writable();
+        const std::size_t size = p_t_1.size();
+
+        std::size_t sample_size = 0;
+        for (const std::size_t c : offspring)
+            sample_size += c;
+        if (sample_size > size)
+            p_t_1.resize(sample_size);
+
+        /// slots to be filled, samples without offspring and appended ones
+        std::vector<std::size_t> slots;
+        for (std::size_t i = 0 ; i < std::min(size, sample_size) ; ++i) {
+            if (offspring[i] == 0)
+                slots.emplace_back(i);
+        }
+        for (std::size_t i = size ; i < sample_size ; ++i)
+            slots.emplace_back(i);
+
+        std::size_t slot = 0;
+        for (std::size_t i = 0 ; i < size ; ++i) {
+            if (offspring[i] == 0)
+                continue;
+
+            /// samples beyond the new size are moved into a free slot first
+            std::size_t origin = i;
+            if (i >= sample_size) {
+                origin = slots[slot++];
+                p_t_1.move(origin, i);
+            }
+            for (std::size_t k = 1 ; k < offspring[i] ; ++k)
+                p_t_1.copy(slots[slot++], p_t_1, origin);
+        }
+        p_t_1.resize(sample_size);
+        p_t_.reset();
+
+        weightStatisticReset();
+        kldReset();
+        waitDensity();
+        p_t_1_density_->clear();
+        estimatorReset();
+        if (!keep_weights_after_insertion_)
+            weight_kernels_t::fill(p_t_1, 1.0);
+        for (std::size_t i = 0 ; i < sample_size ; ++i)
+            insertionUpdate(p_t_1[i]);
+        insertionClosed();
     }
 
     inline void normalizeWeights()
     {
         if (p_t_1_->size() == 0)
             return;
-        if (weight_sum_ == 0.0)
+        writable();
+        if (weights_in_log_domain_) {
+            /// online log-sum-exp, then exponentiation is fused with normalization, two passes in total
+            weights_in_log_domain_ = false;
+            double       shift = 0.0;
+            const double sum   = weight_kernels_t::logSumExp(*p_t_1_, shift);
+            /// no finite log weight, e.g. all samples were given a likelihood of 0
+            if (kernels::isFinite(shift) && kernels::isFinite(sum) && sum > 0.0) {
+                normalizeBlocks([shift, sum](sample_vector_t &data, const std::size_t begin, const std::size_t end) {
+                    return weight_kernels_t::exponentiate(data, begin, end, shift, sum);
+                });
+                return;
+            }
+            weight_sum_ = 0.0;
+        }
+        if (weight_sum_ == 0.0 || !kernels::isFinite(weight_sum_))
             resetWeights();
 
-        weight_distribution_.reset();
-        for (auto &s : *p_t_1_) {
-            s.weight /= weight_sum_;
-            weight_distribution_.add(s.weight);
-        }
-        maximum_weight_ /= weight_sum_;
-        weight_sum_ = 1.0;
+        const double sum = weight_sum_;
+        normalizeBlocks([sum](sample_vector_t &data, const std::size_t begin, const std::size_t end) {
+            return weight_kernels_t::normalize(data, begin, end, sum);
+        });
     }
 
     inline void resetWeights()
     {
         if (p_t_1_->size() == 0)
             return;
+        writable();
 
-        weight_distribution_.reset();
-        for (auto &s : *p_t_1_) {
-            s.weight = 1.0;
-            weight_distribution_.add(1.0);
-        }
+        weight_distribution_ = weight_kernels_t::fill(*p_t_1_, 1.0);
+        estimate_valid_      = false;
 
+        minimum_weight_ = 1.0;
         maximum_weight_ = 1.0;
         weight_sum_     = static_cast<double>(p_t_1_->size());
     }
 
+    /**
+     * @brief Enable KLD sampling, the sample size is adapted such that the error between
+     *        the sample based and the true posterior stays below kld_error with probability
+     *        1 - delta. The bound is clamped to the minimum and maximum sample size. The
+     *        density has to implement histogramSize, otherwise the sample size is kept.
+     * @param kld_error     - maximum Kullback-Leibler divergence, 0 to disable
+     * @param kld_z         - upper 1 - delta quantile of the standard normal distribution
+     */
+    inline void setKLD(const double kld_error,
+                       const double kld_z)
+    {
+        kld_error_ = kld_error;
+        kld_z_     = kld_z;
+    }
+
+    /**
+     * @brief The sample size required by the samples inserted so far, given the occupied
+     *        bins of the density. Without KLD sampling, or if the density does not report
+     *        any occupied bins, e.g. because it has no histogram, the current sample size
+     *        is kept.
+     */
+    inline std::size_t getKLDSampleSize() const
+    {
+        const bool adapt = kld_error_ > 0.0 && kld_bins_ > 0;
+        const std::size_t sample_size = adapt ? kld_sample_size_ : p_t_1_->size();
+        return std::max(minimum_sample_size_, std::min(maximum_sample_size_, sample_size));
+    }
+
     inline std::size_t getMinimumSampleSize() const
     {
         return minimum_sample_size_;
@@ -211,6 +460,11 @@ public:
         return weight_distribution_.getMean();
     }
 
+    /**
+     * @brief The statistics of the current weights. This used to be a cslibs_math
+     *        Distribution<double,1>, WeightDistribution offers the same getN, getMean and
+     *        getVariance accessors and can be merged, but it is not a cslibs_math type.
+     */
     inline weight_distribution_t const & getWeightDistribution() const
     {
         return weight_distribution_;
@@ -226,6 +480,14 @@ public:
         return weight_distribution_.getVariance();
     }
 
+    /**
+     * @brief Effective sample size, which is tracked by insertion and weight updates.
+     */
+    inline double getEffectiveSampleSize() const
+    {
+        return weight_distribution_.getEffectiveSampleSize();
+    }
+
     inline bool isNormalized() const
     {
         return weight_sum_ == 1.0;
@@ -236,19 +498,120 @@ public:
         return *p_t_1_;
     }
 
+    /**
+     * @brief Take an immutable snapshot of the samples, e.g. for publication. Costs a
+     *        reference count, the sample buffer is shared until the set is modified.
+     *        Snapshots have to be taken on the thread modifying the set, outside of
+     *        weight and state iterations. They may be read from any thread.
+     * @return the snapshot
+     */
+    inline snapshot_t snapshot() const
+    {
+        return snapshot_t(frame_id_,
+                          stamp_,
+                          version_,
+                          p_t_1_,
+                          weight_distribution_,
+                          weight_sum_);
+    }
+
+    /**
+     * @brief The version grows whenever the samples may have been modified.
+     */
+    inline std::uint64_t getVersion() const
+    {
+        return version_;
+    }
+
+    /**
+     * @brief The density of the samples, waits for a pending asynchronous estimation.
+     */
     inline typename sample_density_t::ConstPtr getDensity() const
     {
+        waitDensity();
         return p_t_1_density_;
     }
 
     inline void updateDensity() const
     {
+        waitDensity();
+        Histogram::Timer timer(density_histogram_);
         p_t_1_density_->clear();
-        for (const auto &s : *p_t_1_)
-            p_t_1_density_->insert(s);
+        density_insertion_t::apply(*p_t_1_, *p_t_1_density_);
         p_t_1_density_->estimate();
     }
 
+    /**
+     * @brief Estimate the density on a helper thread after insertion. Samples are then
+     *        inserted into the density on the helper thread as well, unless KLD sampling
+     *        needs the histogram during insertion. The helper holds the inserted samples
+     *        like a snapshot, closing the insertion does not copy them. Only writing to the
+     *        samples while it still runs copies them once. getDensity and the next insertion
+     *        wait for it to finish.
+     * @param asynchronous  - enable or disable asynchronous estimation
+     */
+    inline void setAsynchronousDensity(const bool asynchronous)
+    {
+        waitDensity();
+        if (asynchronous && !density_worker_)
+            density_worker_.reset(new AsyncWorker);
+        else if (!asynchronous)
+            density_worker_.reset();
+    }
+
+    inline bool hasAsynchronousDensity() const
+    {
+        return static_cast<bool>(density_worker_);
+    }
+
+    /**
+     * @brief Set an estimator, which is fed all states with their weights during insertion,
+     *        e.g. while resampling, and during normalization after an update. Normalization
+     *        runs the vectorized weight kernels block wise and feeds each block while it is
+     *        in cache, in parallel if the estimator can be partial and a thread pool is set.
+     *        Predictions feed partial estimators while iterating, see getStateIterator.
+     * @param estimator     - the estimator, nullptr to disable
+     */
+    inline void setEstimator(const typename sample_estimator_t::Ptr &estimator)
+    {
+        estimator_      = estimator;
+        estimate_valid_ = false;
+    }
+
+    /**
+     * @brief The estimator, its estimate is up to date after insertion and updates. After
+     *        predictions it is only, if the estimator can be partial, see updateEstimator.
+     */
+    inline typename sample_estimator_t::ConstPtr getEstimator() const
+    {
+        return estimator_;
+    }
+
+    /**
+     * @brief Bring the estimate up to date. This only walks the samples, if the states were
+     *        changed by a prediction and the estimator can not be partial, or the model
+     *        did not visit every sample through the iterators.
+     */
+    inline void updateEstimator() const
+    {
+        if (!estimator_ || estimate_valid_)
+            return;
+
+        estimator_->clear();
+        for (std::size_t i = 0 ; i < p_t_1_->size() ; ++i)
+            estimator_->insert(p_t_1_->state(i), p_t_1_->weight(i));
+        estimator_->estimate();
+        estimate_valid_ = true;
+    }
+
+    /**
+     * @brief Durations of density estimation, may be read from any thread.
+     */
+    inline Histogram const & getDensityHistogram() const
+    {
+        return density_histogram_;
+    }
+
 private:
     std::string                                 frame_id_;
     cslibs_time::Time                           stamp_;
@@ -265,6 +628,102 @@ private:
     std::shared_ptr<sample_vector_t>            p_t_;
 
     bool                                        keep_weights_after_insertion_;
+    bool                                        log_weights_;
+    bool                                        weights_in_log_domain_;
+    ThreadPool::Ptr                             thread_pool_;
+    std::uint64_t                               random_seed_;
+    std::uint64_t                               state_iterations_;
+    std::uint64_t                               resamplings_;
+    std::uint64_t                               version_;
+    std::vector<std::shared_ptr<sample_vector_t>> spare_buffers_;
+    mutable Histogram                           density_histogram_;
+    mutable typename sample_estimator_t::Ptr    estimator_;
+    mutable bool                                estimate_valid_;
+    std::uint64_t                               estimation_version_;
+    double                                      kld_error_;
+    double                                      kld_z_;
+    std::size_t                                 kld_bins_;
+    std::size_t                                 kld_sample_size_;
+    std::size_t                                 extension_begin_;   /// samples appended by SampleInsertion::extend
+    std::size_t                                 extension_end_;
+    std::vector<weight_distribution_t>          extension_distributions_;
+    std::vector<typename sample_estimator_t::Ptr> extension_estimators_;
+    std::unique_ptr<AsyncWorker>                density_worker_;    /// declared last, it is joined first
+
+    /**
+     * @brief Grant write access to the samples. If a snapshot still holds the current
+     *        buffer, the samples are copied into another one first.
+     */
+    inline sample_vector_t & writable()
+    {
+        ++version_;
+        if (p_t_1_.use_count() > 1) {
+            std::shared_ptr<sample_vector_t> buffer = acquireBuffer();
+            *buffer = *p_t_1_;
+            spare_buffers_.emplace_back(p_t_1_);
+            p_t_1_ = buffer;
+        } else {
+            /// synchronize with the release of the last snapshot
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *p_t_1_;
+    }
+
+    /**
+     * @brief Grant write access to an iteration, which visits every sample. If a snapshot
+     *        still holds the current buffer, the iteration writes to another one and the
+     *        returned rotation copies the samples into it while they are visited.
+     * @return the rotation, or nullptr if the samples can be written in place
+     */
+    inline typename rotation_t::Ptr rotate()
+    {
+        ++version_;
+        if (p_t_1_.use_count() > 1) {
+            std::shared_ptr<sample_vector_t> buffer = acquireBuffer();
+            buffer->resize(p_t_1_->size());
+            const typename rotation_t::Ptr rotation(new rotation_t(*buffer, p_t_1_, 0, p_t_1_->size()));
+            spare_buffers_.emplace_back(p_t_1_);
+            p_t_1_ = buffer;
+            return rotation;
+        }
+        /// synchronize with the release of the last snapshot
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return nullptr;
+    }
+
+    /**
+     * @brief The insertion buffer, replaced by a recycled one if a snapshot or the density
+     *        helper still holds it.
+     */
+    inline sample_vector_t & insertionBuffer()
+    {
+        if (!p_t_ || p_t_.use_count() > 1) {
+            if (p_t_)
+                spare_buffers_.emplace_back(p_t_);
+            p_t_ = acquireBuffer();
+        } else {
+            /// synchronize with the release of the last snapshot
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *p_t_;
+    }
+
+    /**
+     * @brief A buffer no snapshot refers to anymore, or a new one.
+     */
+    inline std::shared_ptr<sample_vector_t> acquireBuffer()
+    {
+        for (auto it = spare_buffers_.begin() ; it != spare_buffers_.end() ; ++it) {
+            if (it->use_count() == 1) {
+                /// synchronize with the release of the last snapshot
+                std::atomic_thread_fence(std::memory_order_acquire);
+                std::shared_ptr<sample_vector_t> buffer = std::move(*it);
+                spare_buffers_.erase(it);
+                return buffer;
+            }
+        }
+        return std::shared_ptr<sample_vector_t>(new sample_vector_t(0, maximum_sample_size_));
+    }
 
     inline void weightStatisticReset()
     {
@@ -274,8 +733,27 @@ private:
         weight_sum_     = 0.0;
     }
 
+    inline void weightIterationTouched()
+    {
+        weightStatisticReset();
+        estimate_valid_ = false;
+        if (log_weights_) {
+            weight_kernels_t::logarithm(*p_t_1_);
+            weights_in_log_domain_ = true;
+        }
+    }
+
+    inline void weightIterationFinished(const WeightDistribution &distribution)
+    {
+        weight_sum_     = distribution.getSum();
+        minimum_weight_ = distribution.getMinimum();
+        maximum_weight_ = distribution.getMaximum();
+        normalizeWeights();
+    }
+
     inline void weightUpdate(const double weight)
     {
+        weight_distribution_.add(weight);
         weight_sum_    += weight;
         maximum_weight_ = weight > maximum_weight_ ? weight : maximum_weight_;
         minimum_weight_ = weight < minimum_weight_ ? weight : minimum_weight_;
@@ -284,15 +762,241 @@ private:
     inline void insertionUpdate(const sample_t &sample)
     {
         weightUpdate(sample.weight);
-        p_t_1_density_->insert(sample);
+        /// KLD sampling needs the histogram while inserting, otherwise samples are inserted in blocks when closing
+        if (kld_error_ > 0.0)
+            p_t_1_density_->insert(sample);
+        if (estimator_)
+            estimator_->insert(sample.state, sample.weight);
+        if (kld_error_ > 0.0)
+            kldUpdate();
+    }
+
+    /**
+     * @brief Normalize the weights and gather their statistics in the same pass.
+     * @param kernel    - kernel(data, begin, end) normalizes a range and returns its distribution
+     */
+    template<typename kernel_t>
+    inline void normalizeBlocks(const kernel_t &kernel)
+    {
+        /// scaling keeps a valid estimate valid
+        if (estimator_ && !estimate_valid_)
+            weight_distribution_ = normalizeEstimate(kernel);
+        else
+            weight_distribution_ = kernel(*p_t_1_, 0, p_t_1_->size());
+        minimum_weight_ = weight_distribution_.getMinimum();
+        maximum_weight_ = weight_distribution_.getMaximum();
+        weight_sum_     = 1.0;
+    }
+
+    /**
+     * @brief Normalize the weights block wise and feed the estimator each block right after
+     *        it was normalized, partial estimators of the blocks are merged in order.
+     * @param kernel    - see normalizeBlocks
+     * @return the distribution of the normalized weights
+     */
+    template<typename kernel_t>
+    inline weight_distribution_t normalizeEstimate(const kernel_t &kernel)
+    {
+        /// samples per block, weights and states of a block stay in cache between both passes
+        static constexpr std::size_t block_size = 4096;
+
+        sample_vector_t &p_t_1 = *p_t_1_;
+        const std::size_t size   = p_t_1.size();
+        const std::size_t blocks = (size + block_size - 1) / block_size;
+
+        weight_distribution_t distribution;
+        typename sample_estimator_t::Ptr partial;
+        if (thread_pool_ && thread_pool_->size() > 1 && blocks > 1)
+            partial = estimator_->partial();
+
+        if (partial) {
+            std::vector<typename sample_estimator_t::Ptr> estimators(blocks);
+            std::vector<weight_distribution_t>            distributions(blocks);
+            estimators.front() = partial;
+            for (std::size_t b = 1 ; b < blocks ; ++b)
+                estimators[b] = estimator_->partial();
+
+            thread_pool_->parallelFor(blocks, [&p_t_1, &estimators, &distributions, &kernel, size](const std::size_t b) {
+                const std::size_t begin = b * block_size;
+                const std::size_t end   = std::min(size, begin + block_size);
+                distributions[b] = kernel(p_t_1, begin, end);
+                for (std::size_t i = begin ; i < end ; ++i)
+                    estimators[b]->insert(p_t_1.state(i), p_t_1.weight(i));
+            });
+
+            estimator_->clear();
+            for (std::size_t b = 0 ; b < blocks ; ++b) {
+                distribution += distributions[b];
+                estimator_->merge(*estimators[b]);
+            }
+        } else {
+            estimator_->clear();
+            for (std::size_t begin = 0 ; begin < size ; begin += block_size) {
+                const std::size_t end = std::min(size, begin + block_size);
+                distribution += kernel(p_t_1, begin, end);
+                for (std::size_t i = begin ; i < end ; ++i)
+                    estimator_->insert(p_t_1.state(i), p_t_1.weight(i));
+            }
+        }
+        estimator_->estimate();
+        estimate_valid_ = true;
+        return distribution;
+    }
+
+    inline void estimationFinished()
+    {
+        /// the samples were not written since the iteration was handed out
+        estimate_valid_ = estimation_version_ == version_;
+    }
+
+    inline void estimatorReset()
+    {
+        if (estimator_)
+            estimator_->clear();
+        estimate_valid_ = false;
+    }
+
+    inline void waitDensity() const
+    {
+        if (density_worker_)
+            density_worker_->wait();
+    }
+
+    inline void kldReset()
+    {
+        kld_bins_        = 0;
+        kld_sample_size_ = 0;
+    }
+
+    inline void kldUpdate()
+    {
+        /// the bound only changes with the amount of occupied bins
+        const std::size_t k = p_t_1_density_->histogramSize();
+        if (k == kld_bins_)
+            return;
+
+        kld_bins_ = k;
+        if (k < 2) {
+            kld_sample_size_ = 0;
+            return;
+        }
+
+        const double a = 2.0 / (9.0 * static_cast<double>(k - 1));
+        const double b = 1.0 - a + std::sqrt(a) * kld_z_;
+        kld_sample_size_ = static_cast<std::size_t>(std::ceil(static_cast<double>(k - 1) / (2.0 * kld_error_) * b * b * b));
+    }
+
+    /**
+     * @brief Prepare the statistics of the blocks an extension is committed in, every
+     *        block gets a partial estimator if the estimator supports them.
+     */
+    inline void insertionExtended(const std::size_t begin,
+                                  const std::size_t end,
+                                  const std::size_t blocks)
+    {
+        extensionMerge();
+        extension_begin_ = begin;
+        extension_end_   = end;
+        extension_distributions_.assign(blocks, weight_distribution_t());
+        extension_estimators_.assign(blocks, nullptr);
+        if (estimator_) {
+            for (typename sample_estimator_t::Ptr &e : extension_estimators_)
+                e = estimator_->partial();
+        }
+    }
+
+    /**
+     * @brief Gather the statistics of a committed block, blocks are committed concurrently.
+     */
+    inline void insertionCommitted(const std::size_t block,
+                                   const std::size_t begin,
+                                   const std::size_t end)
+    {
+        const sample_vector_t &p_t = *p_t_;
+        extension_distributions_[block] = weight_kernels_t::reduce(p_t, begin, end);
+        if (const typename sample_estimator_t::Ptr &estimator = extension_estimators_[block]) {
+            for (std::size_t i = begin ; i < end ; ++i)
+                estimator->insert(p_t.state(i), p_t.weight(i));
+        }
+    }
+
+    /**
+     * @brief Merge the statistics of the committed blocks in block order.
+     */
+    inline void extensionMerge()
+    {
+        if (extension_begin_ == extension_end_)
+            return;
+
+        const sample_vector_t &p_t = *p_t_;
+        for (const weight_distribution_t &d : extension_distributions_) {
+            if (d.getN() == 0)
+                continue;
+            weight_distribution_ += d;
+            weight_sum_    += d.getSum();
+            maximum_weight_ = std::max(maximum_weight_, d.getMaximum());
+            minimum_weight_ = std::min(minimum_weight_, d.getMinimum());
+        }
+        if (estimator_) {
+            if (!extension_estimators_.empty() && extension_estimators_.front()) {
+                for (const typename sample_estimator_t::Ptr &e : extension_estimators_)
+                    estimator_->merge(*e);
+            } else {
+                for (std::size_t i = extension_begin_ ; i < extension_end_ ; ++i)
+                    estimator_->insert(p_t.state(i), p_t.weight(i));
+            }
+        }
+        /// the histogram is not mergeable, the block is binned at once and the bound is evaluated once
+        if (kld_error_ > 0.0) {
+            for (std::size_t i = extension_begin_ ; i < extension_end_ ; ++i)
+                p_t_1_density_->insert(p_t[i]);
+            kldUpdate();
+        }
+
+        extension_begin_ = extension_end_ = 0;
+        extension_distributions_.clear();
+        extension_estimators_.clear();
     }
 
     inline void insertionClosedReset()
     {
+        extensionMerge();
         std::swap(p_t_, p_t_1_);
-        p_t_1_density_->estimate();
+        insertionClosed();
+    }
+
+    inline void insertionClosed()
+    {
+        if (estimator_) {
+            estimator_->estimate();
+            estimate_valid_ = true;
+        }
+
+        /// both paths insert normalized weights into the density
         if(keep_weights_after_insertion_)
             normalizeWeights();
+
+        const bool insert = kld_error_ <= 0.0;
+        if (!density_worker_) {
+            Histogram::Timer timer(density_histogram_);
+            if (insert)
+                density_insertion_t::apply(*p_t_1_, *p_t_1_density_);
+            p_t_1_density_->estimate();
+            return;
+        }
+
+        /// the helper shares the buffer, writable only copies if it still runs at the next write
+        std::shared_ptr<const sample_vector_t> samples;
+        if (insert)
+            samples = p_t_1_;
+        const typename sample_density_t::Ptr density = p_t_1_density_;
+        Histogram                           &timing  = density_histogram_;
+        density_worker_->submit([samples, density, insert, &timing]() {
+            Histogram::Timer timer(timing);
+            if (insert)
+                density_insertion_t::apply(*samples, *density);
+            density->estimate();
+        });
     }
 };
 }
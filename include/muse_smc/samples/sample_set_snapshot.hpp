@@ -0,0 +1,125 @@
+#ifndef SAMPLE_SET_SNAPSHOT_HPP
+#define SAMPLE_SET_SNAPSHOT_HPP
+
+#include <string>
+#include <memory>
+#include <cstdint>
+
+#include <cslibs_time/time.hpp>
+
+#include <muse_smc/samples/sample_storage.hpp>
+#include <muse_smc/samples/sample_weight_distribution.hpp>
+
+namespace muse_smc {
+/**
+ * @brief The SampleSetSnapshot class is an immutable, versioned view of a sample set.
+ *        It shares the sample buffer with the set, taking and copying a snapshot only
+ *        touches a reference count. The set continues on another buffer, when it is
+ *        modified while a snapshot is alive, and recycles the buffer once all snapshots
+ *        holding it are released. Snapshots may be passed to and read by any thread.
+ */
+template<typename state_space_description_t>
+class SampleSetSnapshot
+{
+public:
+    using sample_t              = typename state_space_description_t::sample_t;
+    using sample_storage_t      = typename SampleStorageTraits<state_space_description_t>::storage_t;
+    using sample_vector_t       = sample_storage_t;
+    using weight_distribution_t = WeightDistribution;
+
+    inline SampleSetSnapshot() :
+        version_(0),
+        weight_sum_(0.0)
+    {
+    }
+
+    inline SampleSetSnapshot(const std::string                            &frame_id,
+                             const cslibs_time::Time                      &stamp,
+                             const std::uint64_t                           version,
+                             const std::shared_ptr<const sample_vector_t> &samples,
+                             const weight_distribution_t                  &weight_distribution,
+                             const double                                  weight_sum) :
+        frame_id_(frame_id),
+        stamp_(stamp),
+        version_(version),
+        samples_(samples),
+        weight_distribution_(weight_distribution),
+        weight_sum_(weight_sum)
+    {
+    }
+
+    /**
+     * @brief False for a default constructed snapshot.
+     */
+    inline bool valid() const
+    {
+        return static_cast<bool>(samples_);
+    }
+
+    inline std::string const & getFrame() const
+    {
+        return frame_id_;
+    }
+
+    inline cslibs_time::Time const & getStamp() const
+    {
+        return stamp_;
+    }
+
+    /**
+     * @brief The version of the sample set, it grows whenever the set is modified.
+     */
+    inline std::uint64_t getVersion() const
+    {
+        return version_;
+    }
+
+    inline sample_vector_t const & getSamples() const
+    {
+        return *samples_;
+    }
+
+    inline std::size_t getSampleSize() const
+    {
+        return samples_ ? samples_->size() : 0;
+    }
+
+    /**
+     * @brief The weight statistics at the time of the snapshot, see SampleSet::getWeightDistribution.
+     */
+    inline weight_distribution_t const & getWeightDistribution() const
+    {
+        return weight_distribution_;
+    }
+
+    inline double getWeightSum() const
+    {
+        return weight_sum_;
+    }
+
+    inline double getMinimumWeight() const
+    {
+        return weight_distribution_.getMinimum();
+    }
+
+    inline double getMaximumWeight() const
+    {
+        return weight_distribution_.getMaximum();
+    }
+
+    inline double getEffectiveSampleSize() const
+    {
+        return weight_distribution_.getEffectiveSampleSize();
+    }
+
+private:
+    std::string                            frame_id_;
+    cslibs_time::Time                      stamp_;
+    std::uint64_t                          version_;
+    std::shared_ptr<const sample_vector_t> samples_;
+    weight_distribution_t                  weight_distribution_;
+    double                                 weight_sum_;
+};
+}
+
+#endif // SAMPLE_SET_SNAPSHOT_HPP
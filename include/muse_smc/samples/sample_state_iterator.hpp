@@ -1,35 +1,60 @@
 #ifndef SAMPLE_STATE_ITERATOR_HPP
 #define SAMPLE_STATE_ITERATOR_HPP
 
-#include <cslibs_utility/buffered/buffered_vector.hpp>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <algorithm>
+
 #include <cslibs_time/time.hpp>
 
+#include <muse_smc/samples/sample_storage.hpp>
+#include <muse_smc/samples/sample_rotation.hpp>
+#include <muse_smc/samples/sample_estimation.hpp>
+#include <muse_smc/utility/thread_pool.hpp>
+#include <muse_smc/utility/random_seed.hpp>
+
 namespace muse_smc {
 template<typename state_space_description_t>
 class StateIterator : public std::iterator<std::random_access_iterator_tag, typename state_space_description_t::state_t>
 {
 public:
-    using parent    = std::iterator<std::random_access_iterator_tag, typename state_space_description_t::state_t>;
-    using sample_t  = typename state_space_description_t::sample_t;
-    using iterator  = typename parent::iterator;
-    using reference = typename parent::reference;
-
-    inline explicit StateIterator(sample_t *begin) :
-        data_(begin)
+    using parent           = std::iterator<std::random_access_iterator_tag, typename state_space_description_t::state_t>;
+    using sample_t         = typename state_space_description_t::sample_t;
+    using sample_storage_t = typename SampleStorageTraits<state_space_description_t>::storage_t;
+    using rotation_t       = SampleRotation<sample_storage_t>;
+    using part_t           = typename SampleEstimation<sample_t>::Part;
+    using reference        = typename parent::reference;
+
+    inline explicit StateIterator(sample_storage_t  *data,
+                                  const std::size_t  index,
+                                  rotation_t        *rotation = nullptr,
+                                  part_t            *estimation = nullptr) :
+        data_(data),
+        index_(index),
+        rotation_(rotation),
+        estimation_(estimation)
     {
+        if(rotation_)
+            rotation_->reach(index_);
     }
 
     virtual ~StateIterator() = default;
 
-    inline iterator& operator++()
+    inline StateIterator& operator++()
     {
-        ++data_;
+        /// the sample is left, it is final
+        if(estimation_)
+            estimation_->insert(data_->state(index_), data_->weight(index_));
+        ++index_;
+        if(rotation_)
+            rotation_->reach(index_);
         return *this;
     }
 
     inline bool operator ==(const StateIterator<state_space_description_t> &_other) const
     {
-        return data_ == _other.data_;
+        return index_ == _other.index_;
     }
 
     inline bool operator !=(const StateIterator<state_space_description_t> &_other) const
@@ -39,16 +64,19 @@ public:
 
     inline reference operator *() const
     {
-        return data_->state;
+        return data_->state(index_);
     }
 
     inline double weight() const
     {
-        return data_->weight;
+        return data_->weight(index_);
     }
 
 private:
-    sample_t        *data_;
+    sample_storage_t *data_;
+    std::size_t       index_;
+    rotation_t       *rotation_;
+    part_t           *estimation_;
 };
 
 template<typename state_space_description_t>
@@ -56,14 +84,39 @@ class StateIteration
 {
 public:
     using sample_t          = typename state_space_description_t::sample_t;
-    using sample_vector_t   = cslibs_utility::buffered::buffered_vector<sample_t, typename sample_t::allocator_t>;
+    using sample_storage_t  = typename SampleStorageTraits<state_space_description_t>::storage_t;
+    using sample_vector_t   = sample_storage_t;
     using iterator_t        = StateIterator<state_space_description_t>;
+    using rotation_t        = SampleRotation<sample_storage_t>;
+    using estimation_t      = SampleEstimation<sample_t>;
     using time_t            = cslibs_time::Time;
-
-    inline StateIteration(const time_t &stamp,
-                          sample_vector_t &data) :
+    using random_engine_t   = std::mt19937_64;
+    using partitions_t      = std::vector<StateIteration>;
+
+    /**
+     * @brief StateIteration constructor.
+     * @param stamp         - the time stamp of the samples
+     * @param data          - the samples to propagate
+     * @param seed          - seed of the random streams handed to models
+     * @param thread_pool   - optional thread pool partitions can be dispatched to
+     * @param rotation      - optional rotation, if the samples are still to be copied into data
+     * @param estimation    - optional estimation, which is fed the samples once they are left
+     */
+    inline StateIteration(const time_t                     &stamp,
+                          sample_vector_t                  &data,
+                          const std::uint64_t               seed = 0,
+                          const ThreadPool::Ptr            &thread_pool = nullptr,
+                          const typename rotation_t::Ptr   &rotation = nullptr,
+                          const typename estimation_t::Ptr &estimation = nullptr) :
         stamp_(stamp),
-        data_(data)
+        data_(data),
+        begin_(0),
+        end_(data.size()),
+        seed_(seed),
+        thread_pool_(thread_pool),
+        rotation_(rotation),
+        estimation_(estimation),
+        part_(estimation ? estimation->part(0) : nullptr)
     {
     }
 
@@ -73,15 +126,65 @@ public:
 
     inline iterator_t begin()
     {
-        return iterator_t(&(*data_.begin()));
+        return iterator_t(&data_, begin_, rotation_.get(), part_);
     }
 
     inline iterator_t end() {
-        return iterator_t(&(*data_.end()));
+        return iterator_t(&data_, end_, rotation_.get(), part_);
+    }
+
+    /**
+     * @brief Split the iteration into partitions of a fixed amount of samples, which
+     *        may be propagated concurrently. Every partition carries its own seed
+     *        derived from its index, therefore results do not depend on the amount
+     *        of threads involved.
+     * @param partition_size    - the amount of samples per partition
+     * @return the partitions
+     */
+    inline partitions_t partition(const std::size_t partition_size) const
+    {
+        const std::size_t size  = end_ - begin_;
+        const std::size_t step  = std::max(static_cast<std::size_t>(1), partition_size);
+        const std::size_t parts = std::max(static_cast<std::size_t>(1), (size + step - 1) / step);
+
+        bool estimate = false;
+        if(estimation_) {
+            std::vector<std::size_t> sizes(parts);
+            for(std::size_t i = 0 ; i < parts ; ++i)
+                sizes[i] = std::min(size, (i + 1) * step) - std::min(size, i * step);
+            estimate = estimation_->split(sizes);
+            part_ = nullptr;
+        }
+
+        partitions_t partitions;
+        partitions.reserve(parts);
+        for(std::size_t i = 0 ; i < parts ; ++i) {
+            const std::size_t begin = begin_ + std::min(size, i * step);
+            const std::size_t end   = begin_ + std::min(size, (i + 1) * step);
+            partitions.push_back(StateIteration(stamp_,
+                                                data_,
+                                                begin,
+                                                end,
+                                                random_seed::derive(seed_, i),
+                                                rotation_ ? rotation_->split(begin, end) : nullptr,
+                                                estimation_,
+                                                estimate ? estimation_->part(i) : nullptr));
+        }
+        /// each partition copies its own samples
+        if(rotation_)
+            rotation_->release();
+        return partitions;
+    }
+
+    inline std::size_t size() const
+    {
+        return end_ - begin_;
     }
 
     inline const sample_vector_t& getData() const
     {
+        if(rotation_)
+            rotation_->complete();
         return data_;
     }
 
@@ -90,11 +193,62 @@ public:
         return stamp_;
     }
 
-private:
-    const time_t     stamp_;
-    sample_vector_t &data_;
+    /**
+     * @brief The seed models should use for sampling noise on this iteration.
+     */
+    inline std::uint64_t getSeed() const
+    {
+        return seed_;
+    }
 
+    /**
+     * @brief Create a random engine seeded for this iteration.
+     */
+    inline random_engine_t getRandomEngine() const
+    {
+        return random_engine_t(seed_);
+    }
 
+    /**
+     * @brief The thread pool partitions may be dispatched to, can be empty.
+     */
+    inline const ThreadPool::Ptr & getThreadPool() const
+    {
+        return thread_pool_;
+    }
+
+private:
+    const time_t                         stamp_;
+    sample_vector_t                     &data_;
+    std::size_t                          begin_;
+    std::size_t                          end_;
+    std::uint64_t                        seed_;
+    ThreadPool::Ptr                      thread_pool_;
+    typename rotation_t::Ptr             rotation_;
+    typename estimation_t::Ptr           estimation_;
+    mutable typename estimation_t::Part *part_;     /// the part this iteration feeds, reset once partitioned
+
+    /**
+     * @brief Partition constructor.
+     */
+    inline StateIteration(const time_t                     &stamp,
+                          sample_vector_t                  &data,
+                          const std::size_t                 begin,
+                          const std::size_t                 end,
+                          const std::uint64_t               seed,
+                          const typename rotation_t::Ptr   &rotation,
+                          const typename estimation_t::Ptr &estimation,
+                          typename estimation_t::Part      *part) :
+        stamp_(stamp),
+        data_(data),
+        begin_(begin),
+        end_(end),
+        seed_(seed),
+        rotation_(rotation),
+        estimation_(estimation),
+        part_(part)
+    {
+    }
 };
 }
 
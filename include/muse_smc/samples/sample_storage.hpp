@@ -0,0 +1,36 @@
+#ifndef SAMPLE_STORAGE_HPP
+#define SAMPLE_STORAGE_HPP
+
+#include <muse_smc/samples/sample_storage_aos.hpp>
+#include <muse_smc/samples/sample_storage_soa.hpp>
+
+namespace muse_smc {
+namespace detail {
+template<typename T>
+struct void_type
+{
+    using type = void;
+};
+}
+
+/**
+ * @brief The SampleStorageTraits select the storage policy of a sample set.
+ *        A state space description may choose a storage by defining
+ *        sample_storage_t, e.g. using sample_storage_t = SampleStorageSoA<sample_t>;
+ *        Otherwise samples are stored as array of structures.
+ */
+template<typename state_space_description_t, typename = void>
+struct SampleStorageTraits
+{
+    using storage_t = SampleStorageAoS<typename state_space_description_t::sample_t>;
+};
+
+template<typename state_space_description_t>
+struct SampleStorageTraits<state_space_description_t,
+                           typename detail::void_type<typename state_space_description_t::sample_storage_t>::type>
+{
+    using storage_t = typename state_space_description_t::sample_storage_t;
+};
+}
+
+#endif // SAMPLE_STORAGE_HPP
@@ -0,0 +1,280 @@
+#ifndef SAMPLE_STORAGE_AOS_HPP
+#define SAMPLE_STORAGE_AOS_HPP
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+namespace muse_smc {
+/**
+ * @brief The SampleStorageAoS class stores samples as an array of structures.
+ *        This is the default storage, samples are kept as they are. Cleared samples
+ *        stay constructed, so that refilling a recycled buffer only assigns them,
+ *        like the cslibs_utility buffered_vector it replaces. Code which used
+ *        buffered_vector members beyond this interface has to be ported.
+ *        Weights are interleaved with states, so passes over the weights run
+ *        scalar loops. Use SampleStorageSoA for the vectorized weight kernels.
+ */
+template<typename sample_t>
+class SampleStorageAoS
+{
+public:
+    using state_t           = typename sample_t::state_t;
+    using allocator_t       = typename sample_t::allocator_t;
+    using vector_t          = std::vector<sample_t, allocator_t>;
+    using iterator          = typename vector_t::iterator;
+    using const_iterator    = typename vector_t::const_iterator;
+    using reference         = sample_t &;
+    using const_reference   = const sample_t &;
+
+    /**
+     * @brief The Span class gives raw access to a contiguous range of samples.
+     */
+    class Span
+    {
+    public:
+        inline Span(sample_t          *samples,
+                    const std::size_t  size) :
+            samples_(samples),
+            size_(size)
+        {
+        }
+
+        inline std::size_t size() const
+        {
+            return size_;
+        }
+
+        inline sample_t * samples() const
+        {
+            return samples_;
+        }
+
+        inline double & weight(const std::size_t i) const
+        {
+            return samples_[i].weight;
+        }
+
+        inline state_t & state(const std::size_t i) const
+        {
+            return samples_[i].state;
+        }
+
+    private:
+        sample_t    *samples_;
+        std::size_t  size_;
+    };
+    using span_t = Span;
+
+    /**
+     * @brief SampleStorageAoS constructor.
+     * @param size      - initial amount of default constructed samples
+     * @param capacity  - maximum amount of samples, memory is reserved once
+     */
+    inline explicit SampleStorageAoS(const std::size_t size     = 0,
+                                     const std::size_t capacity = 0) :
+        size_(size),
+        capacity_(capacity)
+    {
+        data_.reserve(capacity_);
+        data_.resize(size);
+    }
+
+    inline SampleStorageAoS(const SampleStorageAoS &other) :
+        size_(other.size_),
+        capacity_(other.capacity_)
+    {
+        data_.reserve(std::max(capacity_, size_));
+        data_.assign(other.begin(), other.end());
+    }
+
+    inline SampleStorageAoS(SampleStorageAoS &&other) :
+        data_(std::move(other.data_)),
+        size_(other.size_),
+        capacity_(other.capacity_)
+    {
+        other.data_.clear();
+        other.size_ = 0;
+    }
+
+    /**
+     * @brief Copy the samples of another storage, samples kept constructed are assigned.
+     */
+    inline SampleStorageAoS& operator = (const SampleStorageAoS &other)
+    {
+        if(this != &other) {
+            resize(other.size_);
+            std::copy(other.begin(), other.end(), begin());
+        }
+        return *this;
+    }
+
+    inline SampleStorageAoS& operator = (SampleStorageAoS &&other)
+    {
+        if(this != &other) {
+            data_     = std::move(other.data_);
+            size_     = other.size_;
+            capacity_ = other.capacity_;
+            other.data_.clear();
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    inline std::size_t size() const
+    {
+        return size_;
+    }
+
+    inline std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    inline bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    /**
+     * @brief Drop all samples, they stay constructed to be assigned by the next fill.
+     */
+    inline void clear()
+    {
+        size_ = 0;
+    }
+
+    /**
+     * @brief Resize the storage, only samples which were never constructed are default
+     *        constructed. Others keep their previous value until they are assigned.
+     */
+    inline void resize(const std::size_t size)
+    {
+        if(size > data_.size())
+            data_.resize(size);
+        size_ = size;
+    }
+
+    inline void push_back(const sample_t &sample)
+    {
+        if(size_ < data_.size())
+            data_[size_] = sample;
+        else
+            data_.push_back(sample);
+        ++size_;
+    }
+
+    /**
+     * @brief Append sample j of another storage.
+     */
+    inline void push_back(const SampleStorageAoS &other,
+                          const std::size_t       j)
+    {
+        push_back(other.data_[j]);
+    }
+
+    inline void emplace_back(sample_t &&sample)
+    {
+        if(size_ < data_.size())
+            data_[size_] = std::move(sample);
+        else
+            data_.emplace_back(std::move(sample));
+        ++size_;
+    }
+
+    inline reference back()
+    {
+        return data_[size_ - 1];
+    }
+
+    inline const_reference back() const
+    {
+        return data_[size_ - 1];
+    }
+
+    inline reference operator [] (const std::size_t i)
+    {
+        return data_[i];
+    }
+
+    inline const_reference operator [] (const std::size_t i) const
+    {
+        return data_[i];
+    }
+
+    inline double & weight(const std::size_t i)
+    {
+        return data_[i].weight;
+    }
+
+    inline double weight(const std::size_t i) const
+    {
+        return data_[i].weight;
+    }
+
+    inline state_t & state(const std::size_t i)
+    {
+        return data_[i].state;
+    }
+
+    inline const state_t & state(const std::size_t i) const
+    {
+        return data_[i].state;
+    }
+
+    /**
+     * @brief Copy sample j of another storage to index i.
+     */
+    inline void copy(const std::size_t       i,
+                     const SampleStorageAoS &other,
+                     const std::size_t       j)
+    {
+        data_[i] = other.data_[j];
+    }
+
+    /**
+     * @brief Move sample j to index i.
+     */
+    inline void move(const std::size_t i,
+                     const std::size_t j)
+    {
+        data_[i] = std::move(data_[j]);
+    }
+
+    /**
+     * @brief Access the samples in [begin, end) as a span.
+     */
+    inline span_t span(const std::size_t begin,
+                       const std::size_t end)
+    {
+        return span_t(data_.data() + begin, end - begin);
+    }
+
+    inline iterator begin()
+    {
+        return data_.begin();
+    }
+
+    inline iterator end()
+    {
+        return data_.begin() + size_;
+    }
+
+    inline const_iterator begin() const
+    {
+        return data_.begin();
+    }
+
+    inline const_iterator end() const
+    {
+        return data_.begin() + size_;
+    }
+
+private:
+    vector_t    data_;      /// constructed samples, the first size_ are valid
+    std::size_t size_;
+    std::size_t capacity_;
+};
+}
+
+#endif // SAMPLE_STORAGE_AOS_HPP
@@ -0,0 +1,362 @@
+#ifndef SAMPLE_STORAGE_SOA_HPP
+#define SAMPLE_STORAGE_SOA_HPP
+
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <cstddef>
+#include <algorithm>
+
+namespace muse_smc {
+/**
+ * @brief The SampleStorageSoA class stores samples as a structure of arrays.
+ *        Weights are kept in one contiguous array, states in another one,
+ *        so that passes over the weights do not have to touch the states.
+ *        Samples are only assembled on demand, therefore sample_t has to be
+ *        constructible from a state and a weight. Cleared states stay constructed,
+ *        so that refilling a recycled buffer only assigns them.
+ */
+template<typename sample_t>
+class SampleStorageSoA
+{
+public:
+    using state_t           = typename sample_t::state_t;
+    using allocator_t       = typename sample_t::allocator_t;
+    using state_allocator_t = typename std::allocator_traits<allocator_t>::template rebind_alloc<state_t>;
+    using state_vector_t    = std::vector<state_t, state_allocator_t>;
+    using weight_vector_t   = std::vector<double>;
+    using reference         = sample_t;
+    using const_reference   = sample_t;
+
+    /**
+     * @brief The Span class gives raw access to a contiguous range of samples,
+     *        weights and states are separate arrays.
+     */
+    class Span
+    {
+    public:
+        inline Span(double            *weights,
+                    state_t           *states,
+                    const std::size_t  size) :
+            weights_(weights),
+            states_(states),
+            size_(size)
+        {
+        }
+
+        inline std::size_t size() const
+        {
+            return size_;
+        }
+
+        inline double * weights() const
+        {
+            return weights_;
+        }
+
+        inline state_t * states() const
+        {
+            return states_;
+        }
+
+        inline double & weight(const std::size_t i) const
+        {
+            return weights_[i];
+        }
+
+        inline state_t & state(const std::size_t i) const
+        {
+            return states_[i];
+        }
+
+    private:
+        double      *weights_;
+        state_t     *states_;
+        std::size_t  size_;
+    };
+    using span_t = Span;
+
+    /**
+     * @brief The const_iterator class assembles samples while iterating.
+     */
+    class const_iterator : public std::iterator<std::forward_iterator_tag, sample_t>
+    {
+    public:
+        inline const_iterator(const SampleStorageSoA *data,
+                              const std::size_t       index) :
+            data_(data),
+            index_(index)
+        {
+        }
+
+        inline const_iterator& operator++()
+        {
+            ++index_;
+            return *this;
+        }
+
+        inline bool operator ==(const const_iterator &other) const
+        {
+            return index_ == other.index_;
+        }
+
+        inline bool operator !=(const const_iterator &other) const
+        {
+            return !(*this == other);
+        }
+
+        inline sample_t operator *() const
+        {
+            return (*data_)[index_];
+        }
+
+    private:
+        const SampleStorageSoA *data_;
+        std::size_t             index_;
+    };
+
+    /**
+     * @brief SampleStorageSoA constructor.
+     * @param size      - initial amount of default constructed samples
+     * @param capacity  - maximum amount of samples, memory is reserved once
+     */
+    inline explicit SampleStorageSoA(const std::size_t size     = 0,
+                                     const std::size_t capacity = 0) :
+        size_(0),
+        capacity_(capacity)
+    {
+        states_.reserve(capacity_);
+        weights_.reserve(capacity_);
+        resize(size);
+    }
+
+    inline SampleStorageSoA(const SampleStorageSoA &other) :
+        size_(other.size_),
+        capacity_(other.capacity_)
+    {
+        states_.reserve(std::max(capacity_, size_));
+        weights_.reserve(std::max(capacity_, size_));
+        states_.assign(other.states_.begin(), other.states_.begin() + size_);
+        weights_.assign(other.weights_.begin(), other.weights_.begin() + size_);
+    }
+
+    inline SampleStorageSoA(SampleStorageSoA &&other) :
+        states_(std::move(other.states_)),
+        weights_(std::move(other.weights_)),
+        size_(other.size_),
+        capacity_(other.capacity_)
+    {
+        other.states_.clear();
+        other.weights_.clear();
+        other.size_ = 0;
+    }
+
+    /**
+     * @brief Copy the samples of another storage, states kept constructed are assigned.
+     */
+    inline SampleStorageSoA& operator = (const SampleStorageSoA &other)
+    {
+        if(this != &other) {
+            resize(other.size_);
+            std::copy(other.states_.begin(),  other.states_.begin()  + size_, states_.begin());
+            std::copy(other.weights_.begin(), other.weights_.begin() + size_, weights_.begin());
+        }
+        return *this;
+    }
+
+    inline SampleStorageSoA& operator = (SampleStorageSoA &&other)
+    {
+        if(this != &other) {
+            states_   = std::move(other.states_);
+            weights_  = std::move(other.weights_);
+            size_     = other.size_;
+            capacity_ = other.capacity_;
+            other.states_.clear();
+            other.weights_.clear();
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    inline std::size_t size() const
+    {
+        return size_;
+    }
+
+    inline std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    inline bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    /**
+     * @brief Drop all samples, states stay constructed to be assigned by the next fill.
+     */
+    inline void clear()
+    {
+        size_ = 0;
+    }
+
+    /**
+     * @brief Resize the storage, only states which were never constructed are default
+     *        constructed with weight 1.0. Others keep their previous value until they
+     *        are assigned.
+     */
+    inline void resize(const std::size_t size)
+    {
+        if(size > weights_.size()) {
+            states_.resize(size);
+            weights_.resize(size, 1.0);
+        }
+        size_ = size;
+    }
+
+    inline void push_back(const sample_t &sample)
+    {
+        if(size_ < weights_.size()) {
+            states_[size_]  = sample.state;
+            weights_[size_] = sample.weight;
+        } else {
+            states_.push_back(sample.state);
+            weights_.push_back(sample.weight);
+        }
+        ++size_;
+    }
+
+    /**
+     * @brief Append sample j of another storage without assembling it.
+     */
+    inline void push_back(const SampleStorageSoA &other,
+                          const std::size_t       j)
+    {
+        if(size_ < weights_.size()) {
+            states_[size_]  = other.states_[j];
+            weights_[size_] = other.weights_[j];
+        } else {
+            states_.push_back(other.states_[j]);
+            weights_.push_back(other.weights_[j]);
+        }
+        ++size_;
+    }
+
+    inline void emplace_back(sample_t &&sample)
+    {
+        if(size_ < weights_.size()) {
+            states_[size_]  = std::move(sample.state);
+            weights_[size_] = sample.weight;
+        } else {
+            states_.emplace_back(std::move(sample.state));
+            weights_.push_back(sample.weight);
+        }
+        ++size_;
+    }
+
+    inline const_reference back() const
+    {
+        return (*this)[size() - 1];
+    }
+
+    inline const_reference operator [] (const std::size_t i) const
+    {
+        return sample_t(states_[i], weights_[i]);
+    }
+
+    inline double & weight(const std::size_t i)
+    {
+        return weights_[i];
+    }
+
+    inline double weight(const std::size_t i) const
+    {
+        return weights_[i];
+    }
+
+    inline state_t & state(const std::size_t i)
+    {
+        return states_[i];
+    }
+
+    inline const state_t & state(const std::size_t i) const
+    {
+        return states_[i];
+    }
+
+    /**
+     * @brief Copy sample j of another storage to index i.
+     */
+    inline void copy(const std::size_t       i,
+                     const SampleStorageSoA &other,
+                     const std::size_t       j)
+    {
+        states_[i]  = other.states_[j];
+        weights_[i] = other.weights_[j];
+    }
+
+    /**
+     * @brief Move sample j to index i.
+     */
+    inline void move(const std::size_t i,
+                     const std::size_t j)
+    {
+        states_[i]  = std::move(states_[j]);
+        weights_[i] = weights_[j];
+    }
+
+    /**
+     * @brief Access the samples in [begin, end) as a span.
+     */
+    inline span_t span(const std::size_t begin,
+                       const std::size_t end)
+    {
+        return span_t(weights_.data() + begin, states_.data() + begin, end - begin);
+    }
+
+    inline const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    inline const_iterator end() const
+    {
+        return const_iterator(this, size());
+    }
+
+    /**
+     * @brief Direct access to the contiguous weight array.
+     */
+    inline double * weights()
+    {
+        return weights_.data();
+    }
+
+    inline const double * weights() const
+    {
+        return weights_.data();
+    }
+
+    /**
+     * @brief Direct access to the contiguous state array.
+     */
+    inline state_t * states()
+    {
+        return states_.data();
+    }
+
+    inline const state_t * states() const
+    {
+        return states_.data();
+    }
+
+private:
+    state_vector_t  states_;    /// constructed states, the first size_ are valid
+    weight_vector_t weights_;
+    std::size_t     size_;
+    std::size_t     capacity_;
+};
+}
+
+#endif // SAMPLE_STORAGE_SOA_HPP
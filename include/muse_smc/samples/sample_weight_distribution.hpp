@@ -0,0 +1,127 @@
+#ifndef SAMPLE_WEIGHT_DISTRIBUTION_HPP
+#define SAMPLE_WEIGHT_DISTRIBUTION_HPP
+
+#include <limits>
+#include <cmath>
+#include <cstddef>
+
+namespace muse_smc {
+/**
+ * @brief The WeightDistribution class keeps the raw moments and extrema of a
+ *        set of sample weights. Distributions of disjoint sets can be merged,
+ *        which allows the moments to be computed in vectorized or partitioned passes.
+ */
+class WeightDistribution
+{
+public:
+    inline WeightDistribution() :
+        n_(0),
+        sum_(0.0),
+        sum_squared_(0.0),
+        minimum_(std::numeric_limits<double>::max()),
+        maximum_(std::numeric_limits<double>::lowest())
+    {
+    }
+
+    inline WeightDistribution(const std::size_t n,
+                              const double      sum,
+                              const double      sum_squared,
+                              const double      minimum,
+                              const double      maximum) :
+        n_(n),
+        sum_(sum),
+        sum_squared_(sum_squared),
+        minimum_(minimum),
+        maximum_(maximum)
+    {
+    }
+
+    inline void reset()
+    {
+        *this = WeightDistribution();
+    }
+
+    inline void add(const double weight)
+    {
+        ++n_;
+        sum_         += weight;
+        sum_squared_ += weight * weight;
+        minimum_      = weight < minimum_ ? weight : minimum_;
+        maximum_      = weight > maximum_ ? weight : maximum_;
+    }
+
+    inline WeightDistribution & operator += (const WeightDistribution &other)
+    {
+        n_           += other.n_;
+        sum_         += other.sum_;
+        sum_squared_ += other.sum_squared_;
+        minimum_      = other.minimum_ < minimum_ ? other.minimum_ : minimum_;
+        maximum_      = other.maximum_ > maximum_ ? other.maximum_ : maximum_;
+        return *this;
+    }
+
+    inline std::size_t getN() const
+    {
+        return n_;
+    }
+
+    inline double getSum() const
+    {
+        return sum_;
+    }
+
+    inline double getSquaredSum() const
+    {
+        return sum_squared_;
+    }
+
+    inline double getMinimum() const
+    {
+        return minimum_;
+    }
+
+    inline double getMaximum() const
+    {
+        return maximum_;
+    }
+
+    inline double getMean() const
+    {
+        return n_ > 0 ? sum_ / static_cast<double>(n_) : 0.0;
+    }
+
+    /**
+     * @brief Unbiased sample variance.
+     */
+    inline double getVariance() const
+    {
+        if(n_ < 2)
+            return 0.0;
+        const double n = static_cast<double>(n_);
+        const double variance = (sum_squared_ - sum_ * sum_ / n) / (n - 1.0);
+        return variance > 0.0 ? variance : 0.0;
+    }
+
+    inline double getStandardDeviation() const
+    {
+        return std::sqrt(getVariance());
+    }
+
+    /**
+     * @brief Effective sample size (sum w)^2 / sum w^2, independent of normalization.
+     */
+    inline double getEffectiveSampleSize() const
+    {
+        return sum_squared_ > 0.0 ? sum_ * sum_ / sum_squared_ : 0.0;
+    }
+
+private:
+    std::size_t n_;
+    double      sum_;
+    double      sum_squared_;
+    double      minimum_;
+    double      maximum_;
+};
+}
+
+#endif // SAMPLE_WEIGHT_DISTRIBUTION_HPP
@@ -1,40 +1,66 @@
 #ifndef SAMPLE_WEIGHT_ITERATOR_HPP
 #define SAMPLE_WEIGHT_ITERATOR_HPP
 
-#include <cslibs_utility/buffered/buffered_vector.hpp>
+#include <vector>
+#include <cassert>
+#include <iterator>
+#include <algorithm>
+
 #include <cslibs_utility/common/delegate.hpp>
 
+#include <muse_smc/utility/thread_pool.hpp>
+
+#include <muse_smc/samples/sample_storage.hpp>
+#include <muse_smc/samples/sample_rotation.hpp>
+#include <muse_smc/samples/sample_weight_distribution.hpp>
+#include <muse_smc/samples/sample_weight_kernels.hpp>
+
 namespace muse_smc {
 template<typename state_space_description_t>
 class WeightIterator : public std::iterator<std::random_access_iterator_tag, double>
 {
 public:
-    using state_t       = typename state_space_description_t::state_t;
-    using sample_t      = typename state_space_description_t::sample_t;
-    using parent        = std::iterator<std::random_access_iterator_tag, double>;
-    using iterator      = typename parent::iterator;
-    using reference     = typename parent::reference;
-    using notify_update = cslibs_utility::common::delegate<void(const double &)>;
+    using state_t          = typename state_space_description_t::state_t;
+    using sample_t         = typename state_space_description_t::sample_t;
+    using sample_storage_t = typename SampleStorageTraits<state_space_description_t>::storage_t;
+    using rotation_t       = SampleRotation<sample_storage_t>;
+    using parent           = std::iterator<std::random_access_iterator_tag, double>;
+    using reference        = typename parent::reference;
 
-    inline explicit WeightIterator(sample_t      *begin,
-                                   notify_update  update) :
-        data_(begin),
-        update_(update)
+    /**
+     * @brief WeightIterator constructor.
+     * @param data          - the samples to weight
+     * @param index         - the current sample index
+     * @param distribution  - the weight statistics, which are accumulated while iterating
+     * @param rotation      - optional rotation, if the samples are still to be copied into data
+     */
+    inline explicit WeightIterator(sample_storage_t   *data,
+                                   const std::size_t   index,
+                                   WeightDistribution *distribution,
+                                   rotation_t         *rotation = nullptr) :
+        data_(data),
+        index_(index),
+        distribution_(distribution),
+        rotation_(rotation)
     {
+        if(rotation_)
+            rotation_->reach(index_);
     }
 
     virtual ~WeightIterator() = default;
 
-    inline iterator& operator++()
+    inline WeightIterator& operator++()
     {
-        update_(data_->weight);
-        ++data_;
+        distribution_->add(data_->weight(index_));
+        ++index_;
+        if(rotation_)
+            rotation_->reach(index_);
         return *this;
     }
 
     inline bool operator ==(const WeightIterator &_other) const
     {
-        return data_ == _other.data_;
+        return index_ == _other.index_;
     }
 
     inline bool operator !=(const WeightIterator &_other) const
@@ -45,17 +71,19 @@ public:
 
     inline reference operator *() const
     {
-        return data_->weight;
+        return data_->weight(index_);
     }
 
     inline const state_t& state() const
     {
-        return data_->state;
+        return data_->state(index_);
     }
 
 private:
-    sample_t        *data_;
-    notify_update    update_;
+    sample_storage_t   *data_;
+    std::size_t         index_;
+    WeightDistribution *distribution_;
+    rotation_t         *rotation_;
 };
 
 template<typename state_space_description_t>
@@ -63,58 +91,176 @@ class WeightIteration
 {
 public:
     using sample_t          = typename state_space_description_t::sample_t;
-    using sample_vector_t   = cslibs_utility::buffered::buffered_vector<sample_t, typename sample_t::allocator_t>;
-    using notify_update     = cslibs_utility::common::delegate<void(const double)>;
+    using sample_storage_t  = typename SampleStorageTraits<state_space_description_t>::storage_t;
+    using sample_vector_t   = sample_storage_t;
+    using span_t            = typename sample_storage_t::span_t;
     using notify_touch      = cslibs_utility::common::delegate<void()>;
-    using notify_finished   = cslibs_utility::common::delegate<void()>;
+    using notify_finished   = cslibs_utility::common::delegate<void(const WeightDistribution &)>;
     using iterator_t        = WeightIterator<state_space_description_t>;
     using const_iterator_t  = typename sample_vector_t::const_iterator;
+    using weight_kernels_t  = WeightKernels<sample_storage_t>;
+    using rotation_t        = SampleRotation<sample_storage_t>;
+    using partitions_t      = std::vector<WeightIteration>;
 
-    inline WeightIteration(sample_vector_t &data,
-                           notify_touch     touch,
-                           notify_update    update,
-                           notify_finished  finish) :
+    /**
+     * @brief WeightIteration constructor.
+     * @param data          - the samples to weight
+     * @param touch         - on first access callback
+     * @param finish        - on finish callback, receives the weight statistics
+     * @param log_weights   - weights are accessed in log domain, models add log-likelihoods
+     * @param thread_pool   - optional thread pool partitions can be dispatched to
+     * @param rotation      - optional rotation, if the samples are still to be copied into data
+     */
+    inline WeightIteration(sample_vector_t                &data,
+                           notify_touch                    touch,
+                           notify_finished                 finish,
+                           const bool                      log_weights = false,
+                           const ThreadPool::Ptr          &thread_pool = nullptr,
+                           const typename rotation_t::Ptr &rotation = nullptr) :
         data_(data),
+        begin_(0),
+        end_(data.size()),
         touch_(touch),
-        update_(update),
         finish_(finish),
-        untouched_(true)
+        thread_pool_(thread_pool),
+        rotation_(rotation),
+        result_(nullptr),
+        untouched_(true),
+        spanned_(false),
+        log_weights_(log_weights)
     {
     }
 
+    /**
+     * @brief WeightIteration is not copyable, every copy would report on destruction.
+     */
+    WeightIteration(const WeightIteration &other) = delete;
+    WeightIteration& operator = (const WeightIteration &other) = delete;
+
+    /**
+     * @brief Move constructor, the moved from iteration is disarmed and does not report.
+     */
+    inline WeightIteration(WeightIteration &&other) :
+        data_(other.data_),
+        begin_(other.begin_),
+        end_(other.end_),
+        touch_(other.touch_),
+        finish_(other.finish_),
+        thread_pool_(std::move(other.thread_pool_)),
+        rotation_(std::move(other.rotation_)),
+        result_(other.result_),
+        untouched_(other.untouched_),
+        spanned_(other.spanned_),
+        log_weights_(other.log_weights_),
+        distribution_(other.distribution_),
+        partitions_(std::move(other.partitions_))
+    {
+        other.untouched_ = true;
+        other.result_    = nullptr;
+    }
+
     virtual ~WeightIteration()
     {
-        if(!untouched_)
-            finish_();
+        /// statistics and notifications need all samples in place
+        if(rotation_)
+            rotation_->complete();
+
+        if(result_ != nullptr) {
+            /// partitions hand their statistics to the parent iteration
+            if(!log_weights_)
+                *result_ = (untouched_ || spanned_) ? weight_kernels_t::reduce(data_, begin_, end_) : distribution_;
+            return;
+        }
+
+        if(!untouched_) {
+            if(!partitions_.empty()) {
+                distribution_.reset();
+                for(const WeightDistribution &d : partitions_)
+                    distribution_ += d;
+            } else if(spanned_ && !log_weights_) {
+                /// weights written through a span are reduced once
+                distribution_ = weight_kernels_t::reduce(data_);
+            }
+            finish_(distribution_);
+        }
     }
 
     inline const_iterator_t const_begin() const
     {
-        return data_.begin();
+        if(rotation_)
+            rotation_->complete();
+        return std::next(data_.begin(), begin_);
     }
 
     inline const_iterator_t const_end() const
     {
-        return data_.end();
+        return std::next(data_.begin(), end_);
     }
 
     inline iterator_t begin()
     {
-        if(untouched_) {
-            untouched_ = false;
-            touch_();
-        }
-
-        return iterator_t(&(*data_.begin()), update_);
+        touch();
+        return iterator_t(&data_, begin_, &distribution_, rotation_.get());
     }
 
     inline iterator_t end() {
-        return iterator_t(&(*data_.end()), update_);
+        return iterator_t(&data_, end_, &distribution_, rotation_.get());
+    }
+
+    /**
+     * @brief Raw access to all weights and states. Weights may be written in
+     *        tight loops, weight statistics are computed once the iteration is finished.
+     * @return the span of all samples
+     */
+    inline span_t span()
+    {
+        touch();
+        spanned_ = true;
+        if(rotation_)
+            rotation_->complete();
+        return data_.span(begin_, end_);
+    }
+
+    /**
+     * @brief Split the iteration into disjoint, contiguous partitions which may be
+     *        weighted concurrently. Each partition gathers its own weight statistics,
+     *        they are merged when this iteration finishes. Therefore all partitions
+     *        have to be destroyed before this iteration. An iteration may only be
+     *        partitioned once.
+     * @param count     - the requested amount of partitions
+     * @return the partitions
+     */
+    inline partitions_t partition(const std::size_t count)
+    {
+        /// partitions hold pointers to the statistics of the previous ones
+        assert(partitions_.empty());
+        touch();
+
+        const std::size_t size = end_ - begin_;
+        const std::size_t parts = std::max(static_cast<std::size_t>(1), std::min(count, size));
+        partitions_.assign(parts, WeightDistribution());
+
+        partitions_t partitions;
+        partitions.reserve(parts);
+        for(std::size_t i = 0 ; i < parts ; ++i) {
+            const std::size_t begin = begin_ + (i * size) / parts;
+            const std::size_t end   = begin_ + ((i + 1) * size) / parts;
+            partitions.push_back(WeightIteration(data_,
+                                                 begin,
+                                                 end,
+                                                 log_weights_,
+                                                 &partitions_[i],
+                                                 rotation_ ? rotation_->split(begin, end) : nullptr));
+        }
+        /// each partition copies its own samples
+        if(rotation_)
+            rotation_->release();
+        return partitions;
     }
 
     inline std::size_t size() const
     {
-        return data_.size();
+        return end_ - begin_;
     }
 
     inline std::size_t capacity() const
@@ -122,12 +268,67 @@ public:
         return data_.capacity();
     }
 
+    /**
+     * @brief If true, weights are log weights and models have to add log-likelihoods
+     *        instead of multiplying likelihoods. Log-likelihoods have to be finite, -inf
+     *        should be clamped to kernels::minimumLogWeight.
+     */
+    inline bool isLogDomain() const
+    {
+        return log_weights_;
+    }
+
+    /**
+     * @brief The thread pool partitions may be dispatched to, can be empty.
+     */
+    inline const ThreadPool::Ptr & getThreadPool() const
+    {
+        return thread_pool_;
+    }
+
 private:
-    sample_vector_t &data_;
-    notify_touch     touch_;
-    notify_update    update_;
-    notify_finished  finish_;
-    bool             untouched_;
+    sample_vector_t                &data_;
+    std::size_t                     begin_;
+    std::size_t                     end_;
+    notify_touch                    touch_;
+    notify_finished                 finish_;
+    ThreadPool::Ptr                 thread_pool_;
+    typename rotation_t::Ptr        rotation_;
+    WeightDistribution             *result_;
+    bool                            untouched_;
+    bool                            spanned_;
+    bool                            log_weights_;
+    WeightDistribution              distribution_;
+    std::vector<WeightDistribution> partitions_;
+
+    /**
+     * @brief Partition constructor.
+     */
+    inline WeightIteration(sample_vector_t                &data,
+                           const std::size_t               begin,
+                           const std::size_t               end,
+                           const bool                      log_weights,
+                           WeightDistribution             *result,
+                           const typename rotation_t::Ptr &rotation) :
+        data_(data),
+        begin_(begin),
+        end_(end),
+        rotation_(rotation),
+        result_(result),
+        untouched_(true),
+        spanned_(false),
+        log_weights_(log_weights)
+    {
+    }
+
+    inline void touch()
+    {
+        if(untouched_) {
+            untouched_ = false;
+            if(result_ == nullptr)
+                touch_();
+        }
+    }
 };
 }
 
@@ -0,0 +1,450 @@
+#ifndef SAMPLE_WEIGHT_KERNELS_HPP
+#define SAMPLE_WEIGHT_KERNELS_HPP
+
+#include <muse_smc/samples/sample_weight_distribution.hpp>
+#include <muse_smc/samples/sample_storage_soa.hpp>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <limits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Kernels for passes over sample weights. The instruction set is chosen at
+ * compile time, AVX-512 and AVX2 are used if enabled (e.g. by building with
+ * muse_smc_USE_NATIVE), otherwise the scalar loops are used.
+ */
+
+namespace muse_smc {
+namespace kernels {
+namespace detail {
+#if defined(__AVX512F__)
+#define MUSE_SMC_WEIGHT_KERNELS_SIMD
+struct Lanes {
+    using vector_t = __m512d;
+    static constexpr std::size_t size = 8;
+
+    static inline vector_t load(const double *p)            { return _mm512_loadu_pd(p); }
+    static inline void     store(double *p, vector_t v)     { _mm512_storeu_pd(p, v); }
+    static inline vector_t set(const double v)              { return _mm512_set1_pd(v); }
+    static inline vector_t add(vector_t a, vector_t b)      { return _mm512_add_pd(a, b); }
+    static inline vector_t mul(vector_t a, vector_t b)      { return _mm512_mul_pd(a, b); }
+    static inline vector_t fmadd(vector_t a, vector_t b, vector_t c) { return _mm512_fmadd_pd(a, b, c); }
+    static inline vector_t min(vector_t a, vector_t b)      { return _mm512_min_pd(a, b); }
+    static inline vector_t max(vector_t a, vector_t b)      { return _mm512_max_pd(a, b); }
+    static inline double   sum(vector_t v)                  { return _mm512_reduce_add_pd(v); }
+    static inline double   min(vector_t v)                  { return _mm512_reduce_min_pd(v); }
+    static inline double   max(vector_t v)                  { return _mm512_reduce_max_pd(v); }
+};
+#elif defined(__AVX2__)
+#define MUSE_SMC_WEIGHT_KERNELS_SIMD
+struct Lanes {
+    using vector_t = __m256d;
+    static constexpr std::size_t size = 4;
+
+    static inline vector_t load(const double *p)            { return _mm256_loadu_pd(p); }
+    static inline void     store(double *p, vector_t v)     { _mm256_storeu_pd(p, v); }
+    static inline vector_t set(const double v)              { return _mm256_set1_pd(v); }
+    static inline vector_t add(vector_t a, vector_t b)      { return _mm256_add_pd(a, b); }
+    static inline vector_t mul(vector_t a, vector_t b)      { return _mm256_mul_pd(a, b); }
+#if defined(__FMA__)
+    static inline vector_t fmadd(vector_t a, vector_t b, vector_t c) { return _mm256_fmadd_pd(a, b, c); }
+#else
+    static inline vector_t fmadd(vector_t a, vector_t b, vector_t c) { return _mm256_add_pd(_mm256_mul_pd(a, b), c); }
+#endif
+    static inline vector_t min(vector_t a, vector_t b)      { return _mm256_min_pd(a, b); }
+    static inline vector_t max(vector_t a, vector_t b)      { return _mm256_max_pd(a, b); }
+
+    static inline double   sum(vector_t v)
+    {
+        const __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+    }
+    static inline double   min(vector_t v)
+    {
+        const __m128d m = _mm_min_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_min_sd(m, _mm_unpackhi_pd(m, m)));
+    }
+    static inline double   max(vector_t v)
+    {
+        const __m128d m = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_max_sd(m, _mm_unpackhi_pd(m, m)));
+    }
+};
+#endif
+}
+
+/**
+ * @brief Check a value for infinity and NaN by its exponent bits, std::isfinite may be
+ *        folded to true when building with -ffast-math.
+ */
+inline bool isFinite(const double value)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x7ff0000000000000ULL) != 0x7ff0000000000000ULL;
+}
+
+/**
+ * @brief The smallest log weight, the logarithm of the smallest positive double. Log
+ *        weights and log-likelihoods are clamped to it, so that they stay finite.
+ */
+inline double minimumLogWeight()
+{
+    return -708.3964185322641;
+}
+
+/**
+ * @brief Scale all weights by 1 / sum and gather the distribution of the
+ *        normalized weights in the same pass.
+ * @param weights   - contiguous weights
+ * @param size      - amount of weights
+ * @param sum       - the weight sum to normalize with
+ * @return the distribution of the normalized weights
+ */
+inline WeightDistribution normalize(double           *weights,
+                                    const std::size_t size,
+                                    const double      sum)
+{
+    const double factor  = 1.0 / sum;
+    double       s       = 0.0;
+    double       s_sq    = 0.0;
+    double       minimum = std::numeric_limits<double>::max();
+    double       maximum = std::numeric_limits<double>::lowest();
+    std::size_t  i       = 0;
+#ifdef MUSE_SMC_WEIGHT_KERNELS_SIMD
+    using lanes_t = detail::Lanes;
+    if(size >= lanes_t::size) {
+        const lanes_t::vector_t f     = lanes_t::set(factor);
+        lanes_t::vector_t       v_s   = lanes_t::set(0.0);
+        lanes_t::vector_t       v_sq  = lanes_t::set(0.0);
+        lanes_t::vector_t       v_min = lanes_t::set(minimum);
+        lanes_t::vector_t       v_max = lanes_t::set(maximum);
+        for(; i + lanes_t::size <= size ; i += lanes_t::size) {
+            const lanes_t::vector_t w = lanes_t::mul(lanes_t::load(weights + i), f);
+            lanes_t::store(weights + i, w);
+            v_s   = lanes_t::add(v_s, w);
+            v_sq  = lanes_t::fmadd(w, w, v_sq);
+            v_min = lanes_t::min(v_min, w);
+            v_max = lanes_t::max(v_max, w);
+        }
+        s       = lanes_t::sum(v_s);
+        s_sq    = lanes_t::sum(v_sq);
+        minimum = lanes_t::min(v_min);
+        maximum = lanes_t::max(v_max);
+    }
+#endif
+    for(; i < size ; ++i) {
+        const double w = weights[i] * factor;
+        weights[i] = w;
+        s    += w;
+        s_sq += w * w;
+        minimum = w < minimum ? w : minimum;
+        maximum = w > maximum ? w : maximum;
+    }
+    return WeightDistribution(size, s, s_sq, minimum, maximum);
+}
+
+/**
+ * @brief Gather the distribution of weights without modifying them.
+ * @param weights   - contiguous weights
+ * @param size      - amount of weights
+ * @return the distribution of the weights
+ */
+inline WeightDistribution reduce(const double     *weights,
+                                 const std::size_t size)
+{
+    double       s       = 0.0;
+    double       s_sq    = 0.0;
+    double       minimum = std::numeric_limits<double>::max();
+    double       maximum = std::numeric_limits<double>::lowest();
+    std::size_t  i       = 0;
+#ifdef MUSE_SMC_WEIGHT_KERNELS_SIMD
+    using lanes_t = detail::Lanes;
+    if(size >= lanes_t::size) {
+        lanes_t::vector_t v_s   = lanes_t::set(0.0);
+        lanes_t::vector_t v_sq  = lanes_t::set(0.0);
+        lanes_t::vector_t v_min = lanes_t::set(minimum);
+        lanes_t::vector_t v_max = lanes_t::set(maximum);
+        for(; i + lanes_t::size <= size ; i += lanes_t::size) {
+            const lanes_t::vector_t w = lanes_t::load(weights + i);
+            v_s   = lanes_t::add(v_s, w);
+            v_sq  = lanes_t::fmadd(w, w, v_sq);
+            v_min = lanes_t::min(v_min, w);
+            v_max = lanes_t::max(v_max, w);
+        }
+        s       = lanes_t::sum(v_s);
+        s_sq    = lanes_t::sum(v_sq);
+        minimum = lanes_t::min(v_min);
+        maximum = lanes_t::max(v_max);
+    }
+#endif
+    for(; i < size ; ++i) {
+        const double w = weights[i];
+        s    += w;
+        s_sq += w * w;
+        minimum = w < minimum ? w : minimum;
+        maximum = w > maximum ? w : maximum;
+    }
+    return WeightDistribution(size, s, s_sq, minimum, maximum);
+}
+
+/**
+ * @brief Set all weights to the same value.
+ * @param weights   - contiguous weights
+ * @param size      - amount of weights
+ * @param value     - value to assign
+ * @return the distribution of the weights
+ */
+inline WeightDistribution fill(double           *weights,
+                               const std::size_t size,
+                               const double      value)
+{
+    for(std::size_t i = 0 ; i < size ; ++i)
+        weights[i] = value;
+    const double n = static_cast<double>(size);
+    return WeightDistribution(size, n * value, n * value * value, value, value);
+}
+
+/**
+ * @brief Move weights into the log domain. Weights are clamped to the smallest
+ *        positive double first, so that zero weights stay finite.
+ *        The loop is kept simple, so that the compiler can use vectorized
+ *        math functions (libmvec) when building with -ffast-math.
+ * @param weights   - contiguous weights
+ * @param size      - amount of weights
+ */
+inline void logarithm(double           *weights,
+                      const std::size_t size)
+{
+    const double minimum = std::numeric_limits<double>::min();
+    for(std::size_t i = 0 ; i < size ; ++i) {
+        const double w = weights[i];
+        weights[i] = std::log(w > minimum ? w : minimum);
+    }
+}
+
+/**
+ * @brief Online log-sum-exp, the maximum log weight and the sum of the weights shifted
+ *        by it are gathered in one pass, the sum is rescaled whenever the maximum grows.
+ *        Log weights of -inf contribute nothing, NaN makes the sum NaN.
+ * @param weights   - contiguous log weights
+ * @param size      - amount of weights
+ * @param shift     - set to the maximum log weight
+ * @return the sum of exp(weight - shift)
+ */
+inline double logSumExp(const double     *weights,
+                        const std::size_t size,
+                        double           &shift)
+{
+    double maximum = std::numeric_limits<double>::lowest();
+    double sum     = 0.0;
+    for(std::size_t i = 0 ; i < size ; ++i) {
+        const double w = weights[i];
+        if(w > maximum) {
+            sum     = sum * std::exp(maximum - w) + 1.0;
+            maximum = w;
+        } else {
+            sum    += std::exp(w - maximum);
+        }
+    }
+    shift = maximum;
+    return sum;
+}
+
+/**
+ * @brief Move log weights back into the linear domain and normalize them, the
+ *        distribution of the normalized weights is gathered in the same pass.
+ *        The loop is kept simple, so that the compiler can use vectorized
+ *        math functions (libmvec) when building with -ffast-math.
+ * @param weights   - contiguous log weights
+ * @param size      - amount of weights
+ * @param shift     - the maximum log weight, see logSumExp
+ * @param sum       - the sum of the shifted weights, see logSumExp
+ * @return the distribution of the normalized weights
+ */
+inline WeightDistribution exponentiate(double           *weights,
+                                       const std::size_t size,
+                                       const double      shift,
+                                       const double      sum)
+{
+    const double factor  = 1.0 / sum;
+    double       s       = 0.0;
+    double       s_sq    = 0.0;
+    double       minimum = std::numeric_limits<double>::max();
+    double       maximum = std::numeric_limits<double>::lowest();
+    for(std::size_t i = 0 ; i < size ; ++i) {
+        const double w = std::exp(weights[i] - shift) * factor;
+        weights[i] = w;
+        s    += w;
+        s_sq += w * w;
+        minimum = w < minimum ? w : minimum;
+        maximum = w > maximum ? w : maximum;
+    }
+    return WeightDistribution(size, s, s_sq, minimum, maximum);
+}
+}
+
+/**
+ * @brief The WeightKernels class applies the weight kernels to a sample storage.
+ *        Storages without contiguous weights, including the default SampleStorageAoS,
+ *        are processed by scalar loops and are not vectorized. Only SampleStorageSoA
+ *        is processed by the vectorized kernels.
+ */
+template<typename sample_storage_t>
+struct WeightKernels
+{
+    static inline WeightDistribution normalize(sample_storage_t &data,
+                                               const double      sum)
+    {
+        return normalize(data, 0, data.size(), sum);
+    }
+
+    static inline WeightDistribution normalize(sample_storage_t &data,
+                                               const std::size_t begin,
+                                               const std::size_t end,
+                                               const double      sum)
+    {
+        const double factor = 1.0 / sum;
+        WeightDistribution distribution;
+        for(std::size_t i = begin ; i < end ; ++i) {
+            double &w = data.weight(i);
+            w *= factor;
+            distribution.add(w);
+        }
+        return distribution;
+    }
+
+    static inline WeightDistribution reduce(const sample_storage_t &data)
+    {
+        return reduce(data, 0, data.size());
+    }
+
+    static inline WeightDistribution reduce(const sample_storage_t &data,
+                                            const std::size_t       begin,
+                                            const std::size_t       end)
+    {
+        WeightDistribution distribution;
+        for(std::size_t i = begin ; i < end ; ++i)
+            distribution.add(data.weight(i));
+        return distribution;
+    }
+
+    static inline WeightDistribution fill(sample_storage_t &data,
+                                          const double      value)
+    {
+        for(std::size_t i = 0 ; i < data.size() ; ++i)
+            data.weight(i) = value;
+        const double n = static_cast<double>(data.size());
+        return WeightDistribution(data.size(), n * value, n * value * value, value, value);
+    }
+
+    static inline void logarithm(sample_storage_t &data)
+    {
+        const double minimum = std::numeric_limits<double>::min();
+        for(std::size_t i = 0 ; i < data.size() ; ++i) {
+            double &w = data.weight(i);
+            w = std::log(w > minimum ? w : minimum);
+        }
+    }
+
+    static inline double logSumExp(const sample_storage_t &data,
+                                   double                 &shift)
+    {
+        double maximum = std::numeric_limits<double>::lowest();
+        double sum     = 0.0;
+        for(std::size_t i = 0 ; i < data.size() ; ++i) {
+            const double w = data.weight(i);
+            if(w > maximum) {
+                sum     = sum * std::exp(maximum - w) + 1.0;
+                maximum = w;
+            } else {
+                sum    += std::exp(w - maximum);
+            }
+        }
+        shift = maximum;
+        return sum;
+    }
+
+    static inline WeightDistribution exponentiate(sample_storage_t &data,
+                                                  const std::size_t begin,
+                                                  const std::size_t end,
+                                                  const double      shift,
+                                                  const double      sum)
+    {
+        const double factor = 1.0 / sum;
+        WeightDistribution distribution;
+        for(std::size_t i = begin ; i < end ; ++i) {
+            double &w = data.weight(i);
+            w = std::exp(w - shift) * factor;
+            distribution.add(w);
+        }
+        return distribution;
+    }
+};
+
+template<typename sample_t>
+struct WeightKernels<SampleStorageSoA<sample_t>>
+{
+    using sample_storage_t = SampleStorageSoA<sample_t>;
+
+    static inline WeightDistribution normalize(sample_storage_t &data,
+                                               const double      sum)
+    {
+        return kernels::normalize(data.weights(), data.size(), sum);
+    }
+
+    static inline WeightDistribution normalize(sample_storage_t &data,
+                                               const std::size_t begin,
+                                               const std::size_t end,
+                                               const double      sum)
+    {
+        return kernels::normalize(data.weights() + begin, end - begin, sum);
+    }
+
+    static inline WeightDistribution reduce(const sample_storage_t &data)
+    {
+        return kernels::reduce(data.weights(), data.size());
+    }
+
+    static inline WeightDistribution reduce(const sample_storage_t &data,
+                                            const std::size_t       begin,
+                                            const std::size_t       end)
+    {
+        return kernels::reduce(data.weights() + begin, end - begin);
+    }
+
+    static inline WeightDistribution fill(sample_storage_t &data,
+                                          const double      value)
+    {
+        return kernels::fill(data.weights(), data.size(), value);
+    }
+
+    static inline void logarithm(sample_storage_t &data)
+    {
+        kernels::logarithm(data.weights(), data.size());
+    }
+
+    static inline double logSumExp(const sample_storage_t &data,
+                                   double                 &shift)
+    {
+        return kernels::logSumExp(data.weights(), data.size(), shift);
+    }
+
+    static inline WeightDistribution exponentiate(sample_storage_t &data,
+                                                  const std::size_t begin,
+                                                  const std::size_t end,
+                                                  const double      shift,
+                                                  const double      sum)
+    {
+        return kernels::exponentiate(data.weights() + begin, end - begin, shift, sum);
+    }
+};
+}
+
+#endif // SAMPLE_WEIGHT_KERNELS_HPP
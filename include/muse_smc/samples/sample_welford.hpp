@@ -0,0 +1,113 @@
+#ifndef SAMPLE_WELFORD_HPP
+#define SAMPLE_WELFORD_HPP
+
+#include <muse_smc/samples/sample_estimator.hpp>
+
+#include <Eigen/Core>
+
+namespace muse_smc {
+/**
+ * @brief The WelfordEstimator class maintains the weighted mean and covariance of the
+ *        states incrementally, using West's weighted variant of Welford's algorithm,
+ *        which is numerically stable in a single pass. Partial estimates are merged
+ *        by the pairwise update of Chan et al.
+ * @param sample_t      - the sample type
+ * @param Dim           - the dimension of the vectorized state
+ * @param vectorize_t   - functor mapping a state to an Eigen::Matrix<double, Dim, 1>,
+ *                        angles should be mapped to e.g. their cosine and sine
+ */
+template<typename sample_t, int Dim, typename vectorize_t>
+class EIGEN_ALIGN16 WelfordEstimator : public SampleEstimator<sample_t>
+{
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    using Ptr          = std::shared_ptr<WelfordEstimator>;
+    using base_t       = SampleEstimator<sample_t>;
+    using state_t      = typename sample_t::state_t;
+    using vector_t     = Eigen::Matrix<double, Dim, 1>;
+    using covariance_t = Eigen::Matrix<double, Dim, Dim>;
+
+    inline explicit WelfordEstimator(const vectorize_t &vectorize = vectorize_t()) :
+        vectorize_(vectorize)
+    {
+        clear();
+    }
+
+    virtual void clear() override
+    {
+        weight_sum_ = 0.0;
+        n_          = 0;
+        mean_.setZero();
+        scatter_.setZero();
+    }
+
+    virtual void insert(const state_t &state,
+                        const double   weight) override
+    {
+        if (weight <= 0.0)
+            return;
+
+        const vector_t x = vectorize_(state);
+        weight_sum_ += weight;
+        ++n_;
+        const vector_t d = x - mean_;
+        mean_       += (weight / weight_sum_) * d;
+        scatter_.noalias() += weight * d * (x - mean_).transpose();
+    }
+
+    virtual typename base_t::Ptr partial() const override
+    {
+        return typename base_t::Ptr(new WelfordEstimator(vectorize_));
+    }
+
+    virtual void merge(const base_t &other) override
+    {
+        const WelfordEstimator &o = static_cast<const WelfordEstimator &>(other);
+        if (o.weight_sum_ <= 0.0)
+            return;
+
+        const double   weight_sum = weight_sum_ + o.weight_sum_;
+        const vector_t d          = o.mean_ - mean_;
+        scatter_.noalias() += o.scatter_ + (weight_sum_ * o.weight_sum_ / weight_sum) * d * d.transpose();
+        mean_       += (o.weight_sum_ / weight_sum) * d;
+        weight_sum_  = weight_sum;
+        n_          += o.n_;
+    }
+
+    inline const vector_t & getMean() const
+    {
+        return mean_;
+    }
+
+    /**
+     * @brief The weighted covariance, normalized by the weight sum.
+     */
+    inline covariance_t getCovariance() const
+    {
+        return weight_sum_ > 0.0 ? covariance_t(scatter_ / weight_sum_) : covariance_t::Zero();
+    }
+
+    inline double getWeightSum() const
+    {
+        return weight_sum_;
+    }
+
+    /**
+     * @brief Amount of states with positive weight.
+     */
+    inline std::size_t getN() const
+    {
+        return n_;
+    }
+
+private:
+    vectorize_t  vectorize_;
+    double       weight_sum_;
+    std::size_t  n_;
+    vector_t     mean_;
+    covariance_t scatter_;
+};
+}
+
+#endif // SAMPLE_WELFORD_HPP
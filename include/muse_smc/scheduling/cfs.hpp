@@ -7,6 +7,10 @@
 
 #include <cslibs_time/statistics/duration_mean.hpp>
 
+#include <unordered_map>
+#include <iostream>
+#include <algorithm>
+
 namespace muse_smc {
 template<typename state_space_description_t, typename data_t>
 class CFS : public muse_smc::Scheduler<state_space_description_t, data_t>
@@ -53,18 +57,22 @@ public:
     };
 
     using Ptr                 = std::shared_ptr<CFS>;
+    using base_t              = muse_smc::Scheduler<state_space_description_t, data_t>;
+    using id_t                = typename base_t::id_t;
     using rate_t              = cslibs_time::Rate;
     using update_t            = muse_smc::Update<state_space_description_t, data_t>;
     using queue_t             = __gnu_pbds::priority_queue<Entry, typename Entry::Greater, __gnu_pbds::rc_binomial_heap_tag>;
     using mean_duration_t     = cslibs_time::statistics::DurationMean;
     using mean_duration_map_t = std::unordered_map<id_t, mean_duration_t>;
     using time_priority_map_t = std::unordered_map<id_t, double>;
-    using resampling_t        = muse_smc::Resampling<state_space_description_t, data_t>;
+    using resampling_t        = muse_smc::Resampling<state_space_description_t>;
     using sample_set_t        = muse_smc::SampleSet<state_space_description_t>;
     using nice_map_t          = std::unordered_map<id_t, double>;
     using time_t              = cslibs_time::Time;
     using duration_t          = cslibs_time::Duration;
 
+    using base_t::base_t;
+
     virtual ~CFS() = default;
 
     void setup(const cslibs_time::Rate  &rate,
@@ -85,28 +93,54 @@ public:
         }
     }
 
+    /**
+     * @brief Apply an update, if its model is next in line. A fused update is due if
+     *        any of its models is, the duration is then split among all fused models.
+     */
     virtual bool apply(typename update_t::Ptr     &u,
                        typename sample_set_t::Ptr &s) override
     {
-        auto now = []()
-        {
-            return time_t(ros::Time::now().toNSec());
-        };
-
         const id_t   id    = u->getModelId();
         const time_t stamp = u->getStamp();
 
-        if(id == q_.top().id && stamp >= next_update_time_) {
-            Entry entry = q_.top();
-            q_.pop();
+        if(!u->isFused()) {
+            if(id == q_.top().id && stamp >= next_update_time_) {
+                Entry entry = q_.top();
+                q_.pop();
+
+                const time_t start = this->clock_->now();
+                u->apply(s->getWeightIterator());
+                const duration_t dur = (this->clock_->now() - start);
+                entry.vtime += static_cast<int64_t>(static_cast<double>(dur.nanoseconds()) * nice_values_[id]);
+                next_update_time_ = stamp + dur;
+
+                q_.push(entry);
+                return true;
+            }
+            return false;
+        }
 
-            const time_t start = now();
+        const typename update_t::updates_t &fused = u->getFused();
+        const id_t next = q_.top().id;
+        const bool due  = std::any_of(fused.begin(), fused.end(), [next](const typename update_t::Ptr &f) {
+            return f->getModelId() == next;
+        });
+        if(due && stamp >= next_update_time_) {
+            const time_t start = this->clock_->now();
             u->apply(s->getWeightIterator());
-            const duration_t dur = (now() - start);
-            entry.vtime += static_cast<int64_t>(static_cast<double>(dur.nanoseconds()) * nice_values_[id]);
+            const duration_t dur = (this->clock_->now() - start);
             next_update_time_ = stamp + dur;
 
-            q_.push(entry);
+            const double share = static_cast<double>(dur.nanoseconds()) / static_cast<double>(fused.size());
+            queue_t q;
+            for(auto e : q_) {
+                for(const typename update_t::Ptr &f : fused) {
+                    if(f->getModelId() == e.id)
+                        e.vtime += static_cast<int64_t>(share * nice_values_[e.id]);
+                }
+                q.push(e);
+            }
+            std::swap(q, q_);
             return true;
         }
         return false;
@@ -118,18 +152,13 @@ public:
     {
         const cslibs_time::Time &stamp = s->getStamp();
 
-        auto now = []()
-        {
-            return time_t(ros::Time::now().toNSec());
-        };
-
         if(resampling_time_.isZero())
             resampling_time_ = stamp;
 
-        auto do_apply = [&stamp, &r, &s, &now, this] () {
-            const time_t start = now();
+        auto do_apply = [&stamp, &r, &s, this] () {
+            const time_t start = this->clock_->now();
             r->apply(*s);
-            const duration_t dur = (now() - start);
+            const duration_t dur = (this->clock_->now() - start);
 
             resampling_time_   = stamp + resampling_period_;
             next_update_time_  = next_update_time_ + dur;
@@ -3,26 +3,22 @@
 
 #include <muse_smc/scheduling/scheduler.hpp>
 
-#include <cslibs_time/statistics/duration_mean.hpp>
-
 namespace muse_smc {
 template<typename state_space_description_t, typename data_t>
 class Rate : public muse_smc::Scheduler<state_space_description_t, data_t>
 {
 public:
     using Ptr                 = std::shared_ptr<Rate>;
+    using base_t              = muse_smc::Scheduler<state_space_description_t, data_t>;
     using rate_t              = cslibs_time::Rate;
     using update_t            = muse_smc::Update<state_space_description_t, data_t>;
-    using queue_t             = __gnu_pbds::priority_queue<Entry, typename Entry::Greater, __gnu_pbds::rc_binomial_heap_tag>;
-    using mean_duration_t     = cslibs_time::statistics::DurationMean;
-    using mean_duration_map_t = std::unordered_map<id_t, mean_duration_t>;
-    using time_priority_map_t = std::unordered_map<id_t, double>;
-    using resampling_t        = muse_smc::Resampling<state_space_description_t, data_t>;
+    using resampling_t        = muse_smc::Resampling<state_space_description_t>;
     using sample_set_t        = muse_smc::SampleSet<state_space_description_t>;
-    using nice_map_t          = std::unordered_map<id_t, double>;
     using time_t              = cslibs_time::Time;
     using duration_t          = cslibs_time::Duration;
 
+    using base_t::base_t;
+
     virtual ~Rate() = default;
 
     void setup(const cslibs_time::Rate  &rate)
@@ -35,15 +31,12 @@ public:
     virtual bool apply(typename update_t::Ptr     &u,
                        typename sample_set_t::Ptr &s) override
     {
-        auto now = []()
-        {
-            return time_t(ros::Time::now().toNSec());
-        };
+        const time_t stamp = u->getStamp();
 
         if(stamp >= next_update_time_) {
-            const time_t start = now();
+            const time_t start = this->clock_->now();
             u->apply(s->getWeightIterator());
-            const duration_t dur = (now() - start);
+            const duration_t dur = (this->clock_->now() - start);
             next_update_time_ = stamp + dur;
             return true;
         }
@@ -56,18 +49,13 @@ public:
     {
         const cslibs_time::Time &stamp = s->getStamp();
 
-        auto now = []()
-        {
-            return time_t(ros::Time::now().toNSec());
-        };
-
         if(resampling_time_.isZero())
             resampling_time_ = stamp;
 
-        auto do_apply = [&stamp, &r, &s, &now, this] () {
-            const time_t start = now();
+        auto do_apply = [&stamp, &r, &s, this] () {
+            const time_t start = this->clock_->now();
             r->apply(*s);
-            const duration_t dur = (now() - start);
+            const duration_t dur = (this->clock_->now() - start);
 
             resampling_time_   = stamp + resampling_period_;
             next_update_time_  = next_update_time_ + dur;
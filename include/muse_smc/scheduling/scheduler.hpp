@@ -3,6 +3,7 @@
 
 #include <muse_smc/resampling/resampling.hpp>
 #include <muse_smc/update/update.hpp>
+#include <muse_smc/utility/clock.hpp>
 #include <cslibs_time/rate.hpp>
 
 #include <memory>
@@ -18,13 +19,44 @@ public:
     using resampling_t = Resampling<state_space_description_t>;
     using sample_set_t = SampleSet<state_space_description_t>;
 
+    /**
+     * @brief Scheduler constructor.
+     * @param clock     - the clock processing durations are measured with
+     */
+    inline explicit Scheduler(const Clock::Ptr &clock = Clock::Ptr(new SteadyClock)) :
+        clock_(clock)
+    {
+    }
+
     virtual inline ~Scheduler() = default;
 
+    /**
+     * @brief Apply an update or decline it. Fused updates, see Update::getFused, weight
+     *        for several models at once, schedulers accounting per model should take
+     *        all of them into account.
+     */
     virtual bool apply(typename update_t::Ptr     &u,
                        typename sample_set_t::Ptr &s) = 0;
 
     virtual bool apply(typename resampling_t::Ptr &r,
                        typename sample_set_t::Ptr &s) = 0;
+
+    /**
+     * @brief Replace the clock, e.g. by a VirtualClock to replay scheduling decisions.
+     * @param clock     - the clock
+     */
+    inline void setClock(const Clock::Ptr &clock)
+    {
+        clock_ = clock;
+    }
+
+    inline const Clock::Ptr & getClock() const
+    {
+        return clock_;
+    }
+
+protected:
+    Clock::Ptr clock_;
 };
 }
 
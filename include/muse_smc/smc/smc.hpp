@@ -10,20 +10,25 @@
 #include <muse_smc/samples/sample_set.hpp>
 #include <muse_smc/resampling/resampling.hpp>
 #include <muse_smc/smc/smc_state.hpp>
+#include <muse_smc/smc/smc_metrics.hpp>
 #include <muse_smc/scheduling/scheduler.hpp>
+#include <muse_smc/utility/mpsc_queue.hpp>
+#include <muse_smc/utility/trace.hpp>
 
 /// CSLIBS
 #include <cslibs_time/rate.hpp>
 #include <cslibs_time/statistics/duration_lowpass.hpp>
-#include <cslibs_utility/synchronized/synchronized_priority_queue.hpp>
 
 /// SYSTEM
 #include <memory>
 #include <thread>
+#include <chrono>
 #include <atomic>
 #include <queue>
+#include <vector>
 #include <condition_variable>
 #include <unordered_map>
+#include <iostream>
 
 /***
  * Distance thresholds for resampling and update throttling are
@@ -59,12 +64,28 @@ public:
     using resampling_t          = Resampling<state_space_description_t>;
     using scheduler_t           = Scheduler<state_space_description_t, data_t>;
     using filter_state_t        = SMCState<state_space_description_t>;
-    using update_queue_t        = cslibs_utility::synchronized::priority_queue<typename update_t::Ptr,
-    typename update_t::Greater>;
-    using prediction_queue_t    = cslibs_utility::synchronized::priority_queue<typename prediction_t::Ptr,
-    typename prediction_t::Greater>;
+    using update_queue_t        = std::priority_queue<typename update_t::Ptr,
+    std::vector<typename update_t::Ptr>, typename update_t::Greater>;
+    using prediction_queue_t    = std::priority_queue<typename prediction_t::Ptr,
+    std::vector<typename prediction_t::Ptr>, typename prediction_t::Greater>;
+    using update_ingress_t      = MPSCQueue<typename update_t::Ptr>;
+    using prediction_ingress_t  = MPSCQueue<typename prediction_t::Ptr>;
     using duration_t            = cslibs_time::Duration;
     using duration_map_t        = std::unordered_map<std::size_t, cslibs_time::statistics::DurationLowpass>;
+    using prediction_model_t    = typename prediction_t::predition_model_t;
+    using metrics_t             = SMCMetrics::Snapshot;
+
+    /**
+     * @brief Counters of the prediction step, updates waiting for predictions to reach
+     *        their stamps, waits which timed out and how the timeouts were resolved.
+     */
+    struct PredictionStatistics {
+        std::size_t waits          = 0;
+        std::size_t timeouts       = 0;
+        std::size_t extrapolations = 0;
+        std::size_t deferrals      = 0;
+        std::size_t drops          = 0;
+    };
 
     /**
      * @brief SMC default constructor.
@@ -73,11 +94,22 @@ public:
         request_init_state_(false),
         request_init_uniform_(false),
         enable_lag_correction_(false),
+        fuse_updates_(false),
         has_valid_state_(false),
         reset_all_accumulators_after_update_(false),
         reset_model_accumulators_after_resampling_(false),
+        prediction_timeout_ns_(0),
+        prediction_max_deferrals_(3),
+        prediction_stalls_(0),
+        prediction_waits_(0),
+        prediction_timeouts_(0),
+        prediction_extrapolations_(0),
+        prediction_deferrals_(0),
+        prediction_drops_(0),
         worker_thread_active_(false),
-        worker_thread_exit_(false)
+        worker_thread_exit_(false),
+        worker_thread_waiting_(false),
+        event_triggered_(false)
     {
     }
 
@@ -101,6 +133,7 @@ public:
      * @param reset_all_model_accumulators_on_update    - reset all model accumulators when an update is carried out
      * @param reset_model_accumulators_after_resampling - reset all model accumlators after resampling is carried out
      * @param enable_lag_correction                     - lag correction for delayed update inputs
+     * @param fuse_updates                              - weight updates sharing a stamp in a single pass, if their models are fusable
      */
     inline void setup(const typename sample_set_t::Ptr            &sample_set,
                       const typename uniform_sampling_t::Ptr      &sample_uniform,
@@ -111,7 +144,8 @@ public:
                       const typename scheduler_t::Ptr             &scheduler,
                       const bool                                   reset_all_model_accumulators_on_update,
                       const bool                                   reset_model_accumulators_after_resampling,
-                      const bool                                   enable_lag_correction)
+                      const bool                                   enable_lag_correction,
+                      const bool                                   fuse_updates = false)
     {
         sample_set_                                 = sample_set;
         sample_uniform_                             = sample_uniform;
@@ -121,6 +155,7 @@ public:
         prediction_integrals_                       = prediction_integrals;
         scheduler_                                  = scheduler;
         enable_lag_correction_                      = enable_lag_correction;
+        fuse_updates_                               = fuse_updates;
         reset_all_accumulators_after_update_        = reset_all_model_accumulators_on_update;
         reset_model_accumulators_after_resampling_  = reset_model_accumulators_after_resampling;
     }
@@ -133,8 +168,10 @@ public:
     {
         if(!worker_thread_active_) {
             lock_t l(worker_thread_mutex_);
-            worker_thread_exit_ = false;
-            worker_thread_      = thread_t([this](){loop();});
+            /// set before the thread runs, so that end and stepping see the filter running right away
+            worker_thread_active_ = true;
+            worker_thread_exit_   = false;
+            worker_thread_        = thread_t([this](){loop();});
             return true;
         }
         return false;
@@ -149,65 +186,122 @@ public:
         if(!worker_thread_active_)
             return false;
 
-        update_queue_.clear();
-        prediction_queue_.clear();
         worker_thread_exit_ = true;
-        notify_event_.notify_one();
+        notify();
         if(worker_thread_.joinable()) {
             worker_thread_.join();
         }
+
+        /// the worker is gone, this thread may consume the queues now
+        update_ingress_.clear();
+        prediction_ingress_.clear();
+        update_queue_           = update_queue_t();
+        delayed_update_queue_   = update_queue_t();
+        prediction_queue_       = prediction_queue_t();
+        deferred_update_.reset();
         return true;
     }
 
     /**
-     * @brief Add a new prediction to the filter for sample propagation.
+     * @brief Add a new prediction to the filter for sample propagation. Never blocks
+     *        on the filter, may be called from any thread.
      * @param prediction - the prediction or control function applied to the samples
      */
     inline void addPrediction(const typename prediction_t::Ptr &prediction)
     {
-        prediction_queue_.emplace(prediction);
-        notify_prediction_.notify_one();
+        prediction_ingress_.push(prediction);
+        notify();
     }
 
     /**
-     * @brief Add an measurement update from some channel to the filter to weight the samples
+     * @brief Add an measurement update from some channel to the filter to weight the samples.
+     *        Never blocks on the filter, may be called from any thread.
      * @param update    - the update function applied to the sample set
      */
     inline void addUpdate(const typename update_t::Ptr &update)
     {
-        if (enable_lag_correction_) {
-            const std::size_t        id    = update->getModelId();
-            const cslibs_time::Time &stamp = update->getStamp();
-
-            cslibs_time::statistics::DurationLowpass &lag = lag_map_[id];
-            lag += cslibs_time::Duration(
-                        static_cast<int64_t>(std::max(0L, update->stampReceived().nanoseconds() - update->getStamp().nanoseconds())));
-            if (lag.duration() >= lag_) {
-                lag_ = lag.duration();
-                lag_source_ = id;
-            }
-            if (id == lag_source_) {
-                while (delayed_update_queue_.hasElements()) {
-                    if (delayed_update_queue_.top()->getStamp() <= stamp)
-                        update_queue_.emplace(delayed_update_queue_.pop());
-                    else
-                        break;
-
-                }
-                update_queue_.emplace(update);
-                notify_event_.notify_one();
-            } else {
-                delayed_update_queue_.emplace(update);
-            }
-        } else {
-            update_queue_.emplace(update);
-            notify_event_.notify_one();
-        }
+        update_ingress_.push(update);
+        notify();
     }
      
     void triggerEvent() 
     {
-        notify_event_.notify_one();
+        event_triggered_ = true;
+        notify();
+    }
+
+    /**
+     * @brief Bound the time an update waits for predictions to reach its stamp. After the
+     *        timeout, the prediction model applied last may extrapolate, see
+     *        PredictionModel::extrapolate. Otherwise the update is deferred, the filter
+     *        thread serves requests and new inputs before it retries the update.
+     *        Once no prediction arrived for more than max_deferrals timeouts, updates are
+     *        extrapolated or dropped right away, until predictions arrive again. While
+     *        predictions are missing, an update is thus resolved after at most
+     *        (max_deferrals + 1) timeouts.
+     * @param timeout       - the timeout, zero waits indefinitely
+     * @param max_deferrals - timeouts without predictions, before updates are not deferred anymore
+     */
+    inline void setPredictionTimeout(const duration_t  &timeout,
+                                     const std::size_t  max_deferrals = 3)
+    {
+        prediction_timeout_ns_    = timeout.nanoseconds();
+        prediction_max_deferrals_ = max_deferrals;
+    }
+
+    inline PredictionStatistics getPredictionStatistics() const
+    {
+        PredictionStatistics statistics;
+        statistics.waits          = prediction_waits_;
+        statistics.timeouts       = prediction_timeouts_;
+        statistics.extrapolations = prediction_extrapolations_;
+        statistics.deferrals      = prediction_deferrals_;
+        statistics.drops          = prediction_drops_;
+        return statistics;
+    }
+
+    /**
+     * @brief Stage durations, queue depths and counters of the filter. Lock-free, may be
+     *        called from any thread while the filter is running.
+     * @return a snapshot of the metrics
+     */
+    inline metrics_t getMetrics() const
+    {
+        return metrics_.snapshot(sample_set_->getDensityHistogram());
+    }
+
+    /**
+     * @brief Record predictions, updates, resamplings and published states into a trace.
+     *        Has to be set before the filter is started.
+     * @param trace     - the trace, nullptr disables tracing
+     */
+    inline void setTrace(const Trace::Ptr &trace)
+    {
+        trace_ = trace;
+    }
+
+    /**
+     * @brief Process queued inputs on the calling thread, without starting the filter thread.
+     *        Updates are processed in time order as long as queued predictions reach their
+     *        stamps, the first update lacking predictions stays queued. Given a fixed random
+     *        seed of the sample set, the same inputs yield the same result independent of
+     *        how they are split into steps.
+     * @return the amount of updates processed
+     */
+    inline std::size_t step()
+    {
+        return processSynchronous(time_t(), false);
+    }
+
+    /**
+     * @brief Process queued inputs on the calling thread, like step, but only updates
+     *        with stamps up to a given time.
+     * @param until     - the latest update stamp to process
+     * @return the amount of updates processed
+     */
+    inline std::size_t processUntil(const time_t &until)
+    {
+        return processSynchronous(until, true);
     }
     
     /**
@@ -257,7 +351,11 @@ protected:
     atomic_bool_t                           request_init_state_;
     atomic_bool_t                           request_init_uniform_;
 
-    /// processing queues
+    /// ingress queues, filled by producers, drained by the worker thread
+    update_ingress_t                        update_ingress_;
+    prediction_ingress_t                    prediction_ingress_;
+
+    /// processing queues, owned by the worker thread
     update_queue_t                          update_queue_;
     update_queue_t                          delayed_update_queue_;
     prediction_queue_t                      prediction_queue_;
@@ -265,25 +363,204 @@ protected:
     duration_t                              lag_;
     std::size_t                             lag_source_;
     bool                                    enable_lag_correction_;
+    bool                                    fuse_updates_;
     bool                                    has_valid_state_;
     bool                                    reset_all_accumulators_after_update_;
     bool                                    reset_model_accumulators_after_resampling_;
 
+    /// bounded prediction wait
+    std::atomic<int64_t>                    prediction_timeout_ns_;
+    std::atomic<std::size_t>                prediction_max_deferrals_;
+    std::size_t                             prediction_stalls_;         /// timeouts since the last prediction arrived
+    typename update_t::Ptr                  deferred_update_;
+    typename prediction_model_t::Ptr        last_prediction_model_;
+    typename prediction_result_t::ConstPtr  last_prediction_result_;
+    std::atomic<std::size_t>                prediction_waits_;
+    std::atomic<std::size_t>                prediction_timeouts_;
+    std::atomic<std::size_t>                prediction_extrapolations_;
+    std::atomic<std::size_t>                prediction_deferrals_;
+    std::atomic<std::size_t>                prediction_drops_;
+
+    /// stage durations and counters
+    SMCMetrics                              metrics_;
+    Trace::Ptr                              trace_;
+
+    inline static int64_t elapsed(const std::chrono::steady_clock::time_point &start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
     /// background thread
     mutex_t                                 worker_thread_mutex_;
     thread_t                                worker_thread_;
     atomic_bool_t                           worker_thread_active_;
     atomic_bool_t                           worker_thread_exit_;
+    atomic_bool_t                           worker_thread_waiting_;
+    atomic_bool_t                           event_triggered_;
     condition_variable_t                    notify_event_;
     mutable mutex_t                         notify_event_mutex_;
-    condition_variable_t                    notify_prediction_;
-    mutable mutex_t                         notify_prediction_mutex_;
+
+    /**
+     * @brief Wake the worker thread. Producers only take the lock if the worker is
+     *        waiting, the lock orders the notification after the worker started waiting.
+     */
+    inline void notify()
+    {
+        if (worker_thread_waiting_) {
+            lock_t l(notify_event_mutex_);
+            notify_event_.notify_one();
+        }
+    }
+
+    /**
+     * @brief Block the worker thread until ready returns true or the filter is ended.
+     * @param ready     - the wake up condition
+     */
+    template<typename predicate_t>
+    inline void wait(const predicate_t &ready)
+    {
+        lock_t l(notify_event_mutex_);
+        worker_thread_waiting_ = true;
+        notify_event_.wait(l, [this, &ready]() {
+            return worker_thread_exit_ || ready();
+        });
+        worker_thread_waiting_ = false;
+    }
+
+    /**
+     * @brief Block the worker thread until ready returns true, the filter is ended or the timeout expires.
+     * @param ready     - the wake up condition
+     * @param timeout   - the timeout in nanoseconds
+     * @return false if the timeout expired
+     */
+    template<typename predicate_t>
+    inline bool wait(const predicate_t &ready,
+                     const int64_t      timeout)
+    {
+        lock_t l(notify_event_mutex_);
+        worker_thread_waiting_ = true;
+        const bool woken = notify_event_.wait_for(l, std::chrono::nanoseconds(timeout), [this, &ready]() {
+            return worker_thread_exit_ || ready();
+        });
+        worker_thread_waiting_ = false;
+        return woken;
+    }
+
+    /**
+     * @brief Let the prediction model applied last propagate the samples up to a time.
+     * @param until     - the time to extrapolate to
+     * @return false if the model declined
+     */
+    inline bool extrapolate(const cslibs_time::Time &until)
+    {
+        if (!last_prediction_model_)
+            return false;
+
+        const auto start = std::chrono::steady_clock::now();
+        typename prediction_result_t::Ptr prediction_result =
+                last_prediction_model_->extrapolate(last_prediction_result_, until, sample_set_->getStateIterator());
+        const int64_t duration = elapsed(start);
+        metrics_.predict.add(duration);
+        if (!prediction_result || !prediction_result->success())
+            return false;
+        if (trace_)
+            trace_->addPrediction(prediction_result->applied->timeFrame().end, duration, TraceEvent::Extrapolated);
+
+        prediction_integrals_->add(prediction_result);
+        sample_set_->setStamp(prediction_result->applied->timeFrame().end);
+        last_prediction_result_ = prediction_result;
+        return true;
+    }
+
+    /**
+     * @brief Move pending updates into the time ordered queue, lag correction holds back
+     *        updates of all sources but the one with the largest lag.
+     */
+    inline void drainUpdates()
+    {
+        typename update_t::Ptr update;
+        while (update_ingress_.pop(update)) {
+            const std::size_t        id       = update->getModelId();
+            const cslibs_time::Time &stamp    = update->getStamp();
+            const int64_t            received = std::max(static_cast<int64_t>(0),
+                                                         static_cast<int64_t>(update->stampReceived().nanoseconds() - stamp.nanoseconds()));
+            if (!enable_lag_correction_) {
+                metrics_.setLag(id, received);
+                update_queue_.emplace(update);
+                continue;
+            }
+
+            cslibs_time::statistics::DurationLowpass &lag = lag_map_[id];
+            lag += cslibs_time::Duration(received);
+            metrics_.setLag(id, lag.duration().nanoseconds());
+            if (lag.duration() >= lag_) {
+                lag_ = lag.duration();
+                lag_source_ = id;
+            }
+            if (id == lag_source_) {
+                while (!delayed_update_queue_.empty() &&
+                       delayed_update_queue_.top()->getStamp() <= stamp) {
+                    update_queue_.emplace(delayed_update_queue_.top());
+                    delayed_update_queue_.pop();
+                }
+                update_queue_.emplace(update);
+            } else {
+                delayed_update_queue_.emplace(update);
+            }
+        }
+    }
+
+    /**
+     * @brief Group an update with all queued updates of the same stamp, whose models are
+     *        fusable and due. The remaining updates are left in the queue.
+     * @param u         - the update to start with
+     * @return the fused update or u, if there is nothing to fuse with
+     */
+    inline typename update_t::Ptr fuse(const typename update_t::Ptr &u)
+    {
+        if (!u->getModel()->isFusable())
+            return u;
+
+        drainUpdates();
+
+        const cslibs_time::Time &t = u->getStamp();
+        typename update_t::updates_t fused(1, u);
+        typename update_t::updates_t remaining;
+        while (!update_queue_.empty() && update_queue_.top()->getStamp() == t) {
+            typename update_t::Ptr o = update_queue_.top();
+            update_queue_.pop();
+            if (o->getModel()->isFusable() && prediction_integrals_->thresholdExceeded(o->getModelId()))
+                fused.emplace_back(o);
+            else
+                remaining.emplace_back(o);
+        }
+        for (const typename update_t::Ptr &o : remaining)
+            update_queue_.emplace(o);
+
+        return fused.size() > 1 ? update_t::fuse(fused) : u;
+    }
+
+    /**
+     * @brief Move pending predictions into the time ordered queue.
+     */
+    inline void drainPredictions()
+    {
+        typename prediction_t::Ptr prediction;
+        while (prediction_ingress_.pop(prediction)) {
+            prediction_queue_.emplace(prediction);
+            prediction_stalls_ = 0;
+        }
+    }
 
     inline void requests()
     {
+        if (!request_init_uniform_ && !request_init_state_)
+            return;
+
+        Histogram::Timer timer(metrics_.requests);
         if (request_init_uniform_) {
             if (sample_uniform_->apply(*sample_set_)) {
-                state_publisher_->publishIntermediate(sample_set_);
+                state_publisher_->publishIntermediateSnapshot(sample_set_, sample_set_->snapshot());
                 sample_set_->setStamp(init_time_);
                 request_init_uniform_   = false;
                 has_valid_state_        = false;
@@ -297,7 +574,7 @@ protected:
                                       init_state_covariance_,
                                       *sample_set_)) {
                 sample_set_->setStamp(init_time_);
-                state_publisher_->publish(sample_set_);
+                state_publisher_->publishSnapshot(sample_set_, sample_set_->snapshot());
                 request_init_state_  = false;
                 has_valid_state_     = true;
                 prediction_integrals_->resetAll();
@@ -306,29 +583,71 @@ protected:
         }
     }
 
-    inline void predict(const cslibs_time::Time &until)
+    /**
+     * @brief Propagate the sample set up to a time.
+     * @param until     - the target time
+     * @param blocking  - wait for predictions, otherwise return as soon as the queued predictions are used up
+     * @return false if the target time could not be reached without waiting
+     */
+    inline bool predict(const cslibs_time::Time &until,
+                        const bool               blocking)
     {
         auto wait_for_prediction = [this] () {
-            lock_t l(notify_prediction_mutex_);
-            notify_prediction_.wait(l);
+            auto ready = [this]() {
+                return !prediction_ingress_.empty();
+            };
+            const int64_t timeout = prediction_timeout_ns_;
+            if (timeout <= 0) {
+                wait(ready);
+                return true;
+            }
+            return wait(ready, timeout);
         };
 
         const cslibs_time::Time &time_stamp = sample_set_->getStamp();
         while (until > time_stamp) {
-            if (prediction_queue_.empty())
-                wait_for_prediction();
+            drainPredictions();
+            if (prediction_queue_.empty()) {
+                if (!blocking || worker_thread_exit_)
+                    return false;
+
+                /// predictions stalled for too long are not waited for until they arrive again
+                if (prediction_stalls_ <= prediction_max_deferrals_) {
+                    ++prediction_waits_;
+                    if (wait_for_prediction())
+                        continue;
+                    ++prediction_timeouts_;
+                    ++prediction_stalls_;
+                }
+
+                /// the prediction is late, extrapolate or let the caller defer the update
+                if (extrapolate(until)) {
+                    ++prediction_extrapolations_;
+                    continue;
+                }
+                return false;
+            }
 
-            typename prediction_t::Ptr prediction = prediction_queue_.pop();
+            typename prediction_t::Ptr prediction = prediction_queue_.top();
+            prediction_queue_.pop();
             if (prediction->getStamp() < time_stamp) {
                 /// drop odometry messages which are too old
+                ++metrics_.dropped_predictions;
                 continue;
             }
 
             /// mutate time stamp
+            const auto start = std::chrono::steady_clock::now();
             typename prediction_result_t::Ptr prediction_result = prediction->apply(until, sample_set_->getStateIterator());
+            const int64_t duration = elapsed(start);
+            metrics_.predict.add(duration);
             if (prediction_result->success()) {
+                if (trace_)
+                    trace_->addPrediction(prediction_result->applied->timeFrame().end, duration);
                 prediction_integrals_->add(prediction_result);
                 sample_set_->setStamp(prediction_result->applied->timeFrame().end);
+                last_prediction_model_  = prediction->getModel();
+                last_prediction_result_ = prediction_result;
 
                 if (prediction_result->left_to_apply) {
                     typename prediction_t::Ptr prediction_left_to_apply
@@ -338,74 +657,210 @@ protected:
                 }
             } else {
                 prediction_queue_.emplace(prediction);
+                if (!blocking)
+                    return false;
             }
         }
+        return true;
     }
 
-    inline void loop()
+    /**
+     * @brief The earliest update, either the deferred one or the first queued one.
+     */
+    inline typename update_t::Ptr nextUpdate()
     {
-        worker_thread_active_ = true;
-        lock_t notify_event_mutex_lock(notify_event_mutex_);
+        typename update_t::Ptr u;
+        if (deferred_update_ &&
+                (update_queue_.empty() || !typename update_t::Greater()(deferred_update_, update_queue_.top()))) {
+            std::swap(u, deferred_update_);
+            return u;
+        }
+        u = update_queue_.top();
+        update_queue_.pop();
+        return u;
+    }
 
-        while (!worker_thread_exit_) {
-            if(!update_queue_.hasElements())
-                notify_event_.wait(notify_event_mutex_lock);
+    inline bool hasUpdates() const
+    {
+        return !update_queue_.empty() || deferred_update_;
+    }
 
-            requests();
+    /**
+     * @brief Park an update predictions did not arrive for in time, or drop it if they are
+     *        missing for longer than the deferrals allow.
+     * @return false if the update was deferred
+     */
+    inline bool defer(const typename update_t::Ptr &u)
+    {
+        if (prediction_stalls_ > prediction_max_deferrals_) {
+            ++prediction_drops_;
+            ++metrics_.dropped_updates;
+            return true;
+        }
+        ++prediction_deferrals_;
+        deferred_update_ = u;
+        return false;
+    }
 
-            if (worker_thread_exit_)
-                break;
+    /**
+     * @brief Process the earliest update, including prediction, resampling and publication.
+     * @param blocking  - wait for predictions to reach the stamp of the update
+     * @return false if the update had to be deferred, because predictions were missing
+     */
+    inline bool process(const bool blocking)
+    {
+        requests();
+
+        typename update_t::Ptr   u = nextUpdate();
+        const cslibs_time::Time &t = u->getStamp();
+        const cslibs_time::Time &sample_set_stamp = sample_set_->getStamp();
+
+        int8_t publication = has_valid_state_ ?  static_cast<int8_t>(Publication::Constant) : static_cast<int8_t>(Publication::None);
+
+        if (t >= sample_set_stamp) {
+
+            const bool predicted = predict(t, blocking);
+
+            if (t > sample_set_stamp) {
+                /// deferred updates must not trigger resampling, results would depend on input timing
+                if (!predicted && blocking && !worker_thread_exit_)
+                    return defer(u);
+
+                update_queue_.emplace(u);
+                ++metrics_.reemplaced_updates;
+                if (!predicted)
+                    return false;
+            } else if (t == sample_set_stamp) {
+                const auto model_id = u->getModelId();
+                if (prediction_integrals_->thresholdExceeded(model_id)) {
+                    if (fuse_updates_)
+                        u = fuse(u);
+                    const auto start = std::chrono::steady_clock::now();
+                    if (scheduler_->apply(u, sample_set_)) {
+                        const int64_t duration = elapsed(start);
+                        metrics_.update.add(duration);
+                        if (u->isFused()) {
+                            /// the pass is shared, every fused model is charged an equal part, so traced durations add up to the pass
+                            const int64_t share = duration / static_cast<int64_t>(u->getFused().size());
+                            for (const typename update_t::Ptr &f : u->getFused()) {
+                                metrics_.model(f->getModelId()).add(share);
+                                if (trace_)
+                                    trace_->addUpdate(t, f->getModelId(), share);
+                            }
+                        } else {
+                            metrics_.model(model_id).add(duration);
+                            if (trace_)
+                                trace_->addUpdate(t, model_id, duration);
+                        }
+                        resampling_->updateRecovery(*sample_set_);
+                        if(reset_all_accumulators_after_update_)
+                            prediction_integrals_->resetAll();
+                        else if(u->isFused()) {
+                            for(const typename update_t::Ptr &f : u->getFused())
+                                prediction_integrals_->reset(f->getModelId());
+                        } else
+                            prediction_integrals_->reset(model_id);
+                    }
+                    publication |= static_cast<int8_t>(Publication::Intermediate);
+                }
+            }
+        } else {
+            ++metrics_.dropped_updates;
+        }
 
-            while (update_queue_.hasElements()) {
-                if (worker_thread_exit_)
-                    break;
+        const auto start = std::chrono::steady_clock::now();
+        if (prediction_integrals_->thresholdExceeded() &&
+                scheduler_->apply(resampling_, sample_set_)) {
+            const int64_t duration = elapsed(start);
+            metrics_.resampling.add(duration);
+            if (trace_)
+                trace_->addResampling(sample_set_->getStamp(), duration);
 
-                requests();
+            prediction_integrals_->reset();
 
-                typename update_t::Ptr   u = update_queue_.pop();
-                const cslibs_time::Time &t = u->getStamp();
-                const cslibs_time::Time &sample_set_stamp = sample_set_->getStamp();
+            if(reset_model_accumulators_after_resampling_)
+                prediction_integrals_->resetAll();
 
-                int8_t publication = has_valid_state_ ?  static_cast<int8_t>(Publication::Constant) : static_cast<int8_t>(Publication::None);
+            publication |= static_cast<int8_t>(Publication::Resampling);
+            has_valid_state_ = true;
+        }
 
-                if (t >= sample_set_stamp) {
+        if(publication != static_cast<int8_t>(Publication::None)) {
+            Histogram::Timer timer(metrics_.publication);
+            /// the snapshot only costs a reference count, the filter moves on to another buffer while it is held
+            const typename sample_set_t::snapshot_t snapshot = sample_set_->snapshot();
+            if(publication >= static_cast<int8_t>(Publication::Resampling))
+                state_publisher_->publishSnapshot(sample_set_, snapshot);
+            else if(publication >= static_cast<int8_t>(Publication::Constant))
+                state_publisher_->publishConstantSnapshot(sample_set_, snapshot);
+            else
+                state_publisher_->publishIntermediateSnapshot(sample_set_, snapshot);
+            if (trace_)
+                trace_->addState(sample_set_->getStamp());
+        }
 
-                    predict(t);
+        drainUpdates();
+        metrics_.update_queue_depth.store(update_queue_.size(), std::memory_order_relaxed);
+        metrics_.delayed_update_queue_depth.store(delayed_update_queue_.size(), std::memory_order_relaxed);
+        metrics_.prediction_queue_depth.store(prediction_queue_.size(), std::memory_order_relaxed);
+        return true;
+    }
 
-                    if (t > sample_set_stamp) {
-                        update_queue_.emplace(u);
-                    } else if (t == sample_set_stamp) {
-                        const auto model_id = u->getModelId();
-                        if (prediction_integrals_->thresholdExceeded(model_id)) {
-                            if (scheduler_->apply(u, sample_set_)) {
-                                resampling_->updateRecovery(*sample_set_);
-                                if(reset_all_accumulators_after_update_)
-                                    prediction_integrals_->resetAll();
-                                else
-                                    prediction_integrals_->reset(model_id);
-                            }
-                            publication |= static_cast<int8_t>(Publication::Intermediate);
-                        }
-                    }
-                }
-                if (prediction_integrals_->thresholdExceeded() &&
-                        scheduler_->apply(resampling_, sample_set_)) {
+    /**
+     * @brief Process queued updates on the calling thread without waiting.
+     * @param until     - the latest stamp to process
+     * @param bounded   - if false, all updates covered by queued predictions are processed
+     * @return the amount of updates processed
+     */
+    inline std::size_t processSynchronous(const cslibs_time::Time &until,
+                                          const bool               bounded)
+    {
+        if (worker_thread_active_) {
+            std::cerr << "[SMC]: Synchronous processing is not possible while the filter thread is running!" << "\n";
+            return 0;
+        }
 
-                    prediction_integrals_->reset();
+        drainUpdates();
+        event_triggered_ = false;
+        requests();
 
-                    if(reset_model_accumulators_after_resampling_)
-                        prediction_integrals_->resetAll();
+        std::size_t processed = 0;
+        while (!update_queue_.empty()) {
+            if (bounded && update_queue_.top()->getStamp() > until)
+                break;
+            if (!process(false))
+                break;
+            ++processed;
+        }
+        return processed;
+    }
 
-                    publication |= static_cast<int8_t>(Publication::Resampling);
-                    has_valid_state_ = true;
-                }
+    inline void loop()
+    {
+        worker_thread_active_ = true;
 
-                if(publication >= static_cast<int8_t>(Publication::Resampling))
-                    state_publisher_->publish(sample_set_);
-                else if(publication >= static_cast<int8_t>(Publication::Constant))
-                    state_publisher_->publishConstant(sample_set_);
-                else if(publication >= static_cast<int8_t>(Publication::Intermediate))
-                    state_publisher_->publishIntermediate(sample_set_);
+        while (!worker_thread_exit_) {
+            drainUpdates();
+            if(!hasUpdates()) {
+                wait([this]() {
+                    return event_triggered_ || !update_ingress_.empty();
+                });
+                drainUpdates();
+            }
+            event_triggered_ = false;
+
+            requests();
+
+            if (worker_thread_exit_)
+                break;
+
+            while (hasUpdates()) {
+                if (worker_thread_exit_)
+                    break;
+
+                /// a deferred update is retried after requests and new inputs were served
+                if (!process(true))
+                    break;
             }
         }
         worker_thread_active_ = false;
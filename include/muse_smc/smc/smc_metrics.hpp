@@ -0,0 +1,182 @@
+#ifndef MUSE_SMC_METRICS_HPP
+#define MUSE_SMC_METRICS_HPP
+
+/// PROJECT
+#include <muse_smc/utility/histogram.hpp>
+
+/// SYSTEM
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace muse_smc {
+/**
+ * @brief The SMCMetrics class collects stage durations and counters of the filter.
+ *        The filter thread records, any thread may take snapshots concurrently, neither
+ *        side takes locks. Recording costs a few relaxed atomic increments per stage.
+ */
+class SMCMetrics
+{
+public:
+    /**
+     * @brief Per update model statistics, lag is the delay of the last update as
+     *        received, or the smoothed delay if lag correction is enabled.
+     */
+    struct ModelSnapshot {
+        std::size_t         id = 0;
+        Histogram::Snapshot update;
+        std::int64_t        lag = 0;
+    };
+
+    /**
+     * @brief Copy of all metrics, durations are given in nanoseconds.
+     */
+    struct Snapshot {
+        Histogram::Snapshot        requests;
+        Histogram::Snapshot        predict;
+        Histogram::Snapshot        update;
+        Histogram::Snapshot        resampling;
+        Histogram::Snapshot        density;
+        Histogram::Snapshot        publication;
+        std::vector<ModelSnapshot> models;
+
+        std::uint64_t dropped_predictions  = 0;
+        std::uint64_t dropped_updates      = 0;
+        std::uint64_t reemplaced_updates   = 0;
+        std::size_t   update_queue_depth         = 0;
+        std::size_t   delayed_update_queue_depth = 0;
+        std::size_t   prediction_queue_depth     = 0;
+    };
+
+    /// stage durations
+    Histogram requests;
+    Histogram predict;
+    Histogram update;
+    Histogram resampling;
+    Histogram publication;
+
+    /// predictions older than the sample set, updates older than the sample set
+    /// and updates put back into the queue to wait for predictions
+    std::atomic<std::uint64_t> dropped_predictions;
+    std::atomic<std::uint64_t> dropped_updates;
+    std::atomic<std::uint64_t> reemplaced_updates;
+
+    /// queue depths after the last update was processed
+    std::atomic<std::size_t>   update_queue_depth;
+    std::atomic<std::size_t>   delayed_update_queue_depth;
+    std::atomic<std::size_t>   prediction_queue_depth;
+
+    inline SMCMetrics() :
+        dropped_predictions(0),
+        dropped_updates(0),
+        reemplaced_updates(0),
+        update_queue_depth(0),
+        delayed_update_queue_depth(0),
+        prediction_queue_depth(0),
+        models_(0)
+    {
+        for (Model &m : model_)
+            m.lag.store(0, std::memory_order_relaxed);
+        overflow_.lag.store(0, std::memory_order_relaxed);
+        overflow_.id = std::numeric_limits<std::size_t>::max();
+    }
+
+    SMCMetrics(const SMCMetrics &other) = delete;
+    SMCMetrics& operator = (const SMCMetrics &other) = delete;
+
+    /**
+     * @brief Update duration histogram of a model. Models beyond the capacity share
+     *        one histogram with the id std::numeric_limits<std::size_t>::max().
+     *        Only the filter thread may call this.
+     * @param id    - the model id
+     */
+    inline Histogram & model(const std::size_t id)
+    {
+        return slot(id).update;
+    }
+
+    /**
+     * @brief Set the lag of a model, only the filter thread may call this.
+     * @param id            - the model id
+     * @param nanoseconds   - the lag
+     */
+    inline void setLag(const std::size_t  id,
+                       const std::int64_t nanoseconds)
+    {
+        slot(id).lag.store(nanoseconds, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Take a snapshot, may be called from any thread.
+     * @param density   - density estimation durations, see SampleSet::getDensityHistogram
+     */
+    inline Snapshot snapshot(const Histogram &density) const
+    {
+        Snapshot s;
+        s.requests    = requests.snapshot();
+        s.predict     = predict.snapshot();
+        s.update      = update.snapshot();
+        s.resampling  = resampling.snapshot();
+        s.density     = density.snapshot();
+        s.publication = publication.snapshot();
+
+        const std::size_t models = models_.load(std::memory_order_acquire);
+        s.models.reserve(models + 1);
+        for (std::size_t i = 0 ; i < models ; ++i)
+            s.models.emplace_back(snapshot(model_[i]));
+        if (overflow_.update.snapshot().count > 0)
+            s.models.emplace_back(snapshot(overflow_));
+
+        s.dropped_predictions        = dropped_predictions.load(std::memory_order_relaxed);
+        s.dropped_updates            = dropped_updates.load(std::memory_order_relaxed);
+        s.reemplaced_updates         = reemplaced_updates.load(std::memory_order_relaxed);
+        s.update_queue_depth         = update_queue_depth.load(std::memory_order_relaxed);
+        s.delayed_update_queue_depth = delayed_update_queue_depth.load(std::memory_order_relaxed);
+        s.prediction_queue_depth     = prediction_queue_depth.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    struct Model {
+        std::size_t               id;
+        Histogram                 update;
+        std::atomic<std::int64_t> lag;
+    };
+
+    std::array<Model, 16>    model_;
+    Model                    overflow_;
+    std::atomic<std::size_t> models_;
+
+    /**
+     * @brief Find the slot of a model, slots are claimed once and published by
+     *        incrementing the slot count.
+     */
+    inline Model & slot(const std::size_t id)
+    {
+        const std::size_t models = models_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0 ; i < models ; ++i) {
+            if (model_[i].id == id)
+                return model_[i];
+        }
+        if (models == model_.size())
+            return overflow_;
+
+        model_[models].id = id;
+        models_.store(models + 1, std::memory_order_release);
+        return model_[models];
+    }
+
+    inline static ModelSnapshot snapshot(const Model &m)
+    {
+        ModelSnapshot s;
+        s.id     = m.id;
+        s.update = m.update.snapshot();
+        s.lag    = m.lag.load(std::memory_order_relaxed);
+        return s;
+    }
+};
+}
+
+#endif // MUSE_SMC_METRICS_HPP
@@ -11,6 +11,12 @@ namespace muse_smc {
 /**
  * @brief The SMCState class is used to communicate the filter state to the outside world.
  *        E.g. for the ROS use case one would publish the sample set and the mean.
+ *        Publication is called from the filter thread with the live sample set, which is
+ *        modified again right after, and with a snapshot of it, which may be kept and
+ *        handed to other threads, see SampleSetSnapshot. The snapshot overloads forward
+ *        to the ones taking the live set by default. The mean is best taken from a sample
+ *        set estimator, see SampleSet::setEstimator, which avoids another pass over the
+ *        samples.
  * @brief state_space_description_t     - the state space description applying to a given problem.
  */
 template<typename state_space_description_t>
@@ -20,6 +26,7 @@ public:
     using Ptr           = std::shared_ptr<SMCState>;
     using sample_t      = typename state_space_description_t::sample_t;
     using sample_set_t  = SampleSet<state_space_description_t>;
+    using snapshot_t    = typename sample_set_t::snapshot_t;
     /**
      * @brief Default desctructor.
      */
@@ -40,6 +47,35 @@ public:
      * @param sample_set
      */
     virtual void publishConstant(const typename sample_set_t::ConstPtr &sample_set)     = 0;
+    /**
+     * @brief Publish a valid belief state, after resampling. The snapshot shares the sample
+     *        buffer, while it is held the filter continues on a recycled buffer. Predictions
+     *        and updates copy each sample over as they visit it, other modifications, e.g.
+     *        normalization on its own, copy the samples at once. Release it once it was read.
+     * @param sample_set    - the live sample set, only valid during the call
+     * @param snapshot      - the snapshot of the sample set
+     */
+    virtual void publishSnapshot(const typename sample_set_t::ConstPtr &sample_set,
+                                 const snapshot_t                      &snapshot)
+    {
+        publish(sample_set);
+    }
+    /**
+     * @brief Publish an intermediate state as snapshot, see publishSnapshot.
+     */
+    virtual void publishIntermediateSnapshot(const typename sample_set_t::ConstPtr &sample_set,
+                                             const snapshot_t                      &snapshot)
+    {
+        publishIntermediate(sample_set);
+    }
+    /**
+     * @brief Publish a constant state as snapshot, see publishSnapshot.
+     */
+    virtual void publishConstantSnapshot(const typename sample_set_t::ConstPtr &sample_set,
+                                         const snapshot_t                      &snapshot)
+    {
+        publishConstant(sample_set);
+    }
 };
 }
 
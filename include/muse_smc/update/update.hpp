@@ -5,6 +5,10 @@
 #include <muse_smc/samples/sample_set.hpp>
 #include <cslibs_time/time_frame.hpp>
 
+#include <vector>
+#include <cassert>
+#include <algorithm>
+
 namespace muse_smc {
 template<typename state_space_description_t, typename data_t>
 class Update {
@@ -14,6 +18,7 @@ public:
     using update_model_t = UpdateModel<state_space_description_t, data_t>;
     using sample_set_t   = SampleSet<state_space_description_t>;
     using state_space_t  = StateSpace<state_space_description_t>;
+    using updates_t      = std::vector<Ptr>;
 
     struct Less {
         bool operator()( const Update& lhs,
@@ -59,15 +64,50 @@ public:
 
     virtual ~Update() = default;
 
+    /**
+     * @brief Fuse updates sharing a stamp. All models are evaluated per sample in a single
+     *        pass and weights are normalized once. The models have to be fusable.
+     * @param updates   - the updates to fuse
+     * @return the fused update, it reports model and data of the first update
+     */
+    static inline Ptr fuse(const updates_t &updates)
+    {
+        assert(!updates.empty());
+        const Ptr &first = updates.front();
+        Ptr fused(new Update(first->data_, first->state_space_, first->model_));
+        fused->fused_ = updates;
+        return fused;
+    }
+
     inline void operator()
         (typename sample_set_t::weight_iterator_t weights)
     {
-        model_->update(data_, state_space_, weights);
+        model_->update(data_, state_space_, std::move(weights));
     }
 
     inline void apply(typename sample_set_t::weight_iterator_t weights)
     {
-        model_->apply(data_, state_space_, weights);
+        const ThreadPool::Ptr &thread_pool = weights.getThreadPool();
+        if(!fused_.empty()) {
+            if(thread_pool && thread_pool->size() > 1) {
+                auto partitions = weights.partition(thread_pool->size());
+                thread_pool->parallelFor(partitions.size(), [this, &partitions](const std::size_t i) {
+                    applyFused(partitions[i]);
+                });
+                return;
+            }
+            applyFused(weights);
+            return;
+        }
+        if(thread_pool && thread_pool->size() > 1 && model_->isPartitionable()) {
+            /// partitions have to be released before the weight iteration finishes
+            auto partitions = weights.partition(thread_pool->size());
+            thread_pool->parallelFor(partitions.size(), [this, &partitions](const std::size_t i) {
+                model_->apply(data_, state_space_, std::move(partitions[i]));
+            });
+            return;
+        }
+        model_->apply(data_, state_space_, std::move(weights));
     }
 
     inline cslibs_time::Time const & getStamp() const
@@ -95,10 +135,46 @@ public:
         return model_->getId();
     }
 
+    inline bool isFused() const
+    {
+        return !fused_.empty();
+    }
+
+    /**
+     * @brief The updates a fused update consists of, empty otherwise.
+     */
+    inline const updates_t & getFused() const
+    {
+        return fused_;
+    }
+
 private:
     const typename data_t::ConstPtr        data_;
     const typename state_space_t::ConstPtr state_space_;
     typename update_model_t::Ptr           model_;
+    updates_t                              fused_;
+
+    inline void applyFused(typename sample_set_t::weight_iterator_t &weights) const
+    {
+        auto span = weights.span();
+        if(weights.isLogDomain()) {
+            for(std::size_t i = 0 ; i < span.size() ; ++i) {
+                double log_likelihood = 0.0;
+                /// clamped, so that a model returning -inf or NaN does not poison the weights
+                for(const Ptr &u : fused_)
+                    log_likelihood += std::max(kernels::minimumLogWeight(),
+                                               u->model_->logLikelihood(u->data_, u->state_space_, span.state(i)));
+                span.weight(i) += log_likelihood;
+            }
+        } else {
+            for(std::size_t i = 0 ; i < span.size() ; ++i) {
+                double likelihood = 1.0;
+                for(const Ptr &u : fused_)
+                    likelihood *= u->model_->likelihood(u->data_, u->state_space_, span.state(i));
+                span.weight(i) *= likelihood;
+            }
+        }
+    }
 };
 }
 
@@ -2,6 +2,8 @@
 #define UPDATE_MODEL_HPP
 
 #include <memory>
+#include <cmath>
+#include <limits>
 
 #include <muse_smc/state_space/state_space.hpp>
 #include <muse_smc/samples/sample_set.hpp>
@@ -12,6 +14,7 @@ class UpdateModel {
 public:
     using Ptr           = std::shared_ptr<UpdateModel>;
     using sample_t      = typename state_space_description_t::sample_t;
+    using state_t       = typename state_space_description_t::state_t;
     using sample_set_t  = SampleSet<state_space_description_t>;
     using state_space_t = StateSpace<state_space_description_t>;
 
@@ -23,9 +26,53 @@ public:
 
     virtual std::size_t getId() const = 0;
     virtual const std::string getName() const = 0;
+
+    /**
+     * @brief If true, apply may be called concurrently on disjoint partitions of the
+     *        sample set, every call receives a weight iteration over its partition only.
+     *        Models have to be free of mutable state shared between calls then.
+     */
+    virtual bool isPartitionable() const
+    {
+        return false;
+    }
+
     virtual void apply(const typename data_t::ConstPtr          &data,
                        const typename state_space_t::ConstPtr   &state_space,
                        typename sample_set_t::weight_iterator_t  weights) = 0;
+
+    /**
+     * @brief If true, the model evaluates single states through likelihood. Updates
+     *        sharing a stamp can then be fused and weighted in a single pass.
+     */
+    virtual bool isFusable() const
+    {
+        return false;
+    }
+
+    /**
+     * @brief The likelihood of a single state, only called if the model is fusable.
+     *        May be called concurrently.
+     */
+    virtual double likelihood(const typename data_t::ConstPtr          &data,
+                              const typename state_space_t::ConstPtr   &state_space,
+                              const state_t                            &state) const
+    {
+        return 1.0;
+    }
+
+    /**
+     * @brief The log-likelihood of a single state, used for log weights. It has to be
+     *        finite, a likelihood of 0 maps to kernels::minimumLogWeight.
+     */
+    virtual double logLikelihood(const typename data_t::ConstPtr          &data,
+                                 const typename state_space_t::ConstPtr   &state_space,
+                                 const state_t                            &state) const
+    {
+        const double minimum    = std::numeric_limits<double>::min();
+        const double likelihood = this->likelihood(data, state_space, state);
+        return std::log(likelihood > minimum ? likelihood : minimum);
+    }
 };
 }
 
@@ -0,0 +1,116 @@
+#ifndef MUSE_SMC_ASYNC_WORKER_HPP
+#define MUSE_SMC_ASYNC_WORKER_HPP
+
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+namespace muse_smc {
+/**
+ * @brief The AsyncWorker class runs tasks one at a time on a helper thread. Submitting
+ *        a task while another one is running waits for it, so at most one task is
+ *        pending. Waiting for an idle worker takes no lock.
+ */
+class AsyncWorker
+{
+public:
+    using Ptr     = std::shared_ptr<AsyncWorker>;
+    using task_t  = std::function<void()>;
+    using mutex_t = std::mutex;
+    using lock_t  = std::unique_lock<mutex_t>;
+
+    inline AsyncWorker() :
+        busy_(false),
+        stop_(false)
+    {
+        thread_ = std::thread([this](){loop();});
+    }
+
+    AsyncWorker(const AsyncWorker &other) = delete;
+    AsyncWorker& operator = (const AsyncWorker &other) = delete;
+
+    /**
+     * @brief Finishes the running task before the helper thread is joined.
+     */
+    virtual ~AsyncWorker()
+    {
+        {
+            lock_t l(mutex_);
+            stop_ = true;
+        }
+        notify_.notify_all();
+        if(thread_.joinable())
+            thread_.join();
+    }
+
+    /**
+     * @brief Run a task on the helper thread.
+     * @param task  - the task
+     */
+    inline void submit(const task_t &task)
+    {
+        lock_t l(mutex_);
+        notify_.wait(l, [this]() {
+            return !busy_;
+        });
+        task_ = task;
+        busy_ = true;
+        l.unlock();
+        notify_.notify_all();
+    }
+
+    /**
+     * @brief Wait for the submitted task, afterwards its effects are visible to the caller.
+     */
+    inline void wait()
+    {
+        if(!busy_.load(std::memory_order_acquire))
+            return;
+
+        lock_t l(mutex_);
+        notify_.wait(l, [this]() {
+            return !busy_;
+        });
+    }
+
+    inline bool busy() const
+    {
+        return busy_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::thread             thread_;
+    mutex_t                 mutex_;
+    std::condition_variable notify_;
+    task_t                  task_;
+    std::atomic_bool        busy_;
+    bool                    stop_;
+
+    inline void loop()
+    {
+        lock_t l(mutex_);
+        while(true) {
+            notify_.wait(l, [this]() {
+                return busy_ || stop_;
+            });
+            if(!busy_)
+                return;
+
+            task_t task = std::move(task_);
+            task_ = nullptr;
+            l.unlock();
+            task();
+            /// release what the task holds before waiters are woken
+            task = nullptr;
+            l.lock();
+            busy_.store(false, std::memory_order_release);
+            notify_.notify_all();
+        }
+    }
+};
+}
+
+#endif // MUSE_SMC_ASYNC_WORKER_HPP
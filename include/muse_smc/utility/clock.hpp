@@ -0,0 +1,92 @@
+#ifndef MUSE_SMC_CLOCK_HPP
+#define MUSE_SMC_CLOCK_HPP
+
+#include <cslibs_time/time.hpp>
+#include <cslibs_time/duration.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+namespace muse_smc {
+/**
+ * @brief The Clock class is the time source schedulers measure processing durations with.
+ */
+class Clock
+{
+public:
+    using Ptr = std::shared_ptr<Clock>;
+
+    virtual ~Clock() = default;
+
+    /**
+     * @brief The current time of the clock.
+     */
+    virtual cslibs_time::Time now() = 0;
+};
+
+/**
+ * @brief The SteadyClock class reads a monotonic clock, which does not jump when the
+ *        system time is adjusted. Only differences of its readings are meaningful.
+ */
+class SteadyClock : public Clock
+{
+public:
+    using Ptr = std::shared_ptr<SteadyClock>;
+
+    virtual cslibs_time::Time now() override
+    {
+        const auto since_epoch = std::chrono::steady_clock::now().time_since_epoch();
+        return cslibs_time::Time(static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count()));
+    }
+};
+
+/**
+ * @brief The VirtualClock class is set from the outside, e.g. by a replay of recorded
+ *        data. Every reading advances the clock by a fixed increment, which lets
+ *        processing take a deterministic amount of time.
+ */
+class VirtualClock : public Clock
+{
+public:
+    using Ptr = std::shared_ptr<VirtualClock>;
+
+    /**
+     * @brief VirtualClock constructor.
+     * @param start     - the initial time
+     * @param increment - the amount of time every reading advances the clock
+     */
+    inline explicit VirtualClock(const cslibs_time::Time     &start     = cslibs_time::Time(),
+                                 const cslibs_time::Duration &increment = cslibs_time::Duration()) :
+        now_(start.nanoseconds()),
+        increment_(increment.nanoseconds())
+    {
+    }
+
+    virtual cslibs_time::Time now() override
+    {
+        return cslibs_time::Time(now_.fetch_add(increment_));
+    }
+
+    inline void set(const cslibs_time::Time &time)
+    {
+        now_ = time.nanoseconds();
+    }
+
+    inline void advance(const cslibs_time::Duration &duration)
+    {
+        now_ += duration.nanoseconds();
+    }
+
+    inline void setIncrement(const cslibs_time::Duration &increment)
+    {
+        increment_ = increment.nanoseconds();
+    }
+
+private:
+    std::atomic<int64_t> now_;
+    std::atomic<int64_t> increment_;
+};
+}
+
+#endif // MUSE_SMC_CLOCK_HPP
@@ -1,198 +1,189 @@
 #ifndef DOTTY_HPP
 #define DOTTY_HPP
 
+#include <muse_smc/utility/trace.hpp>
+#include <muse_smc/utility/trace_export.hpp>
+
 #include <fstream>
-#include <iostream>
 #include <sstream>
 #include <chrono>
+#include <unordered_map>
+#include <cslibs_time/time.hpp>
+
+#ifdef MUSE_SMC_USE_DOTTY
 #include <mutex>
 #include <thread>
 #include <atomic>
 #include <condition_variable>
 #include <queue>
-#include <map>
-#include <cslibs_time/time.hpp>
+#endif
 
 namespace muse_smc {
+/**
+ * @brief The Dotty class records the filter state graph into a binary Trace, flush
+ *        writes it as DOT graph. With MUSE_SMC_USE_DOTTY, statements are also written
+ *        incrementally by a worker thread, into files of at most 1000 lines.
+ *        New code should record into a Trace directly and export when needed, see
+ *        trace_export.hpp.
+ */
 class Dotty {
 public:
     using Ptr = std::shared_ptr<Dotty>;
 
     Dotty() :
         path_("/tmp/muse_filter_state_" + getTime()),
+        trace_(new Trace(1 << 16)),
+        next_prediction_is_interpolated_(false)
+#ifdef MUSE_SMC_USE_DOTTY
+        ,
         split_(0),
         lines_(0),
-        states_(0),
-        predictions_(0),
-        next_prediction_is_interpolated_(false),
         stop_(false)
+#endif
     {
-        running_ = true;
+#ifdef MUSE_SMC_USE_DOTTY
         worker_thread_ = std::thread([this]{loop();});
+#endif
     }
 
     virtual ~Dotty()
     {
-        if(running_) {
+#ifdef MUSE_SMC_USE_DOTTY
+        {
+            std::unique_lock<std::mutex> q_lock(q_mutex_);
             stop_ = true;
-            notify_log_.notify_one();
-            if(worker_thread_.joinable())
-                worker_thread_.join();
         }
+        notify_log_.notify_one();
+        if(worker_thread_.joinable())
+            worker_thread_.join();
+#endif
     }
 
-    void addState(const Time &time)
+    void addState(const cslibs_time::Time &time)
     {
-        std::string state = "state_" + std::to_string(states_);
-        std::string node  =  state +
-                " [label=\"x_" + std::to_string(states_) +
-                " at time \\n" +
-                std::to_string(time.seconds()) +
-                "\"]";
-        {
-            std::unique_lock<std::mutex> q_lock(q_mutex_);
-            q_.push(node);
-            if(states_ > 0) {
-                q_.push(last_state_ + " -> " + state);
-            }
-            last_state_ = state;
-            ++states_;
-        }
-        notify_log_.notify_one();
+        trace_->addState(time);
+        log(TraceEvent::State, time, 0, TraceEvent::None);
     }
 
-    void addUpdate(const Time &time, const std::string &name)
+    void addUpdate(const cslibs_time::Time &time, const std::string &name)
     {
-        std::string update = "update_" + name + "_" + std::to_string(updates_[name]);
-        std::string node = update +
-                " [label=\"" + name +
-                " at time \\n" +
-                std::to_string(time.seconds()) +
-                "\"]";
-        {
-            std::unique_lock<std::mutex> q_lock(q_mutex_);
-            q_.push(node);
-            if(last_state_ != "") {
-                q_.push(update + " -> " + last_state_);
-            }
-            ++updates_[name];
+        auto it = ids_.find(name);
+        if(it == ids_.end()) {
+            it = ids_.emplace(name, ids_.size()).first;
+            trace_->setName(it->second, name);
         }
-        notify_log_.notify_one();
+        trace_->addUpdate(time, it->second);
+        log(TraceEvent::Update, time, it->second, TraceEvent::None);
     }
 
-    void addPrediction(const Time &time,
+    void addPrediction(const cslibs_time::Time &time,
                        const bool interpolated = false)
     {
-        std::string prediction = "prediction_" + std::to_string(predictions_);
-        std::string node  =  prediction +
-                " [label=\"u_" + std::to_string(predictions_) +
-                " at time \\n" +
-                std::to_string(time.seconds()) +
-                "\"";
-        if(interpolated || next_prediction_is_interpolated_) {
-            node += ",color=dodgerblue3]";
-        } else {
-            node += "]";
-        }
-        {
-            std::unique_lock<std::mutex> q_lock(q_mutex_);
-            q_.push(node);
-            if(last_state_ != "") {
-                q_.push(prediction + " -> " + last_state_);
-            }
-            ++predictions_;
-        }
-        notify_log_.notify_one();
+        const std::uint8_t flags = interpolated || next_prediction_is_interpolated_ ?
+                    TraceEvent::Interpolated : TraceEvent::None;
+        trace_->addPrediction(time, 0, flags);
+        log(TraceEvent::Prediction, time, 0, flags);
         next_prediction_is_interpolated_ = interpolated;
     }
 
+    /**
+     * @brief Write the events recorded so far, may be called at any time.
+     */
+    void writeDot(std::ostream &out) const
+    {
+        trace_export::writeDot(out, trace_->dump(), trace_->getNames());
+    }
+
+    /**
+     * @brief Write the events recorded so far to the .dot file of this instance.
+     * @return the path written to
+     */
+    std::string flush() const
+    {
+        const std::string path = path_ + ".dot";
+        std::ofstream out(path);
+        writeDot(out);
+        return path;
+    }
+
+    inline Trace::Ptr getTrace() const
+    {
+        return trace_;
+    }
+
 private:
-    std::ofstream           out_;
-    std::string             path_;
-    std::size_t             split_;
-    std::size_t             lines_;
+    std::string                                  path_;
+    Trace::Ptr                                   trace_;
+    std::unordered_map<std::string, std::size_t> ids_;
+    bool                                         next_prediction_is_interpolated_;
 
+#ifdef MUSE_SMC_USE_DOTTY
     static const std::size_t MAX_LINES = 1000;
 
-    std::map<std::string, std::size_t> updates_;
-    std::size_t             states_;
-    std::size_t             predictions_;
-    std::string             last_state_;
-    bool                    next_prediction_is_interpolated_;
-
-    std::thread             worker_thread_;
-    std::mutex              q_mutex_;
-    std::queue<std::string> q_;
-    std::mutex              notify_mutex_;
-    std::condition_variable notify_log_;
+    std::ofstream               out_;
+    std::size_t                 split_;
+    std::size_t                 lines_;
+    trace_export::DotWriter     writer_;
+
+    std::thread                 worker_thread_;
+    std::mutex                  q_mutex_;
+    std::queue<std::string>     q_;
+    std::condition_variable     notify_log_;
+    bool                        stop_;
+
+    inline void log(const TraceEvent::Type   type,
+                    const cslibs_time::Time &time,
+                    const std::uint64_t      id,
+                    const std::uint8_t       flags)
+    {
+        TraceEvent e;
+        e.stamp = time.nanoseconds();
+        e.id    = id;
+        e.type  = static_cast<std::uint8_t>(type);
+        e.flags = flags;
+        {
+            std::unique_lock<std::mutex> q_lock(q_mutex_);
+            std::ostringstream statements;
+            writer_.write(statements, e, trace_->getNames());
 
-    std::atomic_bool        running_;
-    std::atomic_bool        stop_;
+            std::string line;
+            std::istringstream lines(statements.str());
+            while(std::getline(lines, line))
+                q_.push(line);
+        }
+        notify_log_.notify_one();
+    }
 
     void loop()
     {
-        auto dumpQ = [this] () {
+        reopenOutStream();
+        writeHeader();
+
+        std::unique_lock<std::mutex> q_lock(q_mutex_);
+        while(true) {
+            notify_log_.wait(q_lock, [this]() {return stop_ || !q_.empty();});
             while(!q_.empty()) {
-                std::unique_lock<std::mutex> q_lock(q_mutex_);
-                auto f = q_.front();
+                const std::string line = q_.front();
                 q_.pop();
                 q_lock.unlock();
-                out_ << f << "\n";
-                ++lines_;
-
-                if(lines_ >= 1000) {
+                out_ << line << "\n";
+                if(++lines_ >= MAX_LINES) {
                     lines_ = 0;
                     writeEnd();
                     reopenOutStream();
                     writeHeader();
                 }
+                q_lock.lock();
             }
-        };
-
-        reopenOutStream();
-        writeHeader();
-
-        std::unique_lock<std::mutex> notify_lock(notify_mutex_);
-        while(!stop_) {
-            notify_log_.wait(notify_lock);
-            dumpQ();
+            if(stop_)
+                break;
         }
-        dumpQ();
-        writeEnd();
+        q_lock.unlock();
 
+        writeEnd();
         out_.flush();
         if(out_.is_open())
             out_.close();
-
-        running_ = false;
-    }
-
-    inline void getTime(long &seconds,
-                        long &milliseconds)
-    {
-        auto now = std::chrono::time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now());
-        milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
-        seconds = milliseconds / 1000;
-        milliseconds = milliseconds % 1000;
-    }
-
-    inline std::string getTime()
-    {
-        long s, ms;
-        getTime(s, ms);
-
-        const std::string ms_off = ms >= 100 ? "" : (ms >= 10 ? "0" : "00");
-        const std::string time = std::to_string(s) + "." + ms_off + std::to_string(ms);
-        return time;
-    }
-
-    inline std::string toString(const Time &time)
-    {
-        long milli = std::floor(time.nanoseconds() / 1e6);
-        long s  = milli / 1000;
-        long ms = milli % 1000;
-        const std::string ms_off = ms >= 100 ? "" : (ms >= 10 ? "0" : "00");
-        return std::to_string(s) + "." + ms_off + std::to_string(ms);
     }
 
     inline void reopenOutStream()
@@ -213,6 +204,25 @@ private:
     {
         out_ << "}" << "\n";
     }
+#else
+    inline void log(const TraceEvent::Type,
+                    const cslibs_time::Time &,
+                    const std::uint64_t,
+                    const std::uint8_t)
+    {
+    }
+#endif
+
+    inline std::string getTime()
+    {
+        auto now = std::chrono::time_point_cast<std::chrono::milliseconds>(std::chrono::system_clock::now());
+        long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+        const long s  = milliseconds / 1000;
+        const long ms = milliseconds % 1000;
+
+        const std::string ms_off = ms >= 100 ? "" : (ms >= 10 ? "0" : "00");
+        return std::to_string(s) + "." + ms_off + std::to_string(ms);
+    }
 };
 }
 
@@ -0,0 +1,166 @@
+#ifndef MUSE_SMC_HISTOGRAM_HPP
+#define MUSE_SMC_HISTOGRAM_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace muse_smc {
+/**
+ * @brief The Histogram class records durations in nanoseconds into log-linear buckets,
+ *        every power of two is split into 8 buckets, which bounds the relative error
+ *        to 12.5%. Recording is lock-free and may be done from any thread, snapshots
+ *        can be taken concurrently.
+ */
+class Histogram
+{
+public:
+    using buckets_t = std::array<std::uint64_t, 512>;
+
+    /**
+     * @brief The Snapshot struct is a copy of the histogram at one point in time.
+     */
+    struct Snapshot {
+        buckets_t     buckets;
+        std::uint64_t count;
+        std::int64_t  sum;
+        std::int64_t  max;
+
+        inline Snapshot() :
+            count(0),
+            sum(0),
+            max(0)
+        {
+            buckets.fill(0);
+        }
+
+        /**
+         * @brief Mean duration in nanoseconds.
+         */
+        inline double mean() const
+        {
+            return count > 0 ? static_cast<double>(sum) / static_cast<double>(count) : 0.0;
+        }
+
+        /**
+         * @brief Duration in nanoseconds below which a given fraction of all recordings
+         *        lies, the center of the bucket containing it is returned.
+         * @param p     - the fraction in [0, 1]
+         */
+        inline std::int64_t percentile(const double p) const
+        {
+            if (count == 0)
+                return 0;
+
+            const std::uint64_t rank = static_cast<std::uint64_t>(p * static_cast<double>(count - 1));
+            std::uint64_t cumulative = 0;
+            for (std::size_t i = 0 ; i < buckets.size() ; ++i) {
+                cumulative += buckets[i];
+                if (cumulative > rank)
+                    return std::min(max, (lower(i) + upper(i)) / 2);
+            }
+            return max;
+        }
+    };
+
+    inline Histogram() :
+        count_(0),
+        sum_(0),
+        max_(0)
+    {
+        for (auto &b : buckets_)
+            b.store(0, std::memory_order_relaxed);
+    }
+
+    Histogram(const Histogram &other) = delete;
+    Histogram& operator = (const Histogram &other) = delete;
+
+    /**
+     * @brief Record a duration.
+     * @param nanoseconds   - the duration, negative durations are recorded as zero
+     */
+    inline void add(std::int64_t nanoseconds)
+    {
+        if (nanoseconds < 0)
+            nanoseconds = 0;
+
+        buckets_[index(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+        std::int64_t max = max_.load(std::memory_order_relaxed);
+        while (nanoseconds > max &&
+               !max_.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed));
+    }
+
+    inline Snapshot snapshot() const
+    {
+        Snapshot s;
+        for (std::size_t i = 0 ; i < buckets_.size() ; ++i)
+            s.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        s.count = count_.load(std::memory_order_relaxed);
+        s.sum   = sum_.load(std::memory_order_relaxed);
+        s.max   = max_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    /**
+     * @brief The Timer class records the time from its construction to its destruction.
+     */
+    class Timer
+    {
+    public:
+        inline explicit Timer(Histogram &histogram) :
+            histogram_(histogram),
+            start_(std::chrono::steady_clock::now())
+        {
+        }
+
+        inline ~Timer()
+        {
+            histogram_.add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count());
+        }
+
+    private:
+        Histogram                            &histogram_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    inline static std::size_t index(const std::int64_t nanoseconds)
+    {
+        const std::uint64_t v = static_cast<std::uint64_t>(nanoseconds);
+        if (v < 8)
+            return static_cast<std::size_t>(v);
+
+        const std::size_t e = 63 - static_cast<std::size_t>(__builtin_clzll(v));
+        return (e - 2) * 8 + static_cast<std::size_t>((v >> (e - 3)) & 7);
+    }
+
+    inline static std::int64_t lower(const std::size_t index)
+    {
+        if (index < 8)
+            return static_cast<std::int64_t>(index);
+
+        const std::size_t e = index / 8 + 2;
+        return static_cast<std::int64_t>((8 + index % 8) << (e - 3));
+    }
+
+    inline static std::int64_t upper(const std::size_t index)
+    {
+        if (index < 8)
+            return static_cast<std::int64_t>(index);
+
+        const std::size_t e = index / 8 + 2;
+        return lower(index) + (static_cast<std::int64_t>(1) << (e - 3)) - 1;
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, 512> buckets_;
+    std::atomic<std::uint64_t>                  count_;
+    std::atomic<std::int64_t>                   sum_;
+    std::atomic<std::int64_t>                   max_;
+};
+}
+
+#endif // MUSE_SMC_HISTOGRAM_HPP
@@ -0,0 +1,105 @@
+#ifndef MUSE_SMC_MPSC_QUEUE_HPP
+#define MUSE_SMC_MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <memory>
+
+namespace muse_smc {
+/**
+ * @brief The MPSCQueue class is an unbounded multi-producer single-consumer queue
+ *        after Vyukov. Pushing costs a single atomic exchange and never blocks, popping
+ *        is wait-free but may only be done by one thread at a time. A push which has
+ *        not completed yet is not visible to the consumer.
+ */
+template<typename T>
+class MPSCQueue
+{
+public:
+    using Ptr = std::shared_ptr<MPSCQueue>;
+
+    inline MPSCQueue() :
+        head_(new Node),
+        tail_(head_.load())
+    {
+    }
+
+    virtual ~MPSCQueue()
+    {
+        clear();
+        delete tail_;
+    }
+
+    MPSCQueue(const MPSCQueue &other) = delete;
+    MPSCQueue& operator = (const MPSCQueue &other) = delete;
+
+    /**
+     * @brief Enqueue an element, may be called from any thread.
+     * @param t     - the element
+     */
+    inline void push(const T &t)
+    {
+        Node *node = new Node(t);
+        Node *prev = head_.exchange(node);
+        prev->next.store(node);
+    }
+
+    /**
+     * @brief Dequeue the oldest element, consumer only.
+     * @param t     - the element
+     * @return false if the queue is empty
+     */
+    inline bool pop(T &t)
+    {
+        Node *tail = tail_;
+        Node *next = tail->next.load();
+        if(next == nullptr)
+            return false;
+
+        /// the next node becomes the new stub
+        t = std::move(next->value);
+        next->value = T();
+        tail_ = next;
+        delete tail;
+        return true;
+    }
+
+    /**
+     * @brief True if no completed push is pending, consumer only.
+     */
+    inline bool empty() const
+    {
+        return tail_->next.load() == nullptr;
+    }
+
+    /**
+     * @brief Drop all pending elements, consumer only.
+     */
+    inline void clear()
+    {
+        T t;
+        while(pop(t));
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next;
+        T                  value;
+
+        inline Node() :
+            next(nullptr)
+        {
+        }
+
+        inline explicit Node(const T &value) :
+            next(nullptr),
+            value(value)
+        {
+        }
+    };
+
+    std::atomic<Node*> head_;   /// producers
+    Node              *tail_;   /// consumer
+};
+}
+
+#endif // MUSE_SMC_MPSC_QUEUE_HPP
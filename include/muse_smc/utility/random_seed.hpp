@@ -0,0 +1,49 @@
+#ifndef MUSE_SMC_RANDOM_SEED_HPP
+#define MUSE_SMC_RANDOM_SEED_HPP
+
+#include <cstdint>
+#include <random>
+
+namespace muse_smc {
+namespace random_seed {
+/**
+ * @brief SplitMix64 step, advances the state and returns the next output.
+ *        Consecutive outputs are well distributed even for adjacent states,
+ *        which makes it suitable to derive seeds of independent streams.
+ * @param state     - the generator state
+ * @return the next output
+ */
+inline std::uint64_t splitmix64(std::uint64_t &state)
+{
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Derive the seed of stream index from a base seed.
+ * @param seed      - the base seed
+ * @param index     - the stream index
+ * @return the derived seed
+ */
+inline std::uint64_t derive(const std::uint64_t seed,
+                            const std::uint64_t index)
+{
+    std::uint64_t state = seed;
+    state = splitmix64(state) ^ index;
+    return splitmix64(state);
+}
+
+/**
+ * @brief A non-deterministic seed.
+ */
+inline std::uint64_t random()
+{
+    std::random_device rd;
+    return (static_cast<std::uint64_t>(rd()) << 32) ^ static_cast<std::uint64_t>(rd());
+}
+}
+}
+
+#endif // MUSE_SMC_RANDOM_SEED_HPP
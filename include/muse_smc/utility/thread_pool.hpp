@@ -0,0 +1,170 @@
+#ifndef MUSE_SMC_THREAD_POOL_HPP
+#define MUSE_SMC_THREAD_POOL_HPP
+
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace muse_smc {
+/**
+ * @brief The ThreadPool class executes batches of indexed tasks on a fixed set of
+ *        worker threads. The calling thread takes part in the execution, so a pool
+ *        of size one runs everything on the caller.
+ */
+class ThreadPool
+{
+public:
+    using Ptr     = std::shared_ptr<ThreadPool>;
+    using task_t  = std::function<void(const std::size_t)>;
+    using mutex_t = std::mutex;
+    using lock_t  = std::unique_lock<mutex_t>;
+
+    /**
+     * @brief ThreadPool constructor.
+     * @param threads   - amount of threads including the calling thread
+     */
+    inline explicit ThreadPool(const std::size_t threads = std::thread::hardware_concurrency()) :
+        task_(nullptr),
+        count_(0),
+        next_(0),
+        done_(0),
+        active_(0),
+        generation_(0),
+        stop_(false)
+    {
+        for(std::size_t i = 1 ; i < threads ; ++i)
+            workers_.emplace_back([this](){loop();});
+    }
+
+    virtual ~ThreadPool()
+    {
+        {
+            lock_t l(mutex_);
+            stop_ = true;
+        }
+        notify_work_.notify_all();
+        for(auto &w : workers_) {
+            if(w.joinable())
+                w.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool &other) = delete;
+    ThreadPool& operator = (const ThreadPool &other) = delete;
+
+    /**
+     * @brief Amount of threads working on a batch, including the calling thread.
+     */
+    inline std::size_t size() const
+    {
+        return workers_.size() + 1;
+    }
+
+    /**
+     * @brief Execute task(i) for i in [0, count) and block until all are done. If tasks
+     *        throw, the remaining tasks are still executed and the first exception is
+     *        rethrown on the calling thread.
+     * @param count     - amount of tasks
+     * @param task      - the task function, called with the task index
+     */
+    inline void parallelFor(const std::size_t count,
+                            const task_t     &task)
+    {
+        if(count == 0)
+            return;
+
+        lock_t batch_lock(batch_mutex_);
+        {
+            lock_t l(mutex_);
+            notify_done_.wait(l, [this]() {return active_ == 0;});
+            task_  = &task;
+            count_ = count;
+            next_  = 0;
+            done_  = 0;
+            error_ = nullptr;
+            ++generation_;
+        }
+        notify_work_.notify_all();
+
+        run(task, count);
+
+        std::exception_ptr error;
+        {
+            lock_t l(mutex_);
+            notify_done_.wait(l, [this]() {return done_ == count_ && active_ == 0;});
+            task_ = nullptr;
+            std::swap(error, error_);
+        }
+        if(error)
+            std::rethrow_exception(error);
+    }
+
+private:
+    std::vector<std::thread>    workers_;
+    mutex_t                     batch_mutex_;
+    mutex_t                     mutex_;
+    std::condition_variable     notify_work_;
+    std::condition_variable     notify_done_;
+
+    const task_t               *task_;
+    std::size_t                 count_;
+    std::atomic<std::size_t>    next_;
+    std::atomic<std::size_t>    done_;
+    std::size_t                 active_;
+    std::size_t                 generation_;
+    bool                        stop_;
+    std::exception_ptr          error_;     /// the first exception of the current batch
+
+    inline void run(const task_t     &task,
+                    const std::size_t count)
+    {
+        for(std::size_t i = next_++ ; i < count ; i = next_++) {
+            /// a failed task counts as done, otherwise the caller would wait forever
+            try {
+                task(i);
+            } catch(...) {
+                lock_t l(mutex_);
+                if(!error_)
+                    error_ = std::current_exception();
+            }
+            if(++done_ == count) {
+                lock_t l(mutex_);
+                notify_done_.notify_all();
+            }
+        }
+    }
+
+    inline void loop()
+    {
+        std::size_t generation = 0;
+        lock_t l(mutex_);
+        while(true) {
+            notify_work_.wait(l, [this, &generation]() {return stop_ || generation != generation_;});
+            if(stop_)
+                break;
+
+            generation = generation_;
+            if(task_ == nullptr)
+                continue;
+
+            const task_t     *task  = task_;
+            const std::size_t count = count_;
+            ++active_;
+            l.unlock();
+
+            run(*task, count);
+
+            l.lock();
+            --active_;
+            notify_done_.notify_all();
+        }
+    }
+};
+}
+
+#endif // MUSE_SMC_THREAD_POOL_HPP
@@ -0,0 +1,292 @@
+#ifndef MUSE_SMC_TRACE_HPP
+#define MUSE_SMC_TRACE_HPP
+
+#include <cslibs_time/time.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace muse_smc {
+/**
+ * @brief The TraceEvent struct is a single decoded trace record.
+ */
+struct TraceEvent {
+    enum Type {State = 0, Update = 1, Prediction = 2, Resampling = 3};
+    enum Flags {None = 0, Interpolated = 1, Extrapolated = 2};
+
+    std::int64_t  time     = 0;     /// steady clock time the event was recorded at in ns
+    std::int64_t  stamp    = 0;     /// filter time the event refers to in ns
+    std::int64_t  duration = 0;     /// duration of the event in ns, ending at time
+    std::uint64_t id       = 0;     /// e.g. the update model id
+    std::uint32_t thread   = 0;     /// index of the recording thread
+    std::uint8_t  type     = State;
+    std::uint8_t  flags    = None;
+
+    inline bool operator < (const TraceEvent &other) const
+    {
+        return time < other.time;
+    }
+};
+
+/**
+ * @brief The TraceRing class is a fixed size ring of binary trace records written by a
+ *        single thread. Old records are overwritten. Every slot is guarded by a sequence
+ *        number, readers copy concurrently and discard records overwritten meanwhile.
+ */
+class TraceRing
+{
+public:
+    /**
+     * @brief TraceRing constructor.
+     * @param capacity  - the amount of records, rounded up to a power of two
+     * @param thread    - index of the thread owning the ring
+     */
+    inline TraceRing(const std::size_t   capacity,
+                     const std::uint32_t thread) :
+        slots_(roundUp(capacity)),
+        mask_(slots_.size() - 1),
+        thread_(thread),
+        head_(0)
+    {
+        for (Slot &s : slots_) {
+            s.sequence.store(0, std::memory_order_relaxed);
+            for (auto &w : s.words)
+                w.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    TraceRing(const TraceRing &other) = delete;
+    TraceRing& operator = (const TraceRing &other) = delete;
+
+    /**
+     * @brief Append a record, only the owning thread may call this.
+     */
+    inline void push(const std::int64_t  time,
+                     const std::int64_t  stamp,
+                     const std::int64_t  duration,
+                     const std::uint64_t id,
+                     const std::uint8_t  type,
+                     const std::uint8_t  flags)
+    {
+        const std::uint64_t n = head_.load(std::memory_order_relaxed);
+        Slot &s = slots_[n & mask_];
+        s.sequence.store(2 * n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        s.words[0].store(static_cast<std::uint64_t>(time),     std::memory_order_relaxed);
+        s.words[1].store(static_cast<std::uint64_t>(stamp),    std::memory_order_relaxed);
+        s.words[2].store(static_cast<std::uint64_t>(duration), std::memory_order_relaxed);
+        s.words[3].store(id, std::memory_order_relaxed);
+        s.words[4].store(static_cast<std::uint64_t>(type) | (static_cast<std::uint64_t>(flags) << 8),
+                         std::memory_order_relaxed);
+        s.sequence.store(2 * n + 2, std::memory_order_release);
+        head_.store(n + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy the records currently held, oldest first. May be called from any thread.
+     * @param events    - the records are appended here
+     */
+    inline void read(std::vector<TraceEvent> &events) const
+    {
+        const std::uint64_t head  = head_.load(std::memory_order_acquire);
+        const std::uint64_t begin = head > slots_.size() ? head - slots_.size() : 0;
+        for (std::uint64_t n = begin ; n < head ; ++n) {
+            const Slot &s = slots_[n & mask_];
+            const std::uint64_t before = s.sequence.load(std::memory_order_acquire);
+            std::array<std::uint64_t, 5> words;
+            for (std::size_t i = 0 ; i < words.size() ; ++i)
+                words[i] = s.words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            const std::uint64_t after = s.sequence.load(std::memory_order_relaxed);
+            if (before != 2 * n + 2 || after != before)
+                continue;
+
+            TraceEvent e;
+            e.time     = static_cast<std::int64_t>(words[0]);
+            e.stamp    = static_cast<std::int64_t>(words[1]);
+            e.duration = static_cast<std::int64_t>(words[2]);
+            e.id       = words[3];
+            e.thread   = thread_;
+            e.type     = static_cast<std::uint8_t>(words[4] & 0xff);
+            e.flags    = static_cast<std::uint8_t>((words[4] >> 8) & 0xff);
+            events.emplace_back(e);
+        }
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t>                sequence;
+        std::array<std::atomic<std::uint64_t>, 5> words;
+    };
+
+    std::vector<Slot>          slots_;
+    std::size_t                mask_;
+    std::uint32_t              thread_;
+    std::atomic<std::uint64_t> head_;
+
+    inline static std::size_t roundUp(const std::size_t capacity)
+    {
+        std::size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        return size;
+    }
+};
+
+/**
+ * @brief The Trace class records filter events into one TraceRing per thread, so
+ *        recording takes no locks and allocates nothing after the first event of a
+ *        thread. It is cheap enough to stay enabled, the rings keep the most recent
+ *        events, which can be dumped at any time, e.g. when an anomaly is detected.
+ *        See trace_export.hpp for DOT and Chrome trace output.
+ */
+class Trace
+{
+public:
+    using Ptr      = std::shared_ptr<Trace>;
+    using events_t = std::vector<TraceEvent>;
+    using names_t  = std::map<std::uint64_t, std::string>;
+
+    /**
+     * @brief Trace constructor.
+     * @param capacity  - records kept per thread, rounded up to a power of two
+     */
+    inline explicit Trace(const std::size_t capacity = 4096) :
+        capacity_(capacity),
+        instance_(nextInstance())
+    {
+    }
+
+    Trace(const Trace &other) = delete;
+    Trace& operator = (const Trace &other) = delete;
+
+    inline void addState(const cslibs_time::Time &stamp)
+    {
+        record(TraceEvent::State, stamp, 0, 0);
+    }
+
+    inline void addUpdate(const cslibs_time::Time &stamp,
+                          const std::size_t        id,
+                          const std::int64_t       duration = 0)
+    {
+        record(TraceEvent::Update, stamp, id, duration);
+    }
+
+    inline void addPrediction(const cslibs_time::Time &stamp,
+                              const std::int64_t       duration = 0,
+                              const std::uint8_t       flags    = TraceEvent::None)
+    {
+        record(TraceEvent::Prediction, stamp, 0, duration, flags);
+    }
+
+    inline void addResampling(const cslibs_time::Time &stamp,
+                              const std::int64_t       duration = 0)
+    {
+        record(TraceEvent::Resampling, stamp, 0, duration);
+    }
+
+    /**
+     * @brief Record an event on the ring of the calling thread.
+     * @param type      - the event type
+     * @param stamp     - the filter time the event refers to
+     * @param id        - e.g. the update model id
+     * @param duration  - duration in ns, the event is assumed to end now
+     * @param flags     - see TraceEvent::Flags
+     */
+    inline void record(const TraceEvent::Type   type,
+                       const cslibs_time::Time &stamp,
+                       const std::uint64_t      id,
+                       const std::int64_t       duration,
+                       const std::uint8_t       flags = TraceEvent::None)
+    {
+        const std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        ring().push(now, stamp.nanoseconds(), duration, id, static_cast<std::uint8_t>(type), flags);
+    }
+
+    /**
+     * @brief Name an id for export, e.g. the name of an update model.
+     */
+    inline void setName(const std::uint64_t  id,
+                        const std::string   &name)
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+        names_[id] = name;
+    }
+
+    inline names_t getNames() const
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+        return names_;
+    }
+
+    /**
+     * @brief Copy the events of all threads, ordered by the time they were recorded.
+     *        May be called from any thread while recording continues.
+     */
+    inline events_t dump() const
+    {
+        events_t events;
+        {
+            std::unique_lock<std::mutex> l(mutex_);
+            for (const auto &r : rings_)
+                r->read(events);
+        }
+        std::stable_sort(events.begin(), events.end());
+        return events;
+    }
+
+private:
+    using ring_t  = std::unique_ptr<TraceRing>;
+
+    std::size_t                     capacity_;
+    std::uint64_t                   instance_;
+    mutable std::mutex              mutex_;
+    std::vector<ring_t>             rings_;
+    std::map<std::thread::id, std::size_t> ring_index_;
+    names_t                         names_;
+
+    /**
+     * @brief Rings are looked up once per thread and trace, instances are numbered
+     *        uniquely so a cached ring never belongs to a destroyed trace.
+     */
+    inline TraceRing & ring()
+    {
+        struct Cache {
+            std::uint64_t instance = 0;
+            TraceRing    *ring     = nullptr;
+        };
+        static thread_local Cache cache;
+        if (cache.instance == instance_)
+            return *cache.ring;
+
+        std::unique_lock<std::mutex> l(mutex_);
+        const std::thread::id thread = std::this_thread::get_id();
+        auto it = ring_index_.find(thread);
+        if (it == ring_index_.end()) {
+            it = ring_index_.emplace(thread, rings_.size()).first;
+            rings_.emplace_back(ring_t(new TraceRing(capacity_, static_cast<std::uint32_t>(rings_.size()))));
+        }
+        cache.instance = instance_;
+        cache.ring     = rings_[it->second].get();
+        return *cache.ring;
+    }
+
+    inline static std::uint64_t nextInstance()
+    {
+        static std::atomic<std::uint64_t> instances(0);
+        return ++instances;
+    }
+};
+}
+
+#endif // MUSE_SMC_TRACE_HPP
@@ -0,0 +1,219 @@
+#ifndef MUSE_SMC_TRACE_EXPORT_HPP
+#define MUSE_SMC_TRACE_EXPORT_HPP
+
+#include <muse_smc/utility/trace.hpp>
+
+#include <cstdio>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace muse_smc {
+namespace trace_export {
+inline std::string name(const Trace::names_t &names,
+                        const std::uint64_t   id)
+{
+    const auto it = names.find(id);
+    return it != names.end() ? it->second : "model_" + std::to_string(id);
+}
+
+inline std::string seconds(const std::int64_t nanoseconds)
+{
+    std::ostringstream s;
+    s << std::fixed << std::setprecision(3) << static_cast<double>(nanoseconds) * 1e-9;
+    return s.str();
+}
+
+/**
+ * @brief Escape a string for a quoted DOT label.
+ */
+inline std::string escapeDot(const std::string &s)
+{
+    std::string escaped;
+    escaped.reserve(s.size());
+    for (const char c : s) {
+        switch (c) {
+        case '"':  escaped += "\\\""; break;
+        case '\\': escaped += "\\\\"; break;
+        case '\n': escaped += "\\n";  break;
+        default:   escaped += c;      break;
+        }
+    }
+    return escaped;
+}
+
+/**
+ * @brief Escape a string for a JSON string literal.
+ */
+inline std::string escapeJson(const std::string &s)
+{
+    std::string escaped;
+    escaped.reserve(s.size());
+    for (const char c : s) {
+        switch (c) {
+        case '"':  escaped += "\\\""; break;
+        case '\\': escaped += "\\\\"; break;
+        case '\n': escaped += "\\n";  break;
+        case '\r': escaped += "\\r";  break;
+        case '\t': escaped += "\\t";  break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char code[7];
+                std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned int>(c));
+                escaped += code;
+            } else {
+                escaped += c;
+            }
+            break;
+        }
+    }
+    return escaped;
+}
+
+/**
+ * @brief Label suffix of prediction flags, empty if there are none.
+ */
+inline std::string flagLabel(const std::uint8_t flags)
+{
+    switch (flags) {
+    case TraceEvent::None:                                     return "";
+    case TraceEvent::Interpolated:                             return " (interpolated)";
+    case TraceEvent::Extrapolated:                             return " (extrapolated)";
+    case TraceEvent::Interpolated | TraceEvent::Extrapolated:  return " (interpolated, extrapolated)";
+    default:                                                   return " (flags " + std::to_string(flags) + ")";
+    }
+}
+
+/**
+ * @brief The DotWriter class writes events as DOT statements one by one, states form a
+ *        chain, updates, predictions and resamplings point to the state they were
+ *        applied to. Interpolated predictions are blue, extrapolated ones orange.
+ */
+class DotWriter
+{
+public:
+    inline void write(std::ostream            &out,
+                      const TraceEvent        &e,
+                      const Trace::names_t    &names)
+    {
+        switch (e.type) {
+        case TraceEvent::State: {
+            const std::string state = "state_" + std::to_string(states_);
+            out << state << " [label=\"x_" << states_ << " at time \\n" << seconds(e.stamp) << "\"]" << "\n";
+            if (!last_state_.empty())
+                out << last_state_ << " -> " << state << "\n";
+            last_state_ = state;
+            ++states_;
+        }   break;
+        case TraceEvent::Update: {
+            /// names only appear in labels, so node ids stay valid for any name
+            const std::string update = "update_" + std::to_string(e.id) + "_" + std::to_string(updates_[e.id]++);
+            out << update << " [label=\"" << escapeDot(name(names, e.id)) << " at time \\n" << seconds(e.stamp) << "\"]" << "\n";
+            if (!last_state_.empty())
+                out << update << " -> " << last_state_ << "\n";
+        }   break;
+        case TraceEvent::Prediction: {
+            const std::string prediction = "prediction_" + std::to_string(predictions_);
+            out << prediction << " [label=\"u_" << predictions_ << flagLabel(e.flags) << " at time \\n" << seconds(e.stamp) << "\"";
+            if (e.flags & TraceEvent::Extrapolated)
+                out << ",color=darkorange2";
+            else if (e.flags & TraceEvent::Interpolated)
+                out << ",color=dodgerblue3";
+            out << "]" << "\n";
+            if (!last_state_.empty())
+                out << prediction << " -> " << last_state_ << "\n";
+            ++predictions_;
+        }   break;
+        case TraceEvent::Resampling: {
+            const std::string resampling = "resampling_" + std::to_string(resamplings_);
+            out << resampling << " [label=\"resampling at time \\n" << seconds(e.stamp) << "\",shape=box]" << "\n";
+            if (!last_state_.empty())
+                out << resampling << " -> " << last_state_ << "\n";
+            ++resamplings_;
+        }   break;
+        default:
+            break;
+        }
+    }
+
+private:
+    std::map<std::uint64_t, std::size_t> updates_;
+    std::size_t states_      = 0;
+    std::size_t predictions_ = 0;
+    std::size_t resamplings_ = 0;
+    std::string last_state_;
+};
+
+/**
+ * @brief Write the events as DOT graph, see DotWriter.
+ * @param out       - the output stream
+ * @param events    - the events, e.g. from Trace::dump
+ * @param names     - names of the update model ids
+ */
+inline void writeDot(std::ostream            &out,
+                     const Trace::events_t   &events,
+                     const Trace::names_t    &names)
+{
+    DotWriter writer;
+    out << "digraph states {" << "\n";
+    for (const TraceEvent &e : events)
+        writer.write(out, e, names);
+    out << "}" << "\n";
+}
+
+/**
+ * @brief Write the events in the Chrome trace event format, which can be opened with
+ *        chrome://tracing or Perfetto. Events with a duration become slices on the
+ *        track of their thread, the others instant events.
+ * @param out       - the output stream
+ * @param events    - the events, e.g. from Trace::dump
+ * @param names     - names of the update model ids
+ */
+inline void writeChromeTrace(std::ostream            &out,
+                             const Trace::events_t   &events,
+                             const Trace::names_t    &names)
+{
+    const std::int64_t origin = events.empty() ? 0 : events.front().time - events.front().duration;
+    auto microseconds = [](const std::int64_t nanoseconds) {
+        std::ostringstream s;
+        s << std::fixed << std::setprecision(3) << static_cast<double>(nanoseconds) * 1e-3;
+        return s.str();
+    };
+
+    out << "{\"traceEvents\":[";
+    for (std::size_t i = 0 ; i < events.size() ; ++i) {
+        const TraceEvent &e = events[i];
+        std::string label;
+        std::string category;
+        switch (e.type) {
+        case TraceEvent::State:      label = "state";      category = "state";      break;
+        case TraceEvent::Update:     label = name(names, e.id); category = "update"; break;
+        case TraceEvent::Prediction: label = "prediction" + flagLabel(e.flags); category = "prediction"; break;
+        case TraceEvent::Resampling: label = "resampling"; category = "resampling"; break;
+        default:                     label = "unknown";    category = "unknown";    break;
+        }
+
+        out << (i > 0 ? ",\n" : "\n")
+            << "{\"name\":\"" << escapeJson(label) << "\",\"cat\":\"" << category << "\"";
+        /// reserved colour names of the trace viewer
+        if (e.flags & TraceEvent::Extrapolated)
+            out << ",\"cname\":\"terrible\"";
+        else if (e.flags & TraceEvent::Interpolated)
+            out << ",\"cname\":\"yellow\"";
+        if (e.duration > 0)
+            out << ",\"ph\":\"X\",\"ts\":" << microseconds(e.time - e.duration - origin)
+                << ",\"dur\":" << microseconds(e.duration);
+        else
+            out << ",\"ph\":\"i\",\"s\":\"t\",\"ts\":" << microseconds(e.time - origin);
+        out << ",\"pid\":0,\"tid\":" << e.thread
+            << ",\"args\":{\"stamp\":" << seconds(e.stamp) << ",\"id\":" << e.id
+            << ",\"flags\":" << static_cast<unsigned int>(e.flags) << "}}";
+    }
+    out << "\n]}" << "\n";
+}
+}
+}
+
+#endif // MUSE_SMC_TRACE_EXPORT_HPP
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/resampling/impl/alias.hpp>
+
+#include "reference/density.hpp"
+#include "reference/state_space_description.hpp"
+
+#include <random>
+#include <vector>
+
+namespace {
+using description_t = muse_smc::reference::StateSpaceDescription<2>;
+using sample_t      = muse_smc::reference::Sample<2>;
+using sample_set_t  = muse_smc::SampleSet<description_t>;
+using storage_t     = sample_set_t::sample_vector_t;
+using alias_t       = muse_smc::impl::Alias<description_t>;
+
+inline storage_t create(const std::vector<double> &weights)
+{
+    storage_t samples(0, weights.size());
+    for (std::size_t i = 0 ; i < weights.size() ; ++i) {
+        sample_t sample;
+        sample.state.position(0) = static_cast<double>(i);
+        sample.weight            = weights[i];
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+/**
+ * @brief The probability of every index, obtained by drawing on an even grid of
+ *        uniform numbers, which resolves each column into 'resolution' slots.
+ */
+inline std::vector<double> probabilities(const muse_smc::impl::AliasTable &table,
+                                         const std::size_t                 resolution)
+{
+    const std::size_t   draws = table.size() * resolution;
+    std::vector<double> p(table.size(), 0.0);
+    for (std::size_t k = 0 ; k < draws ; ++k)
+        p[table.draw((static_cast<double>(k) + 0.5) / static_cast<double>(draws))] += 1.0 / static_cast<double>(draws);
+    return p;
+}
+}
+
+TEST(Alias, tableMatchesWeights)
+{
+    std::mt19937_64 engine(42);
+    std::uniform_real_distribution<double> w(0.0, 1.0);
+    std::vector<double> weights(257);
+    for (double &weight : weights)
+        weight = w(engine);
+    /// a dominant and a vanishing weight
+    weights[3] = 50.0;
+    weights[7] = 0.0;
+
+    muse_smc::impl::AliasTable table;
+    table.build(create(weights));
+    ASSERT_EQ(weights.size(), table.size());
+
+    const std::size_t         resolution = 100000;
+    const std::vector<double> p = probabilities(table, resolution);
+    double sum = 0.0;
+    for (const double weight : weights)
+        sum += weight;
+    for (std::size_t i = 0 ; i < weights.size() ; ++i)
+        /// every column holding the index may be off by one slot
+        EXPECT_NEAR(weights[i] / sum, p[i], 1.0 / static_cast<double>(resolution)) << i;
+    EXPECT_EQ(0.0, p[7]);
+}
+
+TEST(Alias, uniformWeights)
+{
+    muse_smc::impl::AliasTable table;
+    table.build(create(std::vector<double>(16, 0.25)));
+    for (std::size_t i = 0 ; i < 16 ; ++i)
+        EXPECT_EQ(i, table.draw((static_cast<double>(i) + 0.5) / 16.0));
+    /// the upper bound stays inside the table
+    EXPECT_EQ(15u, table.draw(1.0));
+}
+
+TEST(Alias, singleSample)
+{
+    muse_smc::impl::AliasTable table;
+    table.build(create({3.0}));
+    EXPECT_EQ(0u, table.draw(0.0));
+    EXPECT_EQ(0u, table.draw(0.999));
+}
+
+TEST(Alias, resampleSampleSet)
+{
+    const std::size_t sample_size = 1000;
+    sample_set_t sample_set("world", cslibs_time::Time(), sample_size / 2, sample_size * 2,
+                            std::make_shared<muse_smc::reference::Grid<2>>(0.5), true);
+    sample_set.setRandomSeed(42);
+    {
+        auto insertion = sample_set.getInsertion();
+        sample_t sample;
+        for (std::size_t i = 0 ; i < sample_size ; ++i) {
+            sample.state.position = Eigen::Vector2d(static_cast<double>(i), 0.0);
+            /// only every tenth sample carries weight
+            sample.weight         = i % 10 == 0 ? 1.0 : 0.0;
+            insertion.insert(sample);
+        }
+    }
+
+    alias_t::apply(sample_set);
+    ASSERT_EQ(sample_size, sample_set.getSampleSize());
+    const storage_t &samples = sample_set.getSamples();
+    for (std::size_t i = 0 ; i < samples.size() ; ++i)
+        EXPECT_EQ(0, static_cast<int>(samples.state(i).position(0)) % 10);
+
+    /// the amount to draw is limited to the sample size bounds
+    alias_t::apply(sample_set, sample_size * 10);
+    EXPECT_EQ(sample_size * 2, sample_set.getSampleSize());
+    alias_t::apply(sample_set, 1);
+    EXPECT_EQ(sample_size / 2, sample_set.getSampleSize());
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
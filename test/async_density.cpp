@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/samples/sample_set.hpp>
+
+#include "reference/state_space_description.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace {
+using description_t = muse_smc::reference::StateSpaceDescription<2>;
+using sample_t      = muse_smc::reference::Sample<2>;
+using sample_set_t  = muse_smc::SampleSet<description_t>;
+
+const std::size_t sample_size = 10000;
+
+/**
+ * @brief Records where and from which memory samples are inserted, the insertion
+ *        blocks until it is released.
+ */
+class BlockingDensity : public muse_smc::SampleDensity<sample_t>
+{
+public:
+    using Ptr = std::shared_ptr<BlockingDensity>;
+
+    std::thread::id  thread;
+    const sample_t  *first    = nullptr;
+    std::size_t      inserted = 0;
+    double           x_sum    = 0.0;
+
+    virtual void clear() override
+    {
+        first    = nullptr;
+        inserted = 0;
+        x_sum    = 0.0;
+    }
+
+    virtual void insert(const sample_t &sample) override
+    {
+        insertRange(&sample, &sample + 1);
+    }
+
+    virtual void insertRange(const sample_t *begin,
+                             const sample_t *end) override
+    {
+        {
+            std::unique_lock<std::mutex> l(mutex_);
+            released_.wait(l, [this]() { return open_; });
+        }
+        thread = std::this_thread::get_id();
+        if (!first)
+            first = begin;
+        for (const sample_t *s = begin ; s != end ; ++s) {
+            ++inserted;
+            x_sum += s->state.position(0);
+        }
+    }
+
+    virtual void estimate() override
+    {
+    }
+
+    inline void close()
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+        open_ = false;
+    }
+
+    inline void open()
+    {
+        {
+            std::unique_lock<std::mutex> l(mutex_);
+            open_ = true;
+        }
+        released_.notify_all();
+    }
+
+private:
+    std::mutex              mutex_;
+    std::condition_variable released_;
+    bool                    open_ = true;
+};
+
+class AsyncDensity : public ::testing::Test
+{
+protected:
+    BlockingDensity::Ptr          density;
+    std::shared_ptr<sample_set_t> sample_set;
+
+    virtual void SetUp() override
+    {
+        density.reset(new BlockingDensity);
+        sample_set.reset(new sample_set_t("world", cslibs_time::Time(), sample_size, density));
+        sample_set->setAsynchronousDensity(true);
+    }
+
+    inline void fill()
+    {
+        auto insertion = sample_set->getInsertion();
+        for (std::size_t i = 0 ; i < sample_size ; ++i) {
+            sample_t sample;
+            sample.state.position(0) = static_cast<double>(i);
+            insertion.insert(sample);
+        }
+    }
+};
+}
+
+TEST_F(AsyncDensity, helperSharesTheInsertedSamples)
+{
+    fill();
+    const sample_t *samples = &sample_set->getSamples()[0];
+    sample_set->getDensity();
+
+    /// inserted on the helper thread, directly from the buffer the set keeps
+    EXPECT_NE(std::this_thread::get_id(), density->thread);
+    EXPECT_EQ(samples, density->first);
+    EXPECT_EQ(sample_size, density->inserted);
+
+    /// the helper released the buffer, writing does not copy
+    sample_set->getStateIterator();
+    EXPECT_EQ(samples, &sample_set->getSamples()[0]);
+}
+
+TEST_F(AsyncDensity, writingWhileTheHelperRunsCopies)
+{
+    density->close();
+    fill();
+    const sample_t *samples = &sample_set->getSamples()[0];
+
+    /// the helper still holds the buffer, the samples are moved to another one
+    {
+        auto states = sample_set->getStateIterator();
+        for (auto &state : states)
+            state.position(0) = -1.0;
+    }
+    EXPECT_NE(samples, &sample_set->getSamples()[0]);
+
+    /// the helper sees the inserted samples only
+    density->open();
+    sample_set->getDensity();
+    EXPECT_EQ(samples, density->first);
+    EXPECT_EQ(sample_size, density->inserted);
+    EXPECT_DOUBLE_EQ(0.5 * static_cast<double>(sample_size * (sample_size - 1)), density->x_sum);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
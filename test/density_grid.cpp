@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/samples/sample_density_grid.hpp>
+
+#include <vector>
+
+namespace {
+struct State
+{
+    double x = 0.0;
+    double y = 0.0;
+};
+
+struct Sample
+{
+    using state_t     = State;
+    using allocator_t = std::allocator<Sample>;
+
+    state_t state;
+    double  weight = 1.0;
+};
+
+struct Vectorize
+{
+    inline Eigen::Vector2d operator()(const State &state) const
+    {
+        return Eigen::Vector2d(state.x, state.y);
+    }
+};
+
+using density_t = muse_smc::SampleDensityGrid<Sample, 2, Vectorize>;
+
+inline Sample sample(const double x,
+                     const double y,
+                     const double weight)
+{
+    Sample s;
+    s.state.x = x;
+    s.state.y = y;
+    s.weight  = weight;
+    return s;
+}
+
+/**
+ * @brief Three components in cells of size 1: (0,0) and (1,1) touch diagonally,
+ *        (5,5) and (5,6) are adjacent and (10,0) is isolated.
+ */
+inline std::vector<Sample> samples()
+{
+    std::vector<Sample> samples;
+    samples.emplace_back(sample(0.5, 0.5, 1.0));
+    samples.emplace_back(sample(1.5, 1.5, 3.0));
+    samples.emplace_back(sample(5.5, 5.2, 2.0));
+    samples.emplace_back(sample(5.5, 6.2, 2.0));
+    samples.emplace_back(sample(10.5, 0.5, 1.0));
+    samples.emplace_back(sample(10.7, 0.5, 1.0));
+    return samples;
+}
+
+inline std::size_t cluster(const density_t &density,
+                           const double     x,
+                           const double     y)
+{
+    State state;
+    state.x = x;
+    state.y = y;
+    std::size_t c = 0;
+    EXPECT_TRUE(density.getCluster(state, c));
+    return c;
+}
+
+void check(const density_t &density)
+{
+    ASSERT_EQ(3u, density.getClusters().size());
+    EXPECT_EQ(5u, density.histogramSize());
+
+    const std::size_t diagonal = cluster(density, 0.1, 0.1);
+    const std::size_t adjacent = cluster(density, 5.9, 5.9);
+    const std::size_t isolated = cluster(density, 10.0, 0.9);
+    EXPECT_EQ(diagonal, cluster(density, 1.9, 1.9));
+    EXPECT_EQ(adjacent, cluster(density, 5.1, 6.9));
+    EXPECT_NE(diagonal, adjacent);
+    EXPECT_NE(diagonal, isolated);
+    EXPECT_NE(adjacent, isolated);
+
+    State empty;
+    empty.x = 3.5;
+    empty.y = 3.5;
+    std::size_t c = 0;
+    EXPECT_FALSE(density.getCluster(empty, c));
+
+    const density_t::Cluster &d = density.getClusters()[diagonal];
+    EXPECT_EQ(2u, d.samples);
+    EXPECT_EQ(2u, d.cells);
+    EXPECT_DOUBLE_EQ(4.0, d.weight);
+    EXPECT_NEAR(1.25, d.mean(0), 1e-12);
+    EXPECT_NEAR(1.25, d.mean(1), 1e-12);
+    /// weighted variance of 0.5 and 1.5 with weights 1 and 3
+    EXPECT_NEAR(0.1875, d.covariance(0, 0), 1e-12);
+    EXPECT_NEAR(0.1875, d.covariance(0, 1), 1e-12);
+
+    const density_t::Cluster &a = density.getClusters()[adjacent];
+    EXPECT_EQ(2u, a.samples);
+    EXPECT_EQ(2u, a.cells);
+    EXPECT_DOUBLE_EQ(4.0, a.weight);
+    EXPECT_NEAR(5.5, a.mean(0), 1e-12);
+    EXPECT_NEAR(5.7, a.mean(1), 1e-12);
+    EXPECT_NEAR(0.0,  a.covariance(0, 0), 1e-12);
+    EXPECT_NEAR(0.25, a.covariance(1, 1), 1e-12);
+
+    const density_t::Cluster &i = density.getClusters()[isolated];
+    EXPECT_EQ(2u, i.samples);
+    EXPECT_EQ(1u, i.cells);
+    EXPECT_DOUBLE_EQ(2.0, i.weight);
+    EXPECT_NEAR(10.6, i.mean(0), 1e-12);
+    EXPECT_NEAR(0.01, i.covariance(0, 0), 1e-12);
+}
+}
+
+TEST(SampleDensityGrid, clustersSequential)
+{
+    const std::vector<Sample> s = samples();
+    density_t density(Eigen::Vector2d(1.0, 1.0));
+    density.insertRange(s.data(), s.data() + s.size());
+    density.estimate();
+    check(density);
+}
+
+TEST(SampleDensityGrid, clustersParallel)
+{
+    /// components span shards, which are labeled concurrently
+    const std::vector<Sample> s = samples();
+    density_t density(Eigen::Vector2d(1.0, 1.0), std::make_shared<muse_smc::ThreadPool>(4));
+    for (const Sample &sample : s)
+        density.insert(sample);
+    EXPECT_EQ(5u, density.histogramSize());
+    density.estimate();
+    check(density);
+}
+
+TEST(SampleDensityGrid, clearDropsClusters)
+{
+    const std::vector<Sample> s = samples();
+    density_t density(Eigen::Vector2d(1.0, 1.0), std::make_shared<muse_smc::ThreadPool>(4));
+    density.insertRange(s.data(), s.data() + s.size());
+    density.estimate();
+    ASSERT_EQ(3u, density.getClusters().size());
+
+    density.clear();
+    std::size_t c = 0;
+    EXPECT_FALSE(density.getCluster(s.front().state, c));
+    EXPECT_TRUE(density.getClusters().empty());
+    EXPECT_EQ(0u, density.histogramSize());
+
+    /// estimating again gives the same clusters
+    density.reserve(s.size());
+    density.insertRange(s.data(), s.data() + s.size());
+    density.estimate();
+    check(density);
+}
+
+TEST(SampleDensityGrid, largeInsertionInBlocks)
+{
+    /// blocks of a large insertion are split among the threads
+    std::vector<Sample> s;
+    for (std::size_t i = 0 ; i < 10000 ; ++i)
+        s.emplace_back(sample(0.5 + 0.001 * static_cast<double>(i % 100), 0.5, 1.0));
+    density_t density(Eigen::Vector2d(1.0, 1.0), std::make_shared<muse_smc::ThreadPool>(4));
+    density.reserve(s.size());
+    for (std::size_t i = 0 ; i < s.size() ; i += 1000)
+        density.insertRange(s.data() + i, s.data() + i + 1000);
+    density.estimate();
+    ASSERT_EQ(1u, density.getClusters().size());
+    EXPECT_EQ(10000u, density.getClusters().front().samples);
+    EXPECT_DOUBLE_EQ(10000.0, density.getClusters().front().weight);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/resampling/resampling.hpp>
+
+#include "reference/density.hpp"
+#include "reference/state_space_description.hpp"
+
+namespace {
+using description_t = muse_smc::reference::StateSpaceDescription<2>;
+using sample_t      = muse_smc::reference::Sample<2>;
+using sample_set_t  = muse_smc::SampleSet<description_t>;
+
+const std::size_t sample_size = 1000;
+
+/**
+ * @brief Counts how often resampling was carried out.
+ */
+class Counting : public muse_smc::Resampling<description_t>
+{
+public:
+    std::size_t applied = 0;
+
+protected:
+    virtual void doApply(sample_set_t &) override
+    {
+        ++applied;
+    }
+
+    virtual void doApplyRecovery(sample_set_t &) override
+    {
+        ++applied;
+    }
+};
+
+inline sample_set_t::Ptr create()
+{
+    sample_set_t::Ptr sample_set(new sample_set_t("world", cslibs_time::Time(), sample_size,
+                                                  std::make_shared<muse_smc::reference::Grid<2>>(0.5)));
+    auto insertion = sample_set->getInsertion();
+    sample_t sample;
+    for (std::size_t i = 0 ; i < sample_size ; ++i) {
+        sample.state.position = Eigen::Vector2d(static_cast<double>(i), 0.0);
+        insertion.insert(sample);
+    }
+    return sample_set;
+}
+
+/**
+ * @brief Weight the first 'weighted' samples by one and the others by a small weight.
+ */
+inline void weight(sample_set_t     &sample_set,
+                   const std::size_t weighted,
+                   const double      small = 1e-9)
+{
+    {
+        auto weights = sample_set.getWeightIterator();
+        std::size_t i = 0;
+        for (auto it = weights.begin() ; it != weights.end() ; ++it, ++i)
+            *it = i < weighted ? 1.0 : small;
+    }
+    sample_set.normalizeWeights();
+}
+}
+
+TEST(EffectiveSampleSize, weightDistribution)
+{
+    muse_smc::WeightDistribution uniform;
+    muse_smc::WeightDistribution scaled;
+    muse_smc::WeightDistribution single;
+    for (std::size_t i = 0 ; i < 100 ; ++i) {
+        uniform.add(0.5);
+        scaled.add(static_cast<double>(i % 4 + 1));
+        single.add(i == 17 ? 3.0 : 0.0);
+    }
+    EXPECT_NEAR(100.0, uniform.getEffectiveSampleSize(), 1e-9);
+    EXPECT_NEAR(1.0,   single.getEffectiveSampleSize(),  1e-12);
+    /// (sum w)^2 / sum w^2 with weights 1 to 4 repeated
+    EXPECT_NEAR(250.0 * 250.0 / 750.0, scaled.getEffectiveSampleSize(), 1e-9);
+    EXPECT_EQ(0.0, muse_smc::WeightDistribution().getEffectiveSampleSize());
+}
+
+TEST(EffectiveSampleSize, trackedBySampleSet)
+{
+    sample_set_t::Ptr sample_set = create();
+    EXPECT_NEAR(static_cast<double>(sample_size), sample_set->getEffectiveSampleSize(), 1e-6);
+
+    /// independent of normalization
+    weight(*sample_set, sample_size / 4, 0.0);
+    EXPECT_NEAR(1.0, sample_set->getWeightSum(), 1e-12);
+    EXPECT_NEAR(static_cast<double>(sample_size / 4), sample_set->getEffectiveSampleSize(), 1e-6);
+
+    weight(*sample_set, 1, 0.0);
+    EXPECT_NEAR(1.0, sample_set->getEffectiveSampleSize(), 1e-9);
+}
+
+TEST(EffectiveSampleSize, resamplingPolicy)
+{
+    sample_set_t::Ptr sample_set = create();
+    Counting resampling;
+    resampling.setup(nullptr, nullptr, 0.0, 0.0, 0.0, 0.5);
+
+    /// ESS/N of one is above the threshold
+    weight(*sample_set, sample_size);
+    resampling.apply(*sample_set);
+    EXPECT_EQ(0u, resampling.applied);
+
+    /// ESS/N slightly above the threshold
+    weight(*sample_set, sample_size * 6 / 10);
+    resampling.apply(*sample_set);
+    EXPECT_EQ(0u, resampling.applied);
+
+    /// ESS/N below the threshold
+    weight(*sample_set, sample_size * 4 / 10);
+    resampling.apply(*sample_set);
+    EXPECT_EQ(1u, resampling.applied);
+
+    /// without a threshold, every call resamples
+    resampling.setup(nullptr, nullptr);
+    weight(*sample_set, sample_size);
+    resampling.apply(*sample_set);
+    EXPECT_EQ(2u, resampling.applied);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
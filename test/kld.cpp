@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/resampling/impl/kld.hpp>
+
+#include "reference/density.hpp"
+#include "reference/state_space_description.hpp"
+
+namespace {
+using description_t = muse_smc::reference::StateSpaceDescription<2>;
+using sample_t      = muse_smc::reference::Sample<2>;
+using sample_set_t  = muse_smc::SampleSet<description_t>;
+using kld_t         = muse_smc::impl::KLD<description_t>;
+
+/**
+ * @brief A density without histogram.
+ */
+class Plain : public muse_smc::SampleDensity<sample_t>
+{
+public:
+    virtual void clear() override {}
+    virtual void insert(const sample_t &) override {}
+    virtual void estimate() override {}
+};
+
+inline sample_set_t::Ptr create(const muse_smc::SampleDensity<sample_t>::Ptr &density,
+                                const std::size_t                              size,
+                                const double                                   spread)
+{
+    sample_set_t::Ptr sample_set(new sample_set_t("world", cslibs_time::Time(), 10, 5000, density));
+    sample_set->setKLD(0.01, 2.33);
+    sample_set->setRandomSeed(42);
+    auto insertion = sample_set->getInsertion();
+    sample_t sample;
+    for (std::size_t i = 0 ; i < size ; ++i) {
+        sample.state.position(0) = spread * static_cast<double>(i % 100);
+        sample.state.position(1) = spread * static_cast<double>(i / 100);
+        insertion.insert(sample);
+    }
+    return sample_set;
+}
+}
+
+TEST(KLD, withoutHistogramKeepsSampleSize)
+{
+    sample_set_t::Ptr sample_set = create(std::make_shared<Plain>(), 500, 1.0);
+    ASSERT_EQ(500u, sample_set->getSampleSize());
+    for (int i = 0 ; i < 3 ; ++i) {
+        kld_t::apply(*sample_set);
+        EXPECT_EQ(500u, sample_set->getSampleSize());
+    }
+}
+
+TEST(KLD, singleBinShrinksToMinimum)
+{
+    sample_set_t::Ptr sample_set = create(std::make_shared<muse_smc::reference::Grid<2>>(1.0), 500, 0.0);
+    kld_t::apply(*sample_set);
+    EXPECT_EQ(sample_set->getMinimumSampleSize(), sample_set->getSampleSize());
+}
+
+TEST(KLD, spreadSamplesGrow)
+{
+    sample_set_t::Ptr sample_set = create(std::make_shared<muse_smc::reference::Grid<2>>(1.0), 500, 1.0);
+    kld_t::apply(*sample_set);
+    EXPECT_GT(sample_set->getSampleSize(), 500u);
+    EXPECT_LE(sample_set->getSampleSize(), sample_set->getMaximumSampleSize());
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
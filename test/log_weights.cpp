@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/update/update.hpp>
+
+#include "reference/data.hpp"
+#include "reference/density.hpp"
+#include "reference/state_space_description.hpp"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+using description_t = muse_smc::reference::StateSpaceDescription<2>;
+using sample_t      = muse_smc::reference::Sample<2>;
+using sample_set_t  = muse_smc::SampleSet<description_t>;
+using data_t        = muse_smc::reference::Data;
+using update_t      = muse_smc::Update<description_t, data_t>;
+using model_t       = muse_smc::UpdateModel<description_t, data_t>;
+
+/**
+ * @brief Rejects every state.
+ */
+class Reject : public model_t
+{
+public:
+    virtual std::size_t getId() const override
+    {
+        return 0;
+    }
+
+    virtual const std::string getName() const override
+    {
+        return "reject";
+    }
+
+    virtual void apply(const typename data_t::ConstPtr                   &data,
+                       const typename model_t::state_space_t::ConstPtr   &state_space,
+                       typename model_t::sample_set_t::weight_iterator_t  weights) override
+    {
+        for (auto it = weights.begin() ; it != weights.end() ; ++it)
+            *it = 0.0;
+    }
+
+    virtual bool isFusable() const override
+    {
+        return true;
+    }
+
+    virtual double likelihood(const typename data_t::ConstPtr                 &data,
+                              const typename model_t::state_space_t::ConstPtr &state_space,
+                              const typename model_t::state_t                 &state) const override
+    {
+        return 0.0;
+    }
+};
+
+inline sample_set_t::Ptr create(const std::size_t size)
+{
+    sample_set_t::Ptr sample_set(new sample_set_t("world", cslibs_time::Time(), size,
+                                                  std::make_shared<muse_smc::reference::Grid<2>>(1.0)));
+    sample_set->setLogWeights(true);
+    auto insertion = sample_set->getInsertion();
+    for (std::size_t i = 0 ; i < size ; ++i)
+        insertion.insert(sample_t());
+    return sample_set;
+}
+
+inline void expectUniform(const sample_set_t &sample_set)
+{
+    const auto &samples = sample_set.getSamples();
+    const double expected = 1.0 / static_cast<double>(samples.size());
+    for (std::size_t i = 0 ; i < samples.size() ; ++i) {
+        EXPECT_TRUE(muse_smc::kernels::isFinite(samples.weight(i)));
+        EXPECT_NEAR(expected, samples.weight(i), 1e-12);
+    }
+    EXPECT_EQ(1.0, sample_set.getWeightSum());
+}
+}
+
+TEST(LogWeights, minimumLogWeight)
+{
+    EXPECT_DOUBLE_EQ(std::log(std::numeric_limits<double>::min()), muse_smc::kernels::minimumLogWeight());
+}
+
+TEST(LogWeights, isFinite)
+{
+    EXPECT_TRUE(muse_smc::kernels::isFinite(0.0));
+    EXPECT_TRUE(muse_smc::kernels::isFinite(std::numeric_limits<double>::lowest()));
+    EXPECT_FALSE(muse_smc::kernels::isFinite(-std::numeric_limits<double>::infinity()));
+    EXPECT_FALSE(muse_smc::kernels::isFinite(std::numeric_limits<double>::quiet_NaN()));
+}
+
+TEST(LogWeights, allInfiniteResetsWeights)
+{
+    sample_set_t::Ptr sample_set = create(100);
+    {
+        auto weights = sample_set->getWeightIterator();
+        ASSERT_TRUE(weights.isLogDomain());
+        for (auto it = weights.begin() ; it != weights.end() ; ++it)
+            *it = -std::numeric_limits<double>::infinity();
+    }
+    expectUniform(*sample_set);
+}
+
+TEST(LogWeights, nanResetsWeights)
+{
+    sample_set_t::Ptr sample_set = create(100);
+    {
+        auto weights = sample_set->getWeightIterator();
+        for (auto it = weights.begin() ; it != weights.end() ; ++it)
+            *it = std::numeric_limits<double>::quiet_NaN();
+    }
+    expectUniform(*sample_set);
+}
+
+TEST(LogWeights, zeroLikelihoodIsClamped)
+{
+    model_t::Ptr model(new Reject);
+    const double log_likelihood = model->logLikelihood(nullptr, nullptr, sample_t::state_t());
+    EXPECT_DOUBLE_EQ(muse_smc::kernels::minimumLogWeight(), log_likelihood);
+
+    sample_set_t::Ptr sample_set = create(100);
+    update_t::Ptr update(new update_t(nullptr, nullptr, model));
+    update_t::Ptr fused = update_t::fuse({update, update});
+    fused->apply(sample_set->getWeightIterator());
+    expectUniform(*sample_set);
+}
+
+TEST(LogWeights, logSumExpKernel)
+{
+    /// shifted sums stay representable for log weights far outside the range of exp
+    const std::vector<double> weights = {-1000.0, 1000.0, 999.0, -std::numeric_limits<double>::infinity(), 1000.0};
+    double shift = 0.0;
+    const double sum = muse_smc::kernels::logSumExp(weights.data(), weights.size(), shift);
+    EXPECT_EQ(1000.0, shift);
+    EXPECT_NEAR(2.0 + std::exp(-1.0), sum, 1e-12);
+
+    std::vector<double> normalized = weights;
+    const muse_smc::WeightDistribution distribution = muse_smc::kernels::exponentiate(normalized.data(), normalized.size(), shift, sum);
+    EXPECT_NEAR(1.0, distribution.getSum(), 1e-12);
+    EXPECT_EQ(0.0, normalized[0]);
+    EXPECT_EQ(0.0, normalized[3]);
+    EXPECT_NEAR(1.0 / sum, normalized[1], 1e-15);
+    EXPECT_NEAR(std::exp(-1.0) / sum, normalized[2], 1e-15);
+    EXPECT_EQ(0.0, distribution.getMinimum());
+    EXPECT_EQ(normalized[1], distribution.getMaximum());
+
+    /// a growing maximum rescales the sum gathered so far
+    const std::vector<double> ascending = {0.0, 1.0, 2.0, 3.0};
+    const double ascending_sum = muse_smc::kernels::logSumExp(ascending.data(), ascending.size(), shift);
+    EXPECT_EQ(3.0, shift);
+    EXPECT_NEAR(1.0 + std::exp(-1.0) + std::exp(-2.0) + std::exp(-3.0), ascending_sum, 1e-12);
+
+    /// nothing finite to shift by
+    const std::vector<double> empty;
+    EXPECT_EQ(0.0, muse_smc::kernels::logSumExp(empty.data(), 0, shift));
+    const std::vector<double> infinite(4, -std::numeric_limits<double>::infinity());
+    EXPECT_EQ(0.0, muse_smc::kernels::logSumExp(infinite.data(), infinite.size(), shift));
+    const std::vector<double> nan = {0.0, std::numeric_limits<double>::quiet_NaN(), 1.0};
+    EXPECT_FALSE(muse_smc::kernels::isFinite(muse_smc::kernels::logSumExp(nan.data(), nan.size(), shift)));
+}
+
+TEST(LogWeights, extremeLogLikelihoods)
+{
+    sample_set_t::Ptr sample_set = create(100);
+    {
+        auto weights = sample_set->getWeightIterator();
+        std::size_t i = 0;
+        for (auto it = weights.begin() ; it != weights.end() ; ++it, ++i)
+            *it += i < 50 ? -5000.0 : -5000.0 + std::log(3.0);
+    }
+    const auto &samples = sample_set->getSamples();
+    for (std::size_t i = 0 ; i < samples.size() ; ++i)
+        EXPECT_NEAR(i < 50 ? 1.0 / 200.0 : 3.0 / 200.0, samples.weight(i), 1e-12);
+    EXPECT_EQ(1.0, sample_set->getWeightSum());
+    EXPECT_NEAR(1.0, sample_set->getWeightDistribution().getSum(), 1e-12);
+    EXPECT_NEAR(3.0 / 200.0, sample_set->getMaximumWeight(), 1e-12);
+}
+
+TEST(LogWeights, singleFiniteWeight)
+{
+    sample_set_t::Ptr sample_set = create(10);
+    {
+        auto weights = sample_set->getWeightIterator();
+        std::size_t i = 0;
+        for (auto it = weights.begin() ; it != weights.end() ; ++it, ++i)
+            *it = i == 7 ? 12.0 : -std::numeric_limits<double>::infinity();
+    }
+    const auto &samples = sample_set->getSamples();
+    for (std::size_t i = 0 ; i < samples.size() ; ++i)
+        EXPECT_EQ(i == 7 ? 1.0 : 0.0, samples.weight(i));
+}
+
+int main(int argc, char *argv[])
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/resampling/impl/systematic.hpp>
+
+#include "reference/density.hpp"
+#include "reference/state_space_description.hpp"
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+using sample_t = muse_smc::reference::Sample<2>;
+
+struct Description : public muse_smc::reference::StateSpaceDescription<2>
+{
+};
+
+struct DescriptionSoA : public Description
+{
+    using sample_storage_t = muse_smc::SampleStorageSoA<sample_t>;
+};
+
+const std::size_t sample_size = 1000;
+
+template<typename description_t>
+class Offspring : public ::testing::Test
+{
+protected:
+    using sample_set_t  = muse_smc::SampleSet<description_t>;
+    using systematic_t  = muse_smc::impl::Systematic<description_t>;
+
+    /**
+     * @brief A set of normalized samples, the first coordinate holds the index.
+     */
+    inline static typename sample_set_t::Ptr create(const std::size_t minimum = sample_size,
+                                                    const std::size_t maximum = sample_size)
+    {
+        typename sample_set_t::Ptr sample_set(new sample_set_t("world", cslibs_time::Time(), minimum, maximum,
+                                                               std::make_shared<muse_smc::reference::Grid<2>>(0.5), true));
+        sample_set->setRandomSeed(42);
+
+        std::mt19937_64 engine(7);
+        std::uniform_real_distribution<double> w(0.0, 1.0);
+        std::vector<double> weights(sample_size);
+        double sum = 0.0;
+        for (double &weight : weights) {
+            weight = w(engine);
+            sum   += weight;
+        }
+
+        auto insertion = sample_set->getInsertion();
+        sample_t sample;
+        for (std::size_t i = 0 ; i < sample_size ; ++i) {
+            sample.state.position = Eigen::Vector2d(static_cast<double>(i), 0.0);
+            sample.weight         = weights[i] / sum;
+            insertion.insert(sample);
+        }
+        return sample_set;
+    }
+
+    /**
+     * @brief How often each original sample is contained in the set.
+     */
+    inline static std::vector<std::size_t> count(const sample_set_t &sample_set)
+    {
+        std::vector<std::size_t> counts(sample_size, 0);
+        const auto &samples = sample_set.getSamples();
+        for (std::size_t i = 0 ; i < samples.size() ; ++i)
+            ++counts[static_cast<std::size_t>(samples.state(i).position(0))];
+        return counts;
+    }
+
+    /**
+     * @brief Offspring counts with every third sample dropped, the weight moved to
+     *        its successor, and 'grow' offspring appended to the last sample.
+     */
+    inline static std::vector<std::size_t> offspring(const long grow)
+    {
+        std::vector<std::size_t> counts(sample_size, 1);
+        for (std::size_t i = 0 ; i + 1 < sample_size ; i += 3) {
+            counts[i]     = 0;
+            counts[i + 1] = 2;
+        }
+        counts.back() = static_cast<std::size_t>(static_cast<long>(counts.back()) + grow);
+        return counts;
+    }
+};
+
+using Descriptions = ::testing::Types<Description, DescriptionSoA>;
+TYPED_TEST_CASE(Offspring, Descriptions);
+}
+
+TYPED_TEST(Offspring, permuteKeepsParentsInPlace)
+{
+    auto sample_set = this->create();
+    const std::vector<std::size_t> counts = this->offspring(0);
+    sample_set->permute(counts);
+
+    ASSERT_EQ(sample_size, sample_set->getSampleSize());
+    EXPECT_EQ(counts, this->count(*sample_set));
+    const auto &samples = sample_set->getSamples();
+    for (std::size_t i = 0 ; i < sample_size ; ++i) {
+        if (counts[i] > 0)
+            EXPECT_EQ(static_cast<double>(i), samples.state(i).position(0));
+    }
+    /// weights are kept, as requested by the sample set
+    EXPECT_EQ(sample_size, sample_set->getWeightDistribution().getN());
+}
+
+TYPED_TEST(Offspring, permuteChangesSampleSize)
+{
+    auto grown = this->create(sample_size / 2, sample_size * 2);
+    const std::vector<std::size_t> more = this->offspring(100);
+    grown->permute(more);
+    ASSERT_EQ(sample_size + 100, grown->getSampleSize());
+    EXPECT_EQ(more, this->count(*grown));
+
+    /// the samples at the end are dropped, others are moved in
+    auto shrunk = this->create(sample_size / 2, sample_size * 2);
+    std::vector<std::size_t> fewer(sample_size, 0);
+    for (std::size_t i = sample_size / 2 ; i < sample_size ; ++i)
+        fewer[i] = i % 2 == 0 ? 2 : 0;
+    shrunk->permute(fewer);
+    ASSERT_EQ(sample_size / 2, shrunk->getSampleSize());
+    EXPECT_EQ(fewer, this->count(*shrunk));
+}
+
+TYPED_TEST(Offspring, permuteRejectsSizeMismatch)
+{
+    auto sample_set = this->create();
+    EXPECT_THROW(sample_set->permute(std::vector<std::size_t>(sample_size - 1, 1)), std::invalid_argument);
+    EXPECT_THROW(sample_set->permute(std::vector<std::size_t>(sample_size + 1, 1)), std::invalid_argument);
+    /// the set is left untouched
+    EXPECT_EQ(std::vector<std::size_t>(sample_size, 1), this->count(*sample_set));
+}
+
+TYPED_TEST(Offspring, inPlaceMatchesInsertion)
+{
+    /// the order of the samples differs after a permutation, so each seed starts afresh
+    for (std::uint64_t seed = 0 ; seed < 8 ; ++seed) {
+        auto copied   = this->create();
+        auto in_place = this->create();
+        copied->setRandomSeed(seed);
+        in_place->setRandomSeed(seed);
+        TestFixture::systematic_t::apply(*copied);
+        TestFixture::systematic_t::applyInPlace(*in_place);
+        ASSERT_EQ(copied->getSampleSize(), in_place->getSampleSize());
+        EXPECT_EQ(this->count(*copied), this->count(*in_place));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
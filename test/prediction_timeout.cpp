@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/smc/smc.hpp>
+
+#include "reference/data.hpp"
+#include "reference/state_space_description.hpp"
+#include "reference/prediction_model.hpp"
+#include "reference/update_model.hpp"
+#include "reference/sampling.hpp"
+#include "reference/density.hpp"
+#include "reference/scheduling.hpp"
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace {
+using namespace muse_smc::reference;
+using description_t = StateSpaceDescription<2>;
+using smc_t         = muse_smc::SMC<description_t, Data>;
+using sample_set_t  = muse_smc::SampleSet<description_t>;
+using prediction_t  = smc_t::prediction_t;
+using update_t      = smc_t::update_t;
+using beacons_t     = Beacons<2>;
+using clock_t       = std::chrono::steady_clock;
+
+const std::size_t max_deferrals = 2;
+const double      timeout       = 0.02;
+
+/**
+ * @brief Late ticks are never bridged, updates have to be deferred.
+ */
+class NoExtrapolation : public ConstantVelocity<2>
+{
+public:
+    using ConstantVelocity<2>::ConstantVelocity;
+
+    virtual Result::Ptr extrapolate(const Result::ConstPtr                 &,
+                                    const cslibs_time::Time                &,
+                                    base_t::sample_set_t::state_iterator_t  ) override
+    {
+        return Result::Ptr(new Result);
+    }
+};
+
+/**
+ * @brief Counts publications and keeps the stamp of the last one.
+ */
+class Publications : public muse_smc::SMCState<description_t>
+{
+public:
+    using Ptr = std::shared_ptr<Publications>;
+
+    virtual void publish(const sample_set_t::ConstPtr &sample_set) override
+    {
+        record(sample_set);
+    }
+
+    virtual void publishIntermediate(const sample_set_t::ConstPtr &sample_set) override
+    {
+        record(sample_set);
+    }
+
+    virtual void publishConstant(const sample_set_t::ConstPtr &sample_set) override
+    {
+        record(sample_set);
+    }
+
+    inline std::size_t count() const
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+        return count_;
+    }
+
+    inline cslibs_time::Time stamp() const
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+        return stamp_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::size_t        count_ = 0;
+    cslibs_time::Time  stamp_;
+
+    inline void record(const sample_set_t::ConstPtr &sample_set)
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+        ++count_;
+        stamp_ = sample_set->getStamp();
+    }
+};
+
+/**
+ * @brief Poll until the condition holds.
+ * @return the seconds passed, or a negative value if the deadline was exceeded
+ */
+inline double waitFor(const std::function<bool()> &condition,
+                      const double                 deadline = 5.0)
+{
+    const clock_t::time_point start = clock_t::now();
+    while (!condition()) {
+        const double passed = std::chrono::duration<double>(clock_t::now() - start).count();
+        if (passed > deadline)
+            return -1.0;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return std::chrono::duration<double>(clock_t::now() - start).count();
+}
+
+class PredictionTimeout : public ::testing::Test
+{
+protected:
+    const cslibs_time::Time start = cslibs_time::Time(1.0);
+
+    smc_t                           smc;
+    Publications::Ptr               publications;
+    NoExtrapolation::Ptr            prediction_model;
+    GaussianBeacons<2>::Ptr         update_model;
+    beacons_t::points_t             beacons;
+
+    virtual void SetUp() override
+    {
+        sample_set_t::Ptr sample_set(new sample_set_t("world", start, 200, std::make_shared<Grid<2>>(0.5)));
+        Uniform<2>::Ptr    uniform(new Uniform<2>(10.0, 1.0, 1));
+        Normal<2>::Ptr     normal(new Normal<2>(2));
+        Systematic<2>::Ptr resampling(new Systematic<2>);
+        resampling->setup(uniform, normal);
+        smc_t::prediction_integrals_t::Ptr integrals(new smc_t::prediction_integrals_t(std::make_shared<Elapsed<2>>()));
+        integrals->set(std::make_shared<Elapsed<2>>(), 0);
+        Immediate<2>::Ptr scheduler(new Immediate<2>(cslibs_time::Duration(0.0)));
+
+        publications.reset(new Publications);
+        prediction_model.reset(new NoExtrapolation(0.05, 0.1));
+        update_model.reset(new GaussianBeacons<2>(0, 0.1));
+        beacons = {beacons_t::point_t(1.0, 2.0), beacons_t::point_t(-3.0, 1.0)};
+
+        smc.setup(sample_set, uniform, normal, resampling, publications, integrals, scheduler, false, false, false, false);
+        smc.setPredictionTimeout(cslibs_time::Duration(timeout), max_deferrals);
+        smc.requestUniformInitialization(start);
+        smc.start();
+    }
+
+    virtual void TearDown() override
+    {
+        smc.end();
+    }
+
+    inline void tick(const double from,
+                     const double to)
+    {
+        Data::ConstPtr data(new Tick(cslibs_time::TimeFrame(start + cslibs_time::Duration(from),
+                                                            start + cslibs_time::Duration(to)), start));
+        smc.addPrediction(prediction_t::Ptr(new prediction_t(data, prediction_model)));
+    }
+
+    inline void update(const double at)
+    {
+        const cslibs_time::Time stamp = start + cslibs_time::Duration(at);
+        Data::ConstPtr data(new beacons_t(stamp, stamp, beacons, std::vector<double>{2.0, 3.0}));
+        smc.addUpdate(update_t::Ptr(new update_t(data, nullptr, update_model)));
+    }
+};
+}
+
+TEST_F(PredictionTimeout, stalledPredictionsAreBounded)
+{
+    tick(0.0, 0.1);
+    update(0.1);
+    ASSERT_GE(waitFor([this]() { return publications->count() > 0; }), 0.0);
+
+    /// no ticks arrive for these, every update is resolved within the deferrals
+    const std::size_t late = 20;
+    for (std::size_t i = 1 ; i <= late ; ++i)
+        update(0.1 + 0.01 * static_cast<double>(i));
+
+    const double passed = waitFor([this]() { return smc.getPredictionStatistics().drops == late; });
+    ASSERT_GE(passed, 0.0);
+    EXPECT_LT(passed, static_cast<double>(max_deferrals + 1) * timeout + 0.5);
+
+    const smc_t::PredictionStatistics statistics = smc.getPredictionStatistics();
+    EXPECT_EQ(max_deferrals + 1, statistics.timeouts);
+    EXPECT_EQ(max_deferrals, statistics.deferrals);
+    EXPECT_EQ(0u, statistics.extrapolations);
+    EXPECT_EQ(late, smc.getMetrics().dropped_updates);
+}
+
+TEST_F(PredictionTimeout, requestsAreServedWhileDeferred)
+{
+    tick(0.0, 0.1);
+    update(0.1);
+    ASSERT_GE(waitFor([this]() { return publications->count() > 0; }), 0.0);
+
+    /// the update waits for a tick, the request is served in between
+    update(0.2);
+    ASSERT_GE(waitFor([this]() { return smc.getPredictionStatistics().deferrals > 0; }), 0.0);
+    const std::size_t published = publications->count();
+    smc.requestUniformInitialization(start + cslibs_time::Duration(0.1));
+    EXPECT_GE(waitFor([this, published]() { return publications->count() > published; }, 10.0 * timeout), 0.0);
+}
+
+TEST_F(PredictionTimeout, lateTicksResumeProcessing)
+{
+    tick(0.0, 0.1);
+    update(0.1);
+    ASSERT_GE(waitFor([this]() { return publications->count() > 0; }), 0.0);
+
+    update(0.2);
+    ASSERT_GE(waitFor([this]() { return smc.getPredictionStatistics().drops == 1; }), 0.0);
+
+    /// once ticks arrive again, updates are waited for and processed
+    const cslibs_time::Time stamp = start + cslibs_time::Duration(0.5);
+    tick(0.1, 0.5);
+    update(0.5);
+    ASSERT_GE(waitFor([this, stamp]() { return publications->stamp() == stamp; }), 0.0);
+    EXPECT_EQ(1u, smc.getPredictionStatistics().drops);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/resampling/impl/prefix_sum.hpp>
+#include <muse_smc/samples/sample_welford.hpp>
+
+#include "reference/density.hpp"
+#include "reference/state_space_description.hpp"
+
+#include <random>
+
+namespace {
+using description_t = muse_smc::reference::StateSpaceDescription<2>;
+using sample_t      = muse_smc::reference::Sample<2>;
+using state_t       = sample_t::state_t;
+using sample_set_t  = muse_smc::SampleSet<description_t>;
+using prefix_sum_t  = muse_smc::impl::PrefixSum<description_t>;
+
+struct Position
+{
+    inline Eigen::Vector2d operator()(const state_t &state) const
+    {
+        return state.position;
+    }
+};
+
+using welford_t = muse_smc::WelfordEstimator<sample_t, 2, Position>;
+
+const std::size_t sample_size = 50000;
+
+inline sample_set_t::Ptr create(const std::size_t threads)
+{
+    sample_set_t::Ptr sample_set(new sample_set_t("world", cslibs_time::Time(), sample_size,
+                                                  std::make_shared<muse_smc::reference::Grid<2>>(0.5), true));
+    sample_set->setRandomSeed(42);
+    sample_set->setThreadPool(std::make_shared<muse_smc::ThreadPool>(threads));
+
+    std::mt19937_64 engine(7);
+    std::normal_distribution<double>       x(0.0, 3.0);
+    std::uniform_real_distribution<double> w(0.0, 1.0);
+    auto insertion = sample_set->getInsertion();
+    sample_t sample;
+    for (std::size_t i = 0 ; i < sample_size ; ++i) {
+        sample.state.position = Eigen::Vector2d(x(engine), x(engine));
+        sample.weight         = w(engine);
+        insertion.insert(sample);
+    }
+    return sample_set;
+}
+
+/**
+ * @brief Stratified resampling, every sample draws from the random stream of its block.
+ */
+inline void resample(sample_set_t &sample_set)
+{
+    const std::size_t size = sample_set.getSampleSize();
+    prefix_sum_t::apply(sample_set, [size](const std::size_t i, std::mt19937_64 &rng) {
+        return (i + std::uniform_real_distribution<double>(0.0, 1.0)(rng)) / size;
+    });
+}
+}
+
+TEST(PrefixSum, independentOfThreadCount)
+{
+    sample_set_t::Ptr serial   = create(1);
+    sample_set_t::Ptr parallel = create(4);
+    ASSERT_GT(sample_size, prefix_sum_t::blockSize());
+
+    for (int step = 0 ; step < 3 ; ++step) {
+        resample(*serial);
+        resample(*parallel);
+
+        ASSERT_EQ(sample_size, serial->getSampleSize());
+        ASSERT_EQ(sample_size, parallel->getSampleSize());
+        for (std::size_t i = 0 ; i < sample_size ; ++i) {
+            ASSERT_EQ(serial->getSamples().state(i).position, parallel->getSamples().state(i).position);
+            ASSERT_EQ(serial->getSamples().weight(i),         parallel->getSamples().weight(i));
+        }
+    }
+}
+
+TEST(PrefixSum, blockStatistics)
+{
+    sample_set_t::Ptr sample_set = create(4);
+    welford_t::Ptr    welford(new welford_t);
+    sample_set->setEstimator(welford);
+    resample(*sample_set);
+
+    /// statistics of the committed blocks are merged when the insertion is closed
+    const sample_set_t::sample_vector_t &samples = sample_set->getSamples();
+    welford_t sequential;
+    double    weight_sum = 0.0;
+    for (std::size_t i = 0 ; i < samples.size() ; ++i) {
+        sequential.insert(samples.state(i), samples.weight(i));
+        weight_sum += samples.weight(i);
+    }
+    EXPECT_NEAR(1.0, sample_set->getWeightSum(), 1e-9);
+    EXPECT_NEAR(weight_sum, sample_set->getWeightDistribution().getSum(), 1e-9);
+    EXPECT_EQ(sample_size, sample_set->getWeightDistribution().getN());
+    EXPECT_EQ(sample_size, welford->getN());
+    EXPECT_TRUE(welford->getMean().isApprox(sequential.getMean(), 1e-10));
+    EXPECT_TRUE(welford->getCovariance().isApprox(sequential.getCovariance(), 1e-10));
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
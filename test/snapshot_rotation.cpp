@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/samples/sample_set.hpp>
+
+#include <atomic>
+
+namespace {
+/**
+ * @brief Counts how often states are copied.
+ */
+struct State
+{
+    static std::atomic<std::size_t> copies;
+
+    double x = 0.0;
+
+    State() = default;
+
+    State(const State &other) :
+        x(other.x)
+    {
+        ++copies;
+    }
+
+    State& operator = (const State &other)
+    {
+        x = other.x;
+        ++copies;
+        return *this;
+    }
+};
+std::atomic<std::size_t> State::copies(0);
+
+struct Sample
+{
+    using state_t     = State;
+    using allocator_t = std::allocator<Sample>;
+
+    state_t state;
+    double  weight = 1.0;
+
+    Sample() = default;
+
+    Sample(const state_t &state,
+           const double   weight) :
+        state(state),
+        weight(weight)
+    {
+    }
+};
+
+struct Description
+{
+    using state_t  = State;
+    using sample_t = Sample;
+};
+
+struct DescriptionSoA : public Description
+{
+    using sample_storage_t = muse_smc::SampleStorageSoA<Sample>;
+};
+
+class NoDensity : public muse_smc::SampleDensity<Sample>
+{
+public:
+    virtual void clear() override
+    {
+    }
+
+    virtual void insert(const Sample &) override
+    {
+    }
+
+    virtual void estimate() override
+    {
+    }
+};
+
+const std::size_t sample_size = 1000;
+
+template<typename description_t>
+class SnapshotRotation : public ::testing::Test
+{
+protected:
+    using sample_set_t = muse_smc::SampleSet<description_t>;
+
+    std::shared_ptr<sample_set_t> sample_set;
+
+    virtual void SetUp() override
+    {
+        sample_set.reset(new sample_set_t("world", cslibs_time::Time(), sample_size, std::make_shared<NoDensity>()));
+        auto insertion = sample_set->getInsertion();
+        for (std::size_t i = 0 ; i < sample_size ; ++i) {
+            Sample sample;
+            sample.state.x = static_cast<double>(i);
+            insertion.insert(sample);
+        }
+    }
+};
+
+using Descriptions = ::testing::Types<Description, DescriptionSoA>;
+TYPED_TEST_CASE(SnapshotRotation, Descriptions);
+}
+
+TYPED_TEST(SnapshotRotation, predictionCopiesWhileVisiting)
+{
+    const auto snapshot = this->sample_set->snapshot();
+    State::copies = 0;
+    {
+        auto states = this->sample_set->getStateIterator();
+        std::size_t visited = 0;
+        for (auto &state : states) {
+            /// only the samples visited so far were copied
+            EXPECT_EQ(++visited, State::copies);
+            state.x += 0.5;
+        }
+    }
+    EXPECT_EQ(sample_size, State::copies.load());
+
+    /// the snapshot keeps the states it was taken with
+    for (std::size_t i = 0 ; i < sample_size ; ++i) {
+        EXPECT_EQ(static_cast<double>(i),       snapshot.getSamples().state(i).x);
+        EXPECT_EQ(static_cast<double>(i) + 0.5, this->sample_set->getSamples().state(i).x);
+    }
+}
+
+TYPED_TEST(SnapshotRotation, unvisitedSamplesAreCopiedOnRelease)
+{
+    const auto snapshot = this->sample_set->snapshot();
+    {
+        auto states = this->sample_set->getStateIterator();
+        auto it = states.begin();
+        for (std::size_t i = 0 ; i < sample_size / 2 ; ++i, ++it)
+            (*it).x = -1.0;
+    }
+    for (std::size_t i = 0 ; i < sample_size ; ++i)
+        EXPECT_EQ(i < sample_size / 2 ? -1.0 : static_cast<double>(i), this->sample_set->getSamples().state(i).x);
+}
+
+TYPED_TEST(SnapshotRotation, partitionedUpdate)
+{
+    this->sample_set->setThreadPool(std::make_shared<muse_smc::ThreadPool>(4));
+    const auto   snapshot = this->sample_set->snapshot();
+    const double weight   = snapshot.getSamples().weight(0);
+    State::copies = 0;
+    {
+        auto weights    = this->sample_set->getWeightIterator();
+        auto partitions = weights.partition(4);
+        weights.getThreadPool()->parallelFor(partitions.size(), [&partitions](const std::size_t p) {
+            for (auto it = partitions[p].begin() ; it != partitions[p].end() ; ++it)
+                *it *= it.state().x + 1.0;
+        });
+    }
+    EXPECT_EQ(sample_size, State::copies.load());
+
+    const double n   = static_cast<double>(sample_size);
+    const double sum = 0.5 * n * (n + 1.0);
+    EXPECT_DOUBLE_EQ(1.0, this->sample_set->getWeightSum());
+    for (std::size_t i = 0 ; i < sample_size ; ++i) {
+        EXPECT_EQ(static_cast<double>(i), this->sample_set->getSamples().state(i).x);
+        EXPECT_NEAR((static_cast<double>(i) + 1.0) / sum, this->sample_set->getSamples().weight(i), 1e-15);
+        EXPECT_EQ(weight, snapshot.getSamples().weight(i));
+    }
+}
+
+TYPED_TEST(SnapshotRotation, releasedSnapshotsAreWrittenInPlace)
+{
+    const void *samples = &this->sample_set->getSamples();
+    State::copies = 0;
+    {
+        auto states = this->sample_set->getStateIterator();
+        for (auto &state : states)
+            state.x += 1.0;
+    }
+    EXPECT_EQ(0u, State::copies.load());
+    EXPECT_EQ(samples, &this->sample_set->getSamples());
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
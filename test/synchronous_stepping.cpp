@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/smc/smc.hpp>
+
+#include "reference/data.hpp"
+#include "reference/state_space_description.hpp"
+#include "reference/prediction_model.hpp"
+#include "reference/update_model.hpp"
+#include "reference/sampling.hpp"
+#include "reference/density.hpp"
+#include "reference/scheduling.hpp"
+
+#include <memory>
+
+namespace {
+using namespace muse_smc::reference;
+using description_t = StateSpaceDescription<2>;
+using smc_t         = muse_smc::SMC<description_t, Data>;
+using sample_set_t  = muse_smc::SampleSet<description_t>;
+using prediction_t  = smc_t::prediction_t;
+using update_t      = smc_t::update_t;
+using beacons_t     = Beacons<2>;
+
+/**
+ * @brief Counts publications.
+ */
+class Publications : public muse_smc::SMCState<description_t>
+{
+public:
+    using Ptr = std::shared_ptr<Publications>;
+
+    std::size_t count = 0;
+
+    virtual void publish(const sample_set_t::ConstPtr &) override
+    {
+        ++count;
+    }
+
+    virtual void publishIntermediate(const sample_set_t::ConstPtr &) override
+    {
+        ++count;
+    }
+
+    virtual void publishConstant(const sample_set_t::ConstPtr &) override
+    {
+        ++count;
+    }
+};
+
+/**
+ * @brief A filter which is never started, inputs are processed by stepping.
+ */
+struct Filter
+{
+    const cslibs_time::Time start = cslibs_time::Time(1.0);
+
+    smc_t                   smc;
+    sample_set_t::Ptr       sample_set;
+    Publications::Ptr       publications;
+    ConstantVelocity<2>::Ptr prediction_model;
+    GaussianBeacons<2>::Ptr update_model;
+    beacons_t::points_t     beacons;
+
+    inline Filter()
+    {
+        sample_set.reset(new sample_set_t("world", start, 500, std::make_shared<Grid<2>>(0.5)));
+        sample_set->setRandomSeed(42);
+        Uniform<2>::Ptr    uniform(new Uniform<2>(10.0, 1.0, 1));
+        Normal<2>::Ptr     normal(new Normal<2>(2));
+        Systematic<2>::Ptr resampling(new Systematic<2>);
+        resampling->setup(uniform, normal);
+        smc_t::prediction_integrals_t::Ptr integrals(new smc_t::prediction_integrals_t(std::make_shared<Elapsed<2>>()));
+        integrals->set(std::make_shared<Elapsed<2>>(), 0);
+        Immediate<2>::Ptr scheduler(new Immediate<2>(cslibs_time::Duration(0.2)));
+
+        publications.reset(new Publications);
+        prediction_model.reset(new ConstantVelocity<2>(0.05, 0.1));
+        update_model.reset(new GaussianBeacons<2>(0, 0.5));
+        beacons = {beacons_t::point_t(1.0, 2.0), beacons_t::point_t(-3.0, 1.0)};
+
+        smc.setup(sample_set, uniform, normal, resampling, publications, integrals, scheduler, false, false, false, false);
+        smc.requestUniformInitialization(start);
+    }
+
+    inline void tick(const double from,
+                     const double to)
+    {
+        Data::ConstPtr data(new Tick(cslibs_time::TimeFrame(start + cslibs_time::Duration(from),
+                                                            start + cslibs_time::Duration(to)), start));
+        smc.addPrediction(prediction_t::Ptr(new prediction_t(data, prediction_model)));
+    }
+
+    inline void update(const double at)
+    {
+        const cslibs_time::Time stamp = start + cslibs_time::Duration(at);
+        Data::ConstPtr data(new beacons_t(stamp, stamp, beacons, std::vector<double>{2.0 + at, 3.0 - at}));
+        smc.addUpdate(update_t::Ptr(new update_t(data, nullptr, update_model)));
+    }
+
+    /**
+     * @brief Ticks of 0.1s, which do not line up with the updates every 0.15s.
+     */
+    inline void inputs(const std::size_t ticks)
+    {
+        for (std::size_t i = 0 ; i < ticks ; ++i)
+            tick(0.1 * static_cast<double>(i), 0.1 * static_cast<double>(i + 1));
+        for (double at = 0.15 ; at <= 0.1 * static_cast<double>(ticks) + 1e-9 ; at += 0.15)
+            update(at);
+    }
+};
+}
+
+TEST(SynchronousStepping, stepDrainsCoveredUpdates)
+{
+    Filter filter;
+    filter.inputs(6);
+    /// updates at 0.15, 0.3, 0.45 and 0.6 are covered by the ticks
+    EXPECT_EQ(4u, filter.smc.step());
+    EXPECT_EQ(filter.start + cslibs_time::Duration(0.6), filter.sample_set->getStamp());
+    EXPECT_LT(0u, filter.publications->count);
+
+    /// nothing is left to do
+    EXPECT_EQ(0u, filter.smc.step());
+}
+
+TEST(SynchronousStepping, stepStopsAtMissingPredictions)
+{
+    Filter filter;
+    filter.tick(0.0, 0.1);
+    filter.update(0.1);
+    filter.update(0.3);
+    EXPECT_EQ(1u, filter.smc.step());
+
+    /// the update stays queued until a tick reaches its stamp
+    EXPECT_EQ(0u, filter.smc.step());
+    filter.tick(0.1, 0.3);
+    EXPECT_EQ(1u, filter.smc.step());
+    EXPECT_EQ(filter.start + cslibs_time::Duration(0.3), filter.sample_set->getStamp());
+    EXPECT_EQ(0u, filter.smc.getPredictionStatistics().drops);
+}
+
+TEST(SynchronousStepping, processUntilIsBounded)
+{
+    Filter filter;
+    filter.inputs(6);
+    EXPECT_EQ(0u, filter.smc.processUntil(filter.start + cslibs_time::Duration(0.1)));
+    EXPECT_EQ(2u, filter.smc.processUntil(filter.start + cslibs_time::Duration(0.3)));
+    EXPECT_EQ(filter.start + cslibs_time::Duration(0.3), filter.sample_set->getStamp());
+    EXPECT_EQ(2u, filter.smc.processUntil(filter.start + cslibs_time::Duration(1.0)));
+}
+
+TEST(SynchronousStepping, reproducibleAcrossSteps)
+{
+    Filter once;
+    once.inputs(20);
+    EXPECT_EQ(13u, once.smc.step());
+
+    /// the same inputs, processed in uneven chunks
+    Filter chunked;
+    chunked.inputs(20);
+    std::size_t processed = 0;
+    for (const double until : {0.2, 0.25, 0.9, 1.35, 2.0})
+        processed += chunked.smc.processUntil(chunked.start + cslibs_time::Duration(until));
+    EXPECT_EQ(13u, processed);
+
+    const sample_set_t::sample_vector_t &expected = once.sample_set->getSamples();
+    const sample_set_t::sample_vector_t &actual   = chunked.sample_set->getSamples();
+    ASSERT_EQ(expected.size(), actual.size());
+    for (std::size_t i = 0 ; i < expected.size() ; ++i) {
+        ASSERT_EQ(expected.state(i).position, actual.state(i).position) << i;
+        ASSERT_EQ(expected.state(i).velocity, actual.state(i).velocity) << i;
+        ASSERT_EQ(expected.weight(i),         actual.weight(i)) << i;
+    }
+    EXPECT_EQ(once.sample_set->getStamp(), chunked.sample_set->getStamp());
+}
+
+TEST(SynchronousStepping, refusedWhileRunning)
+{
+    Filter filter;
+    filter.smc.start();
+    EXPECT_EQ(0u, filter.smc.step());
+    filter.smc.end();
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/utility/thread_pool.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST(ThreadPool, executesEveryTask)
+{
+    muse_smc::ThreadPool pool(4);
+    for (std::size_t count : {1u, 3u, 4u, 100u}) {
+        std::vector<std::atomic<int>> executed(count);
+        for (auto &e : executed)
+            e = 0;
+        pool.parallelFor(count, [&executed](const std::size_t i) {
+            ++executed[i];
+        });
+        for (const auto &e : executed)
+            EXPECT_EQ(1, e.load());
+    }
+}
+
+TEST(ThreadPool, rethrowsOnCaller)
+{
+    for (std::size_t threads : {1u, 4u}) {
+        muse_smc::ThreadPool pool(threads);
+        std::atomic<std::size_t> executed(0);
+        EXPECT_THROW(pool.parallelFor(64, [&executed](const std::size_t i) {
+            ++executed;
+            if (i % 8 == 3)
+                throw std::runtime_error("task failed");
+        }), std::runtime_error);
+        /// failing tasks do not keep the others from running
+        EXPECT_EQ(64u, executed.load());
+
+        /// the pool is still usable
+        executed = 0;
+        pool.parallelFor(64, [&executed](const std::size_t) {
+            ++executed;
+        });
+        EXPECT_EQ(64u, executed.load());
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/update/update.hpp>
+
+#include "reference/data.hpp"
+#include "reference/density.hpp"
+#include "reference/state_space_description.hpp"
+#include "reference/update_model.hpp"
+
+#include <random>
+#include <vector>
+
+namespace {
+using description_t = muse_smc::reference::StateSpaceDescription<2>;
+using sample_t      = muse_smc::reference::Sample<2>;
+using sample_set_t  = muse_smc::SampleSet<description_t>;
+using data_t        = muse_smc::reference::Data;
+using beacons_t     = muse_smc::reference::Beacons<2>;
+using model_t       = muse_smc::reference::GaussianBeacons<2>;
+using update_t      = muse_smc::Update<description_t, data_t>;
+
+const std::size_t sample_size = 10000;
+
+inline sample_set_t::Ptr create(const bool        log_weights,
+                                const std::size_t threads)
+{
+    sample_set_t::Ptr sample_set(new sample_set_t("world", cslibs_time::Time(), sample_size,
+                                                  std::make_shared<muse_smc::reference::Grid<2>>(0.5)));
+    sample_set->setLogWeights(log_weights);
+    if (threads > 1)
+        sample_set->setThreadPool(std::make_shared<muse_smc::ThreadPool>(threads));
+
+    std::mt19937_64 engine(3);
+    std::uniform_real_distribution<double> x(-5.0, 5.0);
+    auto insertion = sample_set->getInsertion();
+    sample_t sample;
+    for (std::size_t i = 0 ; i < sample_size ; ++i) {
+        sample.state.position = Eigen::Vector2d(x(engine), x(engine));
+        insertion.insert(sample);
+    }
+    return sample_set;
+}
+
+/**
+ * @brief Two updates sharing a stamp, as taken by two rigidly mounted sensors.
+ */
+inline update_t::updates_t updates()
+{
+    const cslibs_time::Time stamp(1.0);
+    beacons_t::points_t left  = {beacons_t::point_t(-4.0, 0.0), beacons_t::point_t(0.0, 4.0)};
+    beacons_t::points_t right = {beacons_t::point_t(4.0, 0.0),  beacons_t::point_t(0.0, -4.0)};
+    data_t::ConstPtr left_data(new beacons_t(stamp, stamp, left, {4.5, 3.5}));
+    data_t::ConstPtr right_data(new beacons_t(stamp, stamp, right, {3.0, 5.0}));
+    return {update_t::Ptr(new update_t(left_data,  nullptr, std::make_shared<model_t>(0, 1.0))),
+            update_t::Ptr(new update_t(right_data, nullptr, std::make_shared<model_t>(1, 2.0)))};
+}
+}
+
+TEST(UpdateFusion, fusedReportsFirstUpdate)
+{
+    const update_t::updates_t u = updates();
+    EXPECT_FALSE(u.front()->isFused());
+    EXPECT_TRUE(u.front()->getFused().empty());
+
+    update_t::Ptr fused = update_t::fuse(u);
+    EXPECT_TRUE(fused->isFused());
+    ASSERT_EQ(2u, fused->getFused().size());
+    EXPECT_EQ(u[0], fused->getFused()[0]);
+    EXPECT_EQ(u[1], fused->getFused()[1]);
+    EXPECT_EQ(u[0]->getModelId(), fused->getModelId());
+    EXPECT_EQ(u[0]->getStamp(),   fused->getStamp());
+}
+
+TEST(UpdateFusion, fusedMatchesSequential)
+{
+    for (const bool log_weights : {false, true}) {
+        for (const std::size_t threads : {1u, 4u}) {
+            sample_set_t::Ptr sequential = create(log_weights, threads);
+            sample_set_t::Ptr fused      = create(log_weights, threads);
+
+            const update_t::updates_t u = updates();
+            for (const update_t::Ptr &update : u) {
+                update->apply(sequential->getWeightIterator());
+                sequential->normalizeWeights();
+            }
+            update_t::fuse(u)->apply(fused->getWeightIterator());
+            fused->normalizeWeights();
+
+            const auto &expected = sequential->getSamples();
+            const auto &actual   = fused->getSamples();
+            ASSERT_EQ(expected.size(), actual.size());
+            for (std::size_t i = 0 ; i < expected.size() ; ++i)
+                ASSERT_NEAR(expected.weight(i), actual.weight(i), 1e-12 * sequential->getMaximumWeight())
+                        << "log weights " << log_weights << ", threads " << threads << ", sample " << i;
+            EXPECT_NEAR(1.0, fused->getWeightSum(), 1e-12);
+            EXPECT_NEAR(sequential->getMaximumWeight(), fused->getMaximumWeight(), 1e-12);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
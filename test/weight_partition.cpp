@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/samples/sample_weight_iterator.hpp>
+
+#include "reference/state_space_description.hpp"
+
+#include <utility>
+
+namespace {
+using sample_t = muse_smc::reference::Sample<2>;
+
+struct Description : public muse_smc::reference::StateSpaceDescription<2>
+{
+};
+
+struct DescriptionSoA : public Description
+{
+    using sample_storage_t = muse_smc::SampleStorageSoA<sample_t>;
+};
+
+/**
+ * @brief Records the notifications of a weight iteration.
+ */
+struct Recorder
+{
+    std::size_t                  touched  = 0;
+    std::size_t                  finished = 0;
+    muse_smc::WeightDistribution distribution;
+
+    inline void touch()
+    {
+        ++touched;
+    }
+
+    inline void finish(const muse_smc::WeightDistribution &d)
+    {
+        ++finished;
+        distribution = d;
+    }
+};
+
+const std::size_t sample_size = 1001;
+
+template<typename description_t>
+class WeightPartition : public ::testing::Test
+{
+protected:
+    using iteration_t = muse_smc::WeightIteration<description_t>;
+    using storage_t   = typename iteration_t::sample_vector_t;
+
+    storage_t samples;
+    Recorder  recorder;
+
+    virtual void SetUp() override
+    {
+        samples = storage_t(0, sample_size);
+        for (std::size_t i = 0 ; i < sample_size ; ++i) {
+            sample_t sample;
+            sample.state.position(0) = static_cast<double>(i);
+            samples.push_back(sample);
+        }
+    }
+
+    inline iteration_t iteration()
+    {
+        return iteration_t(samples,
+                           iteration_t::notify_touch::template    from<Recorder, &Recorder::touch>(&recorder),
+                           iteration_t::notify_finished::template from<Recorder, &Recorder::finish>(&recorder));
+    }
+
+    inline static double weight(const std::size_t i)
+    {
+        return 0.5 + static_cast<double>(i % 7);
+    }
+};
+
+using Descriptions = ::testing::Types<Description, DescriptionSoA>;
+TYPED_TEST_CASE(WeightPartition, Descriptions);
+}
+
+TYPED_TEST(WeightPartition, partitionsMergeLikeOnePass)
+{
+    muse_smc::WeightDistribution expected;
+    for (std::size_t i = 0 ; i < sample_size ; ++i)
+        expected.add(this->weight(i));
+
+    {
+        auto weights    = this->iteration();
+        auto partitions = weights.partition(4);
+        ASSERT_EQ(4u, partitions.size());
+
+        /// iterators, a span and an untouched partition, which is reduced on release
+        for (auto it = partitions[0].begin() ; it != partitions[0].end() ; ++it)
+            *it = this->weight(static_cast<std::size_t>(it.state().position(0)));
+        auto span = partitions[1].span();
+        for (std::size_t i = 0 ; i < span.size() ; ++i)
+            span.weight(i) = this->weight(static_cast<std::size_t>(span.state(i).position(0)));
+        for (std::size_t i = 500 ; i < sample_size ; ++i)
+            this->samples.weight(i) = this->weight(i);
+        EXPECT_EQ(1u, this->recorder.touched);
+        EXPECT_EQ(0u, this->recorder.finished);
+    }
+
+    EXPECT_EQ(1u, this->recorder.finished);
+    const muse_smc::WeightDistribution &d = this->recorder.distribution;
+    EXPECT_EQ(expected.getN(), d.getN());
+    EXPECT_NEAR(expected.getSum(),        d.getSum(),        1e-9);
+    EXPECT_NEAR(expected.getSquaredSum(), d.getSquaredSum(), 1e-9);
+    EXPECT_EQ(expected.getMinimum(), d.getMinimum());
+    EXPECT_EQ(expected.getMaximum(), d.getMaximum());
+}
+
+TYPED_TEST(WeightPartition, partitionsAreDisjointAndCovering)
+{
+    {
+        auto weights    = this->iteration();
+        auto partitions = weights.partition(8);
+        std::size_t covered = 0;
+        for (auto &p : partitions) {
+            EXPECT_EQ(static_cast<double>(covered), p.begin().state().position(0));
+            covered += p.size();
+        }
+        EXPECT_EQ(sample_size, covered);
+    }
+
+    /// more partitions than samples are not created
+    this->samples.resize(3);
+    auto small = this->iteration();
+    EXPECT_EQ(3u, small.partition(8).size());
+}
+
+TYPED_TEST(WeightPartition, movedIterationReportsOnce)
+{
+    {
+        auto weights = this->iteration();
+        for (auto it = weights.begin() ; it != weights.end() ; ++it)
+            *it = 2.0;
+        auto moved = std::move(weights);
+        EXPECT_EQ(0u, this->recorder.finished);
+    }
+    EXPECT_EQ(1u, this->recorder.touched);
+    EXPECT_EQ(1u, this->recorder.finished);
+    EXPECT_NEAR(2.0 * sample_size, this->recorder.distribution.getSum(), 1e-9);
+}
+
+TYPED_TEST(WeightPartition, untouchedIterationDoesNotReport)
+{
+    {
+        auto weights = this->iteration();
+        (void) weights.size();
+    }
+    EXPECT_EQ(0u, this->recorder.touched);
+    EXPECT_EQ(0u, this->recorder.finished);
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
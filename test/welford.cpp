@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+
+#include <muse_smc/samples/sample_set.hpp>
+#include <muse_smc/samples/sample_welford.hpp>
+
+#include "reference/density.hpp"
+#include "reference/state_space_description.hpp"
+
+#include <cmath>
+#include <random>
+
+namespace {
+using description_t = muse_smc::reference::StateSpaceDescription<2>;
+using sample_t      = muse_smc::reference::Sample<2>;
+using state_t       = sample_t::state_t;
+using sample_set_t  = muse_smc::SampleSet<description_t>;
+
+struct Position
+{
+    inline Eigen::Vector2d operator()(const state_t &state) const
+    {
+        return state.position;
+    }
+};
+
+using welford_t = muse_smc::WelfordEstimator<sample_t, 2, Position>;
+
+/**
+ * @brief Weighted mean and covariance in two passes.
+ */
+template<typename samples_t>
+inline void moments(const samples_t   &samples,
+                    Eigen::Vector2d   &mean,
+                    Eigen::Matrix2d   &covariance)
+{
+    double weight_sum = 0.0;
+    mean.setZero();
+    for (std::size_t i = 0 ; i < samples.size() ; ++i) {
+        weight_sum += samples.weight(i);
+        mean       += samples.weight(i) * samples.state(i).position;
+    }
+    mean /= weight_sum;
+
+    covariance.setZero();
+    for (std::size_t i = 0 ; i < samples.size() ; ++i) {
+        const Eigen::Vector2d d = samples.state(i).position - mean;
+        covariance += samples.weight(i) * d * d.transpose();
+    }
+    covariance /= weight_sum;
+}
+
+inline sample_t draw(std::mt19937_64 &engine)
+{
+    std::normal_distribution<double>       x(3.0, 2.0);
+    std::normal_distribution<double>       y(-1.0, 0.5);
+    std::uniform_real_distribution<double> w(0.1, 1.0);
+    sample_t sample;
+    sample.state.position = Eigen::Vector2d(x(engine), y(engine));
+    sample.state.position(1) += 0.3 * sample.state.position(0);
+    sample.weight = w(engine);
+    return sample;
+}
+}
+
+TEST(Welford, matchesTwoPassMoments)
+{
+    std::mt19937_64 engine(0);
+    muse_smc::SampleStorageAoS<sample_t> samples(0, 10000);
+    welford_t welford;
+    for (std::size_t i = 0 ; i < 10000 ; ++i) {
+        const sample_t sample = draw(engine);
+        samples.push_back(sample);
+        welford.insert(sample.state, sample.weight);
+    }
+
+    Eigen::Vector2d mean;
+    Eigen::Matrix2d covariance;
+    moments(samples, mean, covariance);
+    EXPECT_EQ(10000u, welford.getN());
+    EXPECT_TRUE(welford.getMean().isApprox(mean, 1e-10));
+    EXPECT_TRUE(welford.getCovariance().isApprox(covariance, 1e-10));
+}
+
+TEST(Welford, ignoresZeroWeightsAndScale)
+{
+    welford_t a;
+    welford_t b;
+    state_t state;
+    for (int i = 0 ; i < 4 ; ++i) {
+        state.position = Eigen::Vector2d(i, 2 * i);
+        a.insert(state, 1.0);
+        b.insert(state, 0.25);
+    }
+    state.position = Eigen::Vector2d(100.0, 100.0);
+    b.insert(state, 0.0);
+
+    EXPECT_EQ(4u, b.getN());
+    EXPECT_TRUE(a.getMean().isApprox(b.getMean()));
+    EXPECT_TRUE(a.getCovariance().isApprox(b.getCovariance()));
+    EXPECT_NEAR(1.5,  a.getMean()(0), 1e-12);
+    EXPECT_NEAR(1.25, a.getCovariance()(0, 0), 1e-12);
+    EXPECT_NEAR(2.5,  a.getCovariance()(0, 1), 1e-12);
+
+    b.clear();
+    EXPECT_EQ(0u, b.getN());
+    EXPECT_TRUE(b.getCovariance().isZero());
+}
+
+TEST(Welford, sampleSetEstimate)
+{
+    std::mt19937_64 engine(1);
+    sample_set_t sample_set("world", cslibs_time::Time(), 5000, std::make_shared<muse_smc::reference::Grid<2>>(0.5), true);
+    welford_t::Ptr welford(new welford_t);
+    sample_set.setEstimator(welford);
+    {
+        auto insertion = sample_set.getInsertion();
+        for (std::size_t i = 0 ; i < 5000 ; ++i)
+            insertion.insert(draw(engine));
+    }
+
+    /// fed during insertion, normalization does not change the moments
+    Eigen::Vector2d mean;
+    Eigen::Matrix2d covariance;
+    moments(sample_set.getSamples(), mean, covariance);
+    EXPECT_TRUE(welford->getMean().isApprox(mean, 1e-10));
+    EXPECT_TRUE(welford->getCovariance().isApprox(covariance, 1e-10));
+
+    /// fed while normalizing after weighting
+    {
+        auto weights = sample_set.getWeightIterator();
+        auto span    = weights.span();
+        for (std::size_t i = 0 ; i < span.size() ; ++i)
+            span.weight(i) *= std::exp(-0.5 * span.state(i).position.squaredNorm());
+    }
+    moments(sample_set.getSamples(), mean, covariance);
+    EXPECT_TRUE(welford->getMean().isApprox(mean, 1e-10));
+    EXPECT_TRUE(welford->getCovariance().isApprox(covariance, 1e-10));
+
+    /// fed while predicting, the fallback does not have to walk the samples
+    {
+        auto states = sample_set.getStateIterator();
+        for (auto &state : states)
+            state.position += Eigen::Vector2d(1.0, -2.0);
+    }
+    moments(sample_set.getSamples(), mean, covariance);
+    EXPECT_TRUE(welford->getMean().isApprox(mean, 1e-10));
+    EXPECT_TRUE(welford->getCovariance().isApprox(covariance, 1e-10));
+}
+
+TEST(Welford, mergeMatchesSequential)
+{
+    std::mt19937_64 engine(2);
+    welford_t sequential;
+    welford_t merged;
+    for (std::size_t p = 0 ; p < 3 ; ++p) {
+        const auto partial = merged.partial();
+        for (std::size_t i = 0 ; i < 1000 * (p + 1) ; ++i) {
+            const sample_t sample = draw(engine);
+            sequential.insert(sample.state, sample.weight);
+            partial->insert(sample.state, sample.weight);
+        }
+        merged.merge(*partial);
+    }
+    merged.merge(*merged.partial());
+
+    EXPECT_EQ(sequential.getN(), merged.getN());
+    EXPECT_TRUE(merged.getMean().isApprox(sequential.getMean(), 1e-10));
+    EXPECT_TRUE(merged.getCovariance().isApprox(sequential.getCovariance(), 1e-10));
+}
+
+TEST(Welford, sampleSetEstimatePartitioned)
+{
+    std::mt19937_64 engine(3);
+    sample_set_t sample_set("world", cslibs_time::Time(), 20000, std::make_shared<muse_smc::reference::Grid<2>>(0.5), true);
+    sample_set.setThreadPool(std::make_shared<muse_smc::ThreadPool>(4));
+    welford_t::Ptr welford(new welford_t);
+    sample_set.setEstimator(welford);
+    {
+        auto insertion = sample_set.getInsertion();
+        for (std::size_t i = 0 ; i < 20000 ; ++i)
+            insertion.insert(draw(engine));
+    }
+
+    /// normalized and fed block wise on the pool
+    {
+        auto weights    = sample_set.getWeightIterator();
+        auto partitions = weights.partition(4);
+        weights.getThreadPool()->parallelFor(partitions.size(), [&partitions](const std::size_t p) {
+            for (auto it = partitions[p].begin() ; it != partitions[p].end() ; ++it)
+                *it *= std::exp(-0.5 * it.state().position.squaredNorm());
+        });
+    }
+    Eigen::Vector2d mean;
+    Eigen::Matrix2d covariance;
+    moments(sample_set.getSamples(), mean, covariance);
+    EXPECT_TRUE(welford->getMean().isApprox(mean, 1e-10));
+    EXPECT_TRUE(welford->getCovariance().isApprox(covariance, 1e-10));
+
+    /// each partition feeds its own part
+    {
+        auto states     = sample_set.getStateIterator();
+        auto partitions = states.partition(3000);
+        states.getThreadPool()->parallelFor(partitions.size(), [&partitions](const std::size_t p) {
+            for (auto &state : partitions[p])
+                state.position *= 2.0;
+        });
+    }
+    moments(sample_set.getSamples(), mean, covariance);
+    EXPECT_TRUE(welford->getMean().isApprox(mean, 1e-10));
+    EXPECT_TRUE(welford->getCovariance().isApprox(covariance, 1e-10));
+
+    /// a prediction which skips samples leaves the estimate to the fallback
+    {
+        auto states = sample_set.getStateIterator();
+        auto it     = states.begin();
+        for (std::size_t i = 0 ; i < 10 ; ++i, ++it)
+            (*it).position *= 2.0;
+    }
+    moments(sample_set.getSamples(), mean, covariance);
+    EXPECT_FALSE(welford->getMean().isApprox(mean, 1e-10));
+    sample_set.updateEstimator();
+    EXPECT_TRUE(welford->getMean().isApprox(mean, 1e-10));
+    EXPECT_TRUE(welford->getCovariance().isApprox(covariance, 1e-10));
+}
+
+int main(int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}